@@ -1,35 +1,46 @@
 #pragma once
 
-#include <math.h>
+#include <cmath>
 #include "effect.h"
-#include "../helpers/filtred.h"
+#include "../helpers/blockdsp.h"
+#include "../helpers/halfband.h"
 
 namespace Steinberg::Vst {
 
-class Distortion: public Effect {
+template<typename SampleType>
+class Distortion final: public FrameEffect<Distortion<SampleType>, SampleType> {
 public:
 
-    Distortion()
+    // oversampling: 1, 2 or 4 times the rate, 2 and 4 delay the signal by 15 and 23 frames
+    Distortion(size_t &oversampling)
         : active_(false)
+        , oversampling_(oversampling)
     {}
 
     ~Distortion() override
     {}
 
-    void process(double &outL, double &outR, double &/*speed*/, double &/*tempo*/, double &/*volume*/) override {
+    void process(SampleType &outL, SampleType &outR, double &/*speed*/, double &/*tempo*/, SampleType &/*volume*/) override {
         volume_.append(active_ ? 1. : 0.);
-        if (volume_ > .0001) {
-            if (outL > 0) {
-                outL = outL * (1. - volume_ * .6) + .4 * sqrt(outL) * volume_;
-            } else {
-                outL = outL * (1. - volume_ * .6) - .3 * sqrt(-outL) * volume_;
-            }
-            if (outR > 0) {
-                outR = outR * (1. - volume_ * .6) + .4 * sqrt(outR) * volume_;
-            } else {
-                outR = outR * (1. - volume_ * .6) - .3 * sqrt(-outR) * volume_;
+        if (oversampler_.factor() == 1) {
+            if (volume_ > .0001) {
+                outL = shape(outL, volume_);
+                outR = shape(outR, volume_);
             }
+            return;
         }
+        // past 1x the filters run all the time, their delay must not come and go with the effect
+        SampleType volume = volume_;
+        oversampler_.process(outL, outR, [volume](SampleType &left, SampleType &right) {
+            left = shape(left, volume);
+            right = shape(right, volume);
+        });
+    }
+
+    void processBlock(EffectFrames<SampleType> &frames) override {
+        // the factor only changes between blocks
+        oversampler_.factor(oversampling_);
+        FrameEffect<Distortion, SampleType>::processBlock(frames);
     }
 
     void activate() override {
@@ -40,14 +51,28 @@ public:
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    bool idle() const noexcept override {
+        return !active_ && (volume_ <= .0001) && (oversampling_ <= 1);
+    }
+
+    Effect::Type type() const noexcept override {
         return Effect::Distorsion;
     }
 
 private:
 
-    Filtred<float, 8> volume_;
+    // the square root bend, a little softer below zero
+    static SampleType shape(SampleType x, SampleType volume) {
+        if (x > 0) {
+            return x * (SampleType(1) - volume * SampleType(.6)) + SampleType(.4) * std::sqrt(x) * volume;
+        }
+        return x * (SampleType(1) - volume * SampleType(.6)) - SampleType(.3) * std::sqrt(-x) * volume;
+    }
+
+    Smoother<float, 8> volume_;
     bool active_;
+    size_t &oversampling_;
+    Oversampler<SampleType> oversampler_;
 };
 
 }
@@ -1,7 +1,24 @@
 #pragma once
 
+#include <cstddef>
+#include <type_traits>
+
 namespace Steinberg::Vst {
 
+// frames handed to an effect at once, speed, tempo and volume are per frame. The audio and
+// its volume come in the deck's sample type, speed and tempo drive cursors and stay double
+template<typename SampleType>
+struct EffectFrames {
+    SampleType* left;
+    SampleType* right;
+    double* speed;
+    double* tempo;
+    SampleType* volume;
+    size_t count;
+};
+
+// what the chain knows of every effect, whatever sample type it runs at
+
 class Effect {
 public:
 
@@ -18,12 +35,47 @@ public:
         LockTone		= 1 << 8
     };
 
+    // effects reading or moving the deck cursor take turns with each other frame by frame,
+    // the rest may run over a whole block
+    static constexpr bool PerFrame = false;
+
     virtual ~Effect() = default;
 
-    virtual void process(double &left, double &right, double &speed, double &tempo, double &volume) = 0;
     virtual void activate() = 0;
     virtual void disactivate() = 0;
     virtual Type type() const noexcept = 0;
+
+    // inactive and faded out, the chain skips it until it is activated again
+    virtual bool idle() const noexcept {
+        return false;
+    }
+};
+
+template<typename SampleType>
+class SampleEffect: public Effect {
+public:
+
+    using Sample = SampleType;
+
+    virtual void process(SampleType &left, SampleType &right, double &speed, double &tempo, SampleType &volume) = 0;
+    virtual void processBlock(EffectFrames<SampleType> &frames) = 0;
+};
+
+// the sample entry a getter hands out, effects reading it run at its sample type
+template<typename SampleGetter>
+using EntryOf = std::remove_pointer_t<std::invoke_result_t<SampleGetter&>>;
+
+// block call for effects written frame by frame, final effects get the frame calls bound statically
+template<typename Derived, typename SampleType>
+class FrameEffect: public SampleEffect<SampleType> {
+public:
+
+    void processBlock(EffectFrames<SampleType> &frames) override {
+        auto& self = static_cast<Derived&>(*this);
+        for (size_t i = 0; i < frames.count; i++) {
+            self.process(frames.left[i], frames.right[i], frames.speed[i], frames.tempo[i], frames.volume[i]);
+        }
+    }
 };
 
 }
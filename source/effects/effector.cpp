@@ -2,24 +2,23 @@
 
 namespace Steinberg::Vst {
 
-void Effector::process(double &left, double &right, double &speed, double &tempo, double &volume) {
-    for (auto& effect : effects_) {
-        effect->process(left, right, speed, tempo, volume);
+template<typename SampleType>
+void Effector<SampleType>::process(EffectFrames<SampleType> &frames) {
+    if (pending_) {
+        activeSet(scheduled_);
+        pending_ = false;
     }
+    processFrames(frames);
 }
 
-void Effector::activeSet(Effect::Type active) {
-
-    for (auto& effect : effects_) {
-        if ((effect->type() & activeSet_) && (effect->type() & active) == 0) {
-            effect->disactivate();
-        }
-        if ((effect->type() & activeSet_) == 0 && (effect->type() & active)) {
-            effect->activate();
-        }
-    }
-    activeSet_ = active;
+template<typename SampleType>
+void Effector<SampleType>::schedule(Effect::Type active) {
+    scheduled_ = active;
+    pending_ = true;
 }
 
+// the deck runs in float or in double, vinylconfigconst.h picks which
+template class Effector<float>;
+template class Effector<double>;
 
 }
@@ -2,32 +2,152 @@
 
 #include "effect.h"
 
-#include <vector>
+#include <tuple>
+#include <type_traits>
 #include <memory>
+#include <utility>
+#include <inttypes.h>
 
 namespace Steinberg::Vst {
 
-
+// runs the effects at SampleType, the chain is built once by makeEffector
+template<typename SampleType>
 class Effector {
 public:
 
-    Effector(std::vector<std::unique_ptr<Effect>> &&effects = {})
-        : effects_(std::move(effects))
-        , activeSet_(Effect::NoEffects)
+    Effector()
+        : scheduled_(Effect::NoEffects)
+        , pending_(false)
     {}
 
-    void process(double &left, double &right, double &speed, double &tempo, double &volume);
+    virtual ~Effector() = default;
+
+    // runs the frames, a scheduled set is switched to before the first of them
+    void process(EffectFrames<SampleType> &frames);
+
+    /**
+     *  Switches to the active set when the next process call starts, the latest schedule wins.
+     *  The processor cuts its blocks where events fall, so that is the frame the change came on.
+     **/
+    void schedule(Effect::Type active);
+
+    virtual void activeSet(Effect::Type active) = 0;
+
+protected:
+
+    virtual void processFrames(EffectFrames<SampleType> &frames) = 0;
+
+private:
+
+    Effect::Type scheduled_;
+    bool pending_;
+};
+
+/**
+ *  The effects in a fixed order, known at compile time so the calls are not dispatched per frame.
+ *  Effects that went idle are left out of the running mask for the whole block.
+ **/
+template<typename SampleType, typename... Effects>
+class EffectChain final: public Effector<SampleType> {
+public:
+
+    static_assert(sizeof...(Effects) <= 32, "running mask holds 32 effects");
+
+    explicit EffectChain(Effects*... effects)
+        : effects_(std::unique_ptr<Effects>(effects)...)
+        , activeSet_(Effect::NoEffects)
+        , running_(0)
+    {
+        static_assert(perFrameFirst(), "effects sharing the deck cursor go first");
+        static_assert((std::is_same_v<typename Effects::Sample, SampleType> && ...), "the effects run at the chain's sample type");
+    }
+
+protected:
+
+    void processFrames(EffectFrames<SampleType> &frames) override {
+        running_ = runningMask(Indices());
+        for (size_t i = 0; i < frames.count; i++) {
+            processFrame(frames, i, Indices());
+        }
+        processBlocks(frames, Indices());
+    }
+
+public:
 
-    void activeSet(Effect::Type active);
+    void activeSet(Effect::Type active) override {
+        std::apply([&](auto&... effect) { (switchEffect(*effect, active), ...); }, effects_);
+        activeSet_ = active;
+    }
 
-    void append(std::unique_ptr<Effect> &&effect) {
-        effects_.emplace_back(std::move(effect));
+    uint32_t running() const {
+        return running_;
     }
 
 private:
 
-    std::vector<std::unique_ptr<Effect>> effects_;
+    using Indices = std::index_sequence_for<Effects...>;
+
+    static constexpr bool perFrameFirst() {
+        constexpr bool perFrame[] = {Effects::PerFrame...};
+        for (size_t i = 1; i < sizeof...(Effects); i++) {
+            if (perFrame[i] && !perFrame[i - 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<size_t... I>
+    uint32_t runningMask(std::index_sequence<I...>) const {
+        return ((std::get<I>(effects_)->idle() ? 0u : (1u << I)) | ... | 0u);
+    }
+
+    template<size_t... I>
+    void processFrame(EffectFrames<SampleType> &frames, size_t i, std::index_sequence<I...>) {
+        (processFrame<I>(frames, i), ...);
+    }
+
+    template<size_t I>
+    void processFrame(EffectFrames<SampleType> &frames, size_t i) {
+        if constexpr (std::tuple_element_t<I, std::tuple<Effects...>>::PerFrame) {
+            if (running_ & (1u << I)) {
+                std::get<I>(effects_)->process(frames.left[i], frames.right[i], frames.speed[i], frames.tempo[i], frames.volume[i]);
+            }
+        }
+    }
+
+    template<size_t... I>
+    void processBlocks(EffectFrames<SampleType> &frames, std::index_sequence<I...>) {
+        (processBlock<I>(frames), ...);
+    }
+
+    template<size_t I>
+    void processBlock(EffectFrames<SampleType> &frames) {
+        if constexpr (!std::tuple_element_t<I, std::tuple<Effects...>>::PerFrame) {
+            if (running_ & (1u << I)) {
+                std::get<I>(effects_)->processBlock(frames);
+            }
+        }
+    }
+
+    void switchEffect(Effect &effect, Effect::Type active) {
+        if ((effect.type() & activeSet_) && (effect.type() & active) == 0) {
+            effect.disactivate();
+        }
+        if ((effect.type() & activeSet_) == 0 && (effect.type() & active)) {
+            effect.activate();
+        }
+    }
+
+    std::tuple<std::unique_ptr<Effects>...> effects_;
     Effect::Type activeSet_;
+    uint32_t running_;
 };
 
+// takes over effects made with new, in the order they process
+template<typename SampleType, typename... Effects>
+std::unique_ptr<Effector<SampleType>> makeEffector(Effects*... effects) {
+    return std::make_unique<EffectChain<SampleType, Effects...>>(effects...);
+}
+
 }
@@ -2,15 +2,19 @@
 
 #include <math.h>
 #include "effect.h"
-#include "../helpers/filtred.h"
+#include "../helpers/blockdsp.h"
 #include "../helpers/sampleentry.h"
 
 namespace Steinberg::Vst {
 
 template<typename SampleGetter>
-class Freeze: public Effect {
+class Freeze final: public FrameEffect<Freeze<SampleGetter>, typename EntryOf<SampleGetter>::Type> {
 public:
 
+    using SampleType = typename EntryOf<SampleGetter>::Type;
+
+    static constexpr bool PerFrame = true;
+
     Freeze(double &sampleRate, size_t &noteLength, SampleGetter &&sampler)
         : active_(false)
         , sampler_(std::forward<SampleGetter>(sampler))
@@ -23,68 +27,61 @@ public:
     ~Freeze() override
     {};
 
-    void process(double &outL, double &outR, double &speed, double &tempo, double &volume) override {
+    void process(SampleType &outL, SampleType &outR, double &speed, double &tempo, SampleType &volume) override {
         volume_.append(active_ ? 1. : 0.);
         if (active_) {
             freezeCounter_++;
             auto sample = sampler_();
-            bool pushSync = sample->Sync;
-            sample->Sync = false;
-            const auto& PushCue = sample->cue();
-            sample->cue(freezeCue_);
-            sample->playStereoSample(&outL,
-                &outR,
-                speed,
-                tempo,
-                sampleRate_,
-                true);
-            freezeCue_ = sample->cue();
-            if ((volume_ > 0.00001) && (volume_ < 0.99)) {
-                double left = 0;
-                double right = 0;
-                sample->cue(endFreezeCue_);
-                sample->playStereoSample(&left,
-                    &right,
-                    speed,
-                    tempo,
-                    sampleRate_,
-                    true);
-                outL = outL * volume_ + left * (1. - volume_);
-                outR = outR * volume_ + right * (1. - volume_);
-                endFreezeCue_ = sample->cue();
+
+            // the frozen loop and the tail of the previous pass, the deck keeps going underneath
+            bool fading = (volume_ > 0.00001) && (volume_ < 0.99);
+            Voice* voices[2] = {&freeze_, &endFreeze_};
+            SampleType left[2] = {0, 0};
+            SampleType right[2] = {0, 0};
+            sample->playVoices(voices, fading ? 2 : 1, left, right, speed, tempo, sampleRate_, false);
+            outL = left[0];
+            outR = right[0];
+            if (fading) {
+                outL = outL * volume_ + left[1] * (SampleType(1) - volume_);
+                outR = outR * volume_ + right[1] * (SampleType(1) - volume_);
             }
 
             if (speed != 0.0) {
                 if (freezeCounter_ >= noteLength_) {
                     freezeCounter_ = 0;
-                    endFreezeCue_ = freezeCue_;
-                    freezeCue_ = beginFreezeCue_;
+                    endFreeze_ = freeze_;
+                    freeze_ = beginFreeze_;
                     volume_ = 0;
                 }
             }
-            sample->Sync = pushSync;
-            sample->cue(PushCue);
         }
     }
 
     void activate() override {
         active_ = true;
-        beginFreezeCue_ = sampler_()->cue();
-        freezeCue_ = beginFreezeCue_;
+        auto sample = sampler_();
+        beginFreeze_ = sample->voiceAt(sample->beatCue(sample->cue(), double(noteLength_) * fabs(sample->realSpeed(1., sampleRate_))));
+        freeze_ = beginFreeze_;
     }
 
     void disactivate() override {
         active_ = false;
-        endFreezeCue_ = freezeCue_;
+        endFreeze_ = freeze_;
     }
 
-    Type type() const noexcept override {
+    bool idle() const noexcept override {
+        return !active_ && (volume_ <= 0.00001);
+    }
+
+    Effect::Type type() const noexcept override {
         return Effect::Freeze;
     }
 
 private:
 
-    Filtred<float, 8> volume_;
+    using Voice = typename EntryOf<SampleGetter>::Voice;
+
+    Smoother<float, 8> volume_;
     bool active_;
 
     SampleGetter sampler_;
@@ -93,9 +90,9 @@ private:
     size_t &noteLength_;
 
     size_t freezeCounter_;
-    SampleEntry<double>::CuePoint beginFreezeCue_;
-    SampleEntry<double>::CuePoint endFreezeCue_;
-    SampleEntry<double>::CuePoint freezeCue_;
+    Voice beginFreeze_;
+    Voice endFreeze_;
+    Voice freeze_;
 
 
 };
@@ -2,15 +2,19 @@
 
 #include <math.h>
 #include "effect.h"
-#include "../helpers/filtred.h"
+#include "../helpers/blockdsp.h"
 #include "../helpers/sampleentry.h"
 
 namespace Steinberg::Vst {
 
 template<typename SampleGetter>
-class Hold: public Effect {
+class Hold final: public FrameEffect<Hold<SampleGetter>, typename EntryOf<SampleGetter>::Type> {
 public:
 
+    using SampleType = typename EntryOf<SampleGetter>::Type;
+
+    static constexpr bool PerFrame = true;
+
     Hold(double &sampleRate, size_t &noteLength, SampleGetter &&sampler)
         : active_(false)
         , sampler_(std::forward<SampleGetter>(sampler))
@@ -23,30 +27,28 @@ public:
     ~Hold() override
     {};
 
-    void process(double &outL, double &outR, double &speed, double &tempo, double &/*volume*/) override {
+    void process(SampleType &outL, SampleType &outR, double &speed, double &tempo, SampleType &/*volume*/) override {
         volume_.append(active_ ? 1. : 0.);
         if (active_) {
             holdCounter_++;
             auto samplePtr = sampler_();
             if ((volume_ > 0.00001) && (volume_ < 0.99)) {
-                double left = 0;
-                double right = 0;
-                const auto& PushCue = samplePtr->cue();
-                samplePtr->cue(endHoldCue_);
-                samplePtr->playStereoSample(&left,
+                SampleType left = 0;
+                SampleType right = 0;
+                samplePtr->playStereoSample(endHold_,
+                    &left,
                     &right,
                     speed,
                     samplePtr->tempo(),
                     sampleRate_,
                     true);
-                outL = outL * volume_ + left * (1. - volume_);
-                outR = outR * volume_ + right * (1. - volume_);
-                endHoldCue_ = samplePtr->cue();
-                samplePtr->cue(PushCue);
+                outL = outL * volume_ + left * (SampleType(1) - volume_);
+                outR = outR * volume_ + right * (SampleType(1) - volume_);
             }
 
             if (holdCounter_ >= noteLength_) {
-                endHoldCue_ = samplePtr->cue();
+                // the deck jumps back, what it was playing fades out on its own voice
+                endHold_ = samplePtr->voice();
                 samplePtr->cue(holdCue_);
                 holdCounter_ = 0;
                 volume_ = 0;
@@ -56,27 +58,32 @@ public:
 
     void activate() override {
         active_ = true;
-        holdCue_ = sampler_()->cue();
+        auto samplePtr = sampler_();
+        holdCue_ = samplePtr->beatCue(samplePtr->cue(), double(noteLength_) * fabs(samplePtr->realSpeed(1., sampleRate_)));
     }
 
     void disactivate() override {
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    bool idle() const noexcept override {
+        return !active_ && (volume_ <= 0.00001);
+    }
+
+    Effect::Type type() const noexcept override {
         return Effect::Hold;
     }
 
 private:
 
-    Filtred<float, 8> volume_;
+    Smoother<float, 8> volume_;
     bool active_;
     SampleGetter sampler_;
     double &sampleRate_;
     size_t &noteLength_;
     size_t holdCounter_;
-    SampleEntry<double>::CuePoint holdCue_;
-    SampleEntry<double>::CuePoint endHoldCue_;
+    typename EntryOf<SampleGetter>::CuePoint holdCue_;
+    typename EntryOf<SampleGetter>::Voice endHold_;
 
 
 };
@@ -2,16 +2,22 @@
 
 #include <math.h>
 #include "effect.h"
-#include "../helpers/filtred.h"
+#include "../helpers/blockdsp.h"
 #include "../helpers/sampleentry.h"
+#include "../helpers/timestretch.h"
 
 namespace Steinberg::Vst {
 
 template<typename SampleGetter>
-class Lock: public Effect {
+class Lock final: public FrameEffect<Lock<SampleGetter>, typename EntryOf<SampleGetter>::Type> {
 public:
 
-    Lock(double &sampleRate, SampleGetter &&sampler)
+    using SampleType = typename EntryOf<SampleGetter>::Type;
+    using Voice = typename EntryOf<SampleGetter>::Voice;
+
+    static constexpr bool PerFrame = true;
+
+    Lock(double &sampleRate, SampleGetter &&sampler, StretchMode mode = StretchMode::Wsola)
         : active_(false)
         , init_(false)
         , sampleRate_(sampleRate)
@@ -19,13 +25,16 @@ public:
         , lockSpeed_(0)
         , lockVolume_(0)
         , lockTune_(0)
+        , source_(nullptr)
+        , voice_()
+        , stretch_(sampleRate, mode)
     {
     }
 
     ~Lock() override
     {};
 
-    void process(double &outL, double &outR, double &speed, double &tempo, double &volume) override {
+    void process(SampleType &outL, SampleType &outR, double &speed, double &tempo, SampleType &volume) override {
 
         auto sample = sampler_();
 
@@ -34,24 +43,32 @@ public:
                 lockSpeed_ = fabs(speed);
                 lockVolume_ = volume;
                 lockTune_ = sample->Tune;
-                sample->beginLockStrobe();
                 init_ = true;
             }
             else {
                 volume = lockVolume_;
             }
+            stretch_.setup(sampleRate_);
+            if (sample != source_) {
+                stretch_.reset(sample->position());
+                // the grains take over the deck's stream fade and keep their own from there
+                voice_ = sample->voice();
+                source_ = sample;
+            }
             tempo = sample->Sync
                 ? fabs(tempo * speed)
                 : sample->tempo() * fabs(speed) * lockTune_;
 
             speed = (speed >= 0.) ? lockSpeed_ : -lockSpeed_;
 
-            sample->playStereoSampleTempo(&outL,
-                &outR,
-                speed,
-                tempo,
-                sampleRate_,
-                true);
+            // the position follows the deck, the grains keep the pitch it had when locked
+            stretch_.process(*sample,
+                voice_,
+                sample->tempoSpeed(speed, tempo, sampleRate_),
+                sample->realSpeed(speed, sampleRate_),
+                outL,
+                outR);
+            sample->seek(stretch_.position());
         } else {
 
             sample->playStereoSample(&outL,
@@ -67,13 +84,14 @@ public:
     void activate() override {
         active_ = true;
         init_ = false;
+        source_ = nullptr;
     }
 
     void disactivate() override {
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    Effect::Type type() const noexcept override {
         return Effect::LockTone;
     }
 
@@ -88,6 +106,10 @@ private:
     double lockSpeed_;
     double lockVolume_;
     double lockTune_;
+
+    const void* source_;
+    Voice voice_;
+    TimeStretch<SampleType> stretch_;
 };
 
 }
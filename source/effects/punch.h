@@ -1,15 +1,19 @@
 #pragma once
 
 #include <math.h>
+#include <type_traits>
 #include "effect.h"
-#include "../helpers/filtred.h"
+#include "../helpers/blockdsp.h"
 
 namespace Steinberg::Vst {
 
+// the level to punch in at comes from maxValue, the effect runs at the type it returns
 template<typename MaxValue>
-class PunchIn: public Effect {
+class PunchIn final: public FrameEffect<PunchIn<MaxValue>, std::invoke_result_t<MaxValue&>> {
 public:
 
+    using SampleType = std::invoke_result_t<MaxValue&>;
+
     PunchIn(MaxValue &&maxValue)
         : active_(false)
         , maxValue_(std::forward<MaxValue>(maxValue))
@@ -18,7 +22,7 @@ public:
     ~PunchIn() override
     {}
 
-    void process(double &/*outL*/, double &/*outR*/, double &/*speed*/, double &/*tempo*/, double &volume) override {
+    void process(SampleType &/*outL*/, SampleType &/*outR*/, double &/*speed*/, double &/*tempo*/, SampleType &volume) override {
         volume_.append(active_ ? maxValue_() : volume);
         volume = volume_;
     }
@@ -31,18 +35,19 @@ public:
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    Effect::Type type() const noexcept override {
         return Effect::PunchIn;
     }
 
 private:
 
-    Filtred<float, 8> volume_;
+    Smoother<float, 8> volume_;
     bool active_;
     MaxValue maxValue_;
 };
 
-class PunchOut: public Effect {
+template<typename SampleType>
+class PunchOut final: public FrameEffect<PunchOut<SampleType>, SampleType> {
 public:
 
     PunchOut()
@@ -52,7 +57,7 @@ public:
     ~PunchOut() override
     {}
 
-    void process(double &/*outL*/, double &/*outR*/, double &/*speed*/, double &/*tempo*/, double &volume) override {
+    void process(SampleType &/*outL*/, SampleType &/*outR*/, double &/*speed*/, double &/*tempo*/, SampleType &volume) override {
         volume_.append(active_ ? 0. : 1.);
         volume *= volume_;
     }
@@ -65,13 +70,18 @@ public:
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    // fully open again, multiplying by it changes nothing
+    bool idle() const noexcept override {
+        return !active_ && (volume_ >= 0.99999);
+    }
+
+    Effect::Type type() const noexcept override {
         return Effect::PunchOut;
     }
 
 private:
 
-    Filtred<float, 8> volume_;
+    Smoother<float, 8> volume_;
     bool active_;
 };
 
@@ -2,15 +2,34 @@
 
 #include <math.h>
 #include "effect.h"
-#include "../helpers/filtred.h"
+#include "../helpers/blockdsp.h"
 #include "../helpers/sampleentry.h"
 
 namespace Steinberg::Vst {
 
+/**
+ *  Each roll tap goes in on top of the earlier ones and takes a tenth off them,
+ *  folded into one gain per tap. Returns what is left of the dry signal.
+ **/
+template<typename SampleType, size_t Count>
+SampleType rollGains(SampleType volume, SampleType (&gains)[Count]) {
+    SampleType fade = SampleType(1) - volume * SampleType(.1);
+    SampleType weight = volume;
+    for (size_t i = Count; i-- > 0;) {
+        gains[i] = (SampleType(1) - SampleType(i) / SampleType(Count)) * SampleType(.6) * weight;
+        weight *= fade;
+    }
+    return weight / volume;
+}
+
 template<typename SampleGetter>
-class PreRoll: public Effect {
+class PreRoll final: public FrameEffect<PreRoll<SampleGetter>, typename EntryOf<SampleGetter>::Type> {
 public:
 
+    using SampleType = typename EntryOf<SampleGetter>::Type;
+
+    static constexpr bool PerFrame = true;
+
     PreRoll(SampleGetter &&sampler)
         : active_(false)
         , sampler_(std::forward<SampleGetter>(sampler))
@@ -20,23 +39,19 @@ public:
     ~PreRoll() override
     {};
 
-    void process(double &outL, double &outR, double &speed, double &tempo, double &/*volume*/) override {
+    void process(SampleType &outL, SampleType &outR, double &speed, double &tempo, SampleType &/*volume*/) override {
         volume_.append(active_ ? 1. : 0.);
-
-        auto sample = sampler_();
-        double offset = sample->noteLength(rollNote_, tempo);
-        double pre_offset = -offset;
-
-        double left = 0;
-        double right = 0;
-        for (size_t i = 0; i < rollCount_; i++) {
-            double rollVolume = (1. - double(i) / double(rollCount_)) * .6;
-            if (volume_ > 0.0001) {
-                sample->playStereoSample(&left, &right, pre_offset, false);
-                outL = outL * (1. - volume_ * .1) + left * rollVolume * volume_;
-                outR = outR * (1. - volume_ * .1) + right * rollVolume * volume_;
-                pre_offset = pre_offset + offset;
-            }
+        if (volume_ > 0.0001) {
+            auto sample = sampler_();
+            double offset = sample->noteLength(rollNote_, tempo);
+
+            SampleType gains[rollCount_];
+            SampleType keep = rollGains(SampleType(volume_), gains);
+            SampleType left = 0;
+            SampleType right = 0;
+            sample->renderTaps(-offset, offset, rollCount_, gains, &left, &right);
+            outL = outL * keep + left;
+            outR = outR * keep + right;
         }
     }
 
@@ -48,7 +63,11 @@ public:
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    bool idle() const noexcept override {
+        return !active_ && (volume_ <= 0.0001);
+    }
+
+    Effect::Type type() const noexcept override {
         return Effect::PreRoll;
     }
 
@@ -57,16 +76,20 @@ private:
     static constexpr double rollNote_ {1./32.};
     static constexpr size_t rollCount_ {8};
 
-    Filtred<float, 8> volume_;
+    Smoother<float, 8> volume_;
     bool active_;
 
     SampleGetter sampler_;
 };
 
 template<typename SampleGetter>
-class PostRoll: public Effect {
+class PostRoll final: public FrameEffect<PostRoll<SampleGetter>, typename EntryOf<SampleGetter>::Type> {
 public:
 
+    using SampleType = typename EntryOf<SampleGetter>::Type;
+
+    static constexpr bool PerFrame = true;
+
     PostRoll(SampleGetter &&sampler)
         : active_(false)
         , sampler_(std::forward<SampleGetter>(sampler))
@@ -76,23 +99,19 @@ public:
     ~PostRoll() override
     {};
 
-    void process(double &outL, double &outR, double &speed, double &tempo, double &/*volume*/) override {
+    void process(SampleType &outL, SampleType &outR, double &speed, double &tempo, SampleType &/*volume*/) override {
         volume_.append(active_ ? 1. : 0.);
-
-        auto sample = sampler_();
-        double offset = sample->noteLength(rollNote_, tempo);
-        double pos_offset = offset;
-
-        double left = 0;
-        double right = 0;
-        for (size_t i = 0; i < rollCount_; i++) {
-            double rollVolume = (1. - double(i) / double(rollCount_)) * .6;
-            if (volume_ > 0.0001) {
-                sample->playStereoSample(&left, &right, pos_offset, false);
-                outL = outL * (1. - volume_ * .1) + left * rollVolume * volume_;
-                outR = outR * (1. - volume_ * .1) + right * rollVolume * volume_;
-                pos_offset = pos_offset - offset;
-            }
+        if (volume_ > 0.0001) {
+            auto sample = sampler_();
+            double offset = sample->noteLength(rollNote_, tempo);
+
+            SampleType gains[rollCount_];
+            SampleType keep = rollGains(SampleType(volume_), gains);
+            SampleType left = 0;
+            SampleType right = 0;
+            sample->renderTaps(offset, -offset, rollCount_, gains, &left, &right);
+            outL = outL * keep + left;
+            outR = outR * keep + right;
         }
     }
 
@@ -104,7 +123,11 @@ public:
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    bool idle() const noexcept override {
+        return !active_ && (volume_ <= 0.0001);
+    }
+
+    Effect::Type type() const noexcept override {
         return Effect::PostRoll;
     }
 
@@ -113,7 +136,7 @@ private:
     static constexpr double rollNote_ {1./32.};
     static constexpr size_t rollCount_ {8};
 
-    Filtred<float, 8> volume_;
+    Smoother<float, 8> volume_;
     bool active_;
 
     SampleGetter sampler_;
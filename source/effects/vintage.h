@@ -1,39 +1,84 @@
 #pragma once
 
 #include <math.h>
+#include <memory>
+#include <algorithm>
 #include "effect.h"
-#include "../helpers/filtred.h"
+#include "../helpers/blockdsp.h"
+#include "../helpers/crackle.h"
 #include "../helpers/sampleentry.h"
 #include "../helpers/resourcepath.h"
 
 namespace Steinberg::Vst {
 
-class Vintage: public Effect {
+enum class VintageSource {
+    Generated = 0,  // crackle, hiss and rumble made up as it plays, nothing is loaded
+    Sampled         // vintage.wav looped at the platter speed
+};
+
+template<typename SampleType>
+class Vintage final: public FrameEffect<Vintage<SampleType>, SampleType> {
 public:
 
-    Vintage(double &sampleRate)
+    Vintage(double &sampleRate, VintageSource source = VintageSource::Generated)
         : active_(false)
-        , vintageSample_("vintage", (getResourcePath() + "\\vintage.wav").c_str())
         , sampleRate_(sampleRate)
+        , crackle_(uint32_t(reinterpret_cast<uintptr_t>(this) >> 4))
     {
-        vintageSample_.Loop = true;
-        vintageSample_.Sync = false;
-        vintageSample_.Reverse = false;
+        if (source == VintageSource::Sampled) {
+            vintageSample_ = std::make_unique<SampleEntry<SampleType>>("vintage", (getResourcePath() + "\\vintage.wav").c_str());
+            vintageSample_->Loop = true;
+            vintageSample_->Sync = false;
+            vintageSample_->Reverse = false;
+        }
     }
 
     ~Vintage() override
     {};
 
-    void process(double &outL, double &outR, double &speed, double &tempo, double &/*volume*/) override {
+    void process(SampleType &outL, SampleType &outR, double &speed, double &tempo, SampleType &/*volume*/) override {
         volume_.append(active_ ? 1. : 0.);
         if (volume_ > .0001) {
-            double VintageLeft = 0;
-            double VintageRight = 0;
+            SampleType VintageLeft = 0;
+            SampleType VintageRight = 0;
 
-            vintageSample_.playStereoSample(&VintageLeft, &VintageRight, speed, tempo, sampleRate_, true);
+            vintageSample_->playStereoSample(&VintageLeft, &VintageRight, speed, tempo, sampleRate_, true);
 
-            outL = outL * (1. - volume_ * .3) + (-pow(outR * .5, 2) + VintageLeft) * volume_;
-            outR = outR * (1. - volume_ * .3) + (-pow(outL * .5, 2) + VintageRight) * volume_;
+            mix(outL, outR, VintageLeft, VintageRight, volume_);
+        } else if (!dcLeft_.settled() || !dcRight_.settled()) {
+            mix(outL, outR, 0, 0, 0);
+        }
+    }
+
+    void processBlock(EffectFrames<SampleType> &frames) override {
+        dcLeft_.sampleRate(sampleRate_);
+        dcRight_.sampleRate(sampleRate_);
+        if (vintageSample_) {
+            FrameEffect<Vintage, SampleType>::processBlock(frames);
+            return;
+        }
+        crackle_.sampleRate(sampleRate_);
+        SampleType noiseL[BlockFrames];
+        SampleType noiseR[BlockFrames];
+        for (size_t done = 0; done < frames.count; done += BlockFrames) {
+            size_t count = std::min(BlockFrames, frames.count - done);
+            crackle_.process(noiseL, noiseR, frames.speed + done, count);
+            SampleType* left = frames.left + done;
+            SampleType* right = frames.right + done;
+
+            // once the fade has settled the volume is constant, faded out only the DC blockers
+            // may still have a tail to let out
+            float target = active_ ? 1.f : 0.f;
+            float volumes[BlockFrames];
+            if (volume_.settled(target)) {
+                if ((target <= .0001) && dcLeft_.settled() && dcRight_.settled()) {
+                    continue;
+                }
+                std::fill(volumes, volumes + count, target);
+            } else {
+                volume_.glide(target, volumes, count);
+            }
+            mix(left, right, noiseL, noiseR, volumes, count);
         }
     }
 
@@ -45,16 +90,52 @@ public:
         active_ = false;
     }
 
-    Type type() const noexcept override {
+    bool idle() const noexcept override {
+        return !active_ && (volume_ <= .0001) && dcLeft_.settled() && dcRight_.settled();
+    }
+
+    Effect::Type type() const noexcept override {
         return Effect::Vintage;
     }
 
 private:
 
-    Filtred<float, 8> volume_;
+    static constexpr size_t BlockFrames = CrackleGenerator<SampleType>::MaximumFrames;
+
+    // a touch of the other channel squared goes in with the noise, as a worn groove does.
+    // The square only ever pulls down, its DC is blocked before it reaches the output
+    void mix(SampleType &outL, SampleType &outR, SampleType noiseL, SampleType noiseR, SampleType volume) {
+        volume = volume > SampleType(.0001) ? volume : SampleType(0);
+        outL = outL * (1 - volume * SampleType(.3)) + dcLeft_.process((-(outR * SampleType(.5)) * (outR * SampleType(.5)) + noiseL) * volume);
+        outR = outR * (1 - volume * SampleType(.3)) + dcRight_.process((-(outL * SampleType(.5)) * (outL * SampleType(.5)) + noiseR) * volume);
+    }
+
+    // the same over a block, the noise buffers take the wet signal of each channel in turn
+    void mix(SampleType* left, SampleType* right, SampleType* noiseL, SampleType* noiseR, const float* volumes, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            SampleType volume = volumes[i] > .0001f ? volumes[i] : 0.f;
+            noiseL[i] = (-(right[i] * SampleType(.5)) * (right[i] * SampleType(.5)) + noiseL[i]) * volume;
+        }
+        dcLeft_.process(noiseL, noiseL, count);
+        for (size_t i = 0; i < count; i++) {
+            SampleType volume = volumes[i] > .0001f ? volumes[i] : 0.f;
+            left[i] = left[i] * (1 - volume * SampleType(.3)) + noiseL[i];
+            noiseR[i] = (-(left[i] * SampleType(.5)) * (left[i] * SampleType(.5)) + noiseR[i]) * volume;
+        }
+        dcRight_.process(noiseR, noiseR, count);
+        for (size_t i = 0; i < count; i++) {
+            SampleType volume = volumes[i] > .0001f ? volumes[i] : 0.f;
+            right[i] = right[i] * (1 - volume * SampleType(.3)) + noiseR[i];
+        }
+    }
+
+    Smoother<float, 8> volume_;
     bool active_;
-    SampleEntry<double> vintageSample_;
+    std::unique_ptr<SampleEntry<SampleType>> vintageSample_;
     double &sampleRate_;
+    CrackleGenerator<SampleType> crackle_;
+    DcBlocker<SampleType> dcLeft_;
+    DcBlocker<SampleType> dcRight_;
 };
 
 }
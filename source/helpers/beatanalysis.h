@@ -0,0 +1,409 @@
+#pragma once
+
+#include "blockdsp.h"
+#include "fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+// what the analysis found out about a sample, positions in its own frames
+struct SampleAnalysis {
+    double tempo {0};          // beats per minute, 0 - no steady beat
+    double firstBeat {0};      // frame of the first beat
+    double beatLength {0};     // frames per beat
+    size_t beats {0};          // beats the grid spans, 0 - no grid
+    double loudness {-70.};    // integrated, LUFS (BS.1770), -70 - silent
+
+    bool valid() const {
+        return beats > 0;
+    }
+
+    // the same sample converted to another rate
+    SampleAnalysis scaled(double ratio) const {
+        SampleAnalysis result(*this);
+        result.firstBeat *= ratio;
+        result.beatLength *= ratio;
+        return result;
+    }
+};
+
+/**
+ *  Finds the tempo, beat grid and loudness of a sample fed one frame at a time.
+ *  Onsets are the spectral flux of ~20 ms frames; the beat period is picked
+ *  from their autocorrelation around 120 BPM, then refined and phased against
+ *  the whole envelope. Loudness is K-weighted and gated as in BS.1770.
+ *  Loader threads only: it allocates as it goes.
+ **/
+template<typename SampleType>
+class BeatAnalyzer {
+public:
+    explicit BeatAnalyzer(size_t sampleRate)
+        : sampleRate_(sampleRate > 0 ? sampleRate : 44100)
+        , hop_(256)
+        , filled_(0)
+        , frames_(0)
+        , blockFrames_(sampleRate_ / 10)
+        , blockCount_(0)
+        , blockEnergy_(0)
+    {
+        // ~10 ms hops whatever the rate
+        while (hop_ * 100 < sampleRate_) {
+            hop_ <<= 1;
+        }
+        plan_.resize(2 * hop_);
+        window_.resize(2 * hop_);
+        for (size_t i = 0; i < window_.size(); i++) {
+            window_[i] = 0.5 - 0.5 * cos(2. * Pi * double(i) / double(window_.size()));
+        }
+        frame_.resize(2 * hop_, 0.);
+        spectrum_.resize(2 * hop_);
+        magnitudes_.resize(hop_ + 1, 0.);
+        weightedLeft_.resize(WeightingFrames);
+        weightedRight_.resize(WeightingFrames);
+        weighting(shelf_, highpass_);
+    }
+
+    void add(SampleType left, SampleType right) {
+        flux(left, right);
+        double weightedLeft = highpass_[0].process(shelf_[0].process(double(left)));
+        double weightedRight = highpass_[1].process(shelf_[1].process(double(right)));
+        energy(weightedLeft * weightedLeft + weightedRight * weightedRight);
+    }
+
+    // count frames at once, the K-weighting runs over them a channel at a time
+    void add(const SampleType* left, const SampleType* right, size_t count) {
+        for (size_t done = 0; done < count; done += WeightingFrames) {
+            const size_t frames = std::min(WeightingFrames, count - done);
+            for (size_t i = 0; i < frames; i++) {
+                flux(left[done + i], right[done + i]);
+                weightedLeft_[i] = double(left[done + i]);
+                weightedRight_[i] = double(right[done + i]);
+            }
+            shelf_[0].process(weightedLeft_.data(), weightedLeft_.data(), frames);
+            highpass_[0].process(weightedLeft_.data(), weightedLeft_.data(), frames);
+            shelf_[1].process(weightedRight_.data(), weightedRight_.data(), frames);
+            highpass_[1].process(weightedRight_.data(), weightedRight_.data(), frames);
+            for (size_t i = 0; i < frames; i++) {
+                energy(weightedLeft_[i] * weightedLeft_[i] + weightedRight_[i] * weightedRight_[i]);
+            }
+        }
+    }
+
+    SampleAnalysis finish() {
+        SampleAnalysis analysis;
+        analysis.loudness = loudness();
+        grid(analysis);
+        return analysis;
+    }
+
+    template<typename Frame>
+    static SampleAnalysis analyze(size_t sampleRate, size_t frames, Frame&& frame) {
+        BeatAnalyzer analyzer(sampleRate);
+        SampleType left;
+        SampleType right;
+        for (size_t i = 0; i < frames; i++) {
+            frame(i, left, right);
+            analyzer.add(left, right);
+        }
+        return analyzer.finish();
+    }
+
+private:
+    static constexpr double Pi = 3.14159265358979323846264338327950288;
+    static constexpr double SlowestTempo = 60.;
+    static constexpr double FastestTempo = 200.;
+    static constexpr double PreferredTempo = 120.;
+    static constexpr double ShortestSeconds = 1.5;   // less than that has no beat to speak of
+    static constexpr double Steadiness = 0.08;       // below this share of the onsets on the grid there is none
+    static constexpr double SilenceLoudness = -70.;
+    static constexpr double BassFrequency = 150.;    // kicks tell the beat from the off beat
+    static constexpr double Quiet = 1e-4;            // flux per hop below which nothing happens
+    static constexpr double Solitary = 0.25;         // one hit carrying more than this is no pulse
+
+    static constexpr size_t WeightingFrames = 1024;  // frames filtered at once by the block add
+
+    // BS.1770 pre-filter and RLB high pass worked out for any rate
+    void weighting(Biquad<double>* shelf, Biquad<double>* highpass) const {
+        const double rate = double(sampleRate_);
+        {
+            const double f0 = 1681.974450955533;
+            const double gain = 3.999843853973347;
+            const double q = 0.7071752369554196;
+            const double k = tan(Pi * f0 / rate);
+            const double vh = pow(10., gain / 20.);
+            const double vb = pow(vh, 0.4996667741545416);
+            const double a0 = 1. + k / q + k * k;
+            for (size_t c = 0; c < 2; c++) {
+                shelf[c].set((vh + vb * k / q + k * k) / a0, 2. * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                             2. * (k * k - 1.) / a0, (1. - k / q + k * k) / a0);
+            }
+        }
+        {
+            const double f0 = 38.13547087602444;
+            const double q = 0.5003270373238773;
+            const double k = tan(Pi * f0 / rate);
+            const double a0 = 1. + k / q + k * k;
+            for (size_t c = 0; c < 2; c++) {
+                highpass[c].set(1., -2., 1., 2. * (k * k - 1.) / a0, (1. - k / q + k * k) / a0);
+            }
+        }
+    }
+
+    void flux(SampleType left, SampleType right) {
+        frame_[hop_ + filled_] = 0.5 * (double(left) + double(right));
+        if (++filled_ == hop_) {
+            onset();
+            std::copy(frame_.begin() + hop_, frame_.end(), frame_.begin());
+            filled_ = 0;
+        }
+        frames_++;
+    }
+
+    void energy(double weighted) {
+        blockEnergy_ += weighted;
+        if (++blockCount_ == blockFrames_) {
+            blocks_.push_back(blockEnergy_ / double(blockFrames_));
+            blockEnergy_ = 0;
+            blockCount_ = 0;
+        }
+    }
+
+    // half wave rectified flux of log compressed magnitudes
+    void onset() {
+        const size_t size = 2 * hop_;
+        for (size_t i = 0; i < size; i++) {
+            spectrum_[i] = {window_[i] * frame_[i], 0.};
+        }
+        plan_.forward(spectrum_.data(), size);
+
+        const double scale = 1000. / double(size);
+        const size_t bass = size_t(BassFrequency * double(size) / double(sampleRate_));
+        double flux = 0;
+        double bassFlux = 0;
+        for (size_t k = 0; k <= hop_; k++) {
+            double magnitude = std::log1p(scale * std::hypot(spectrum_[k].real, spectrum_[k].imaginary));
+            double rise = std::max(0., magnitude - magnitudes_[k]);
+            flux += rise;
+            bassFlux += k <= bass ? rise : 0.;
+            magnitudes_[k] = magnitude;
+        }
+        envelope_.push_back(envelope_.empty() ? 0. : flux);
+        bassEnvelope_.push_back(bassEnvelope_.empty() ? 0. : bassFlux);
+    }
+
+    // 400 ms blocks a quarter apart, absolute gate then relative gate
+    double loudness() const {
+        std::vector<double> energies;
+        for (size_t i = 0; i + 4 <= blocks_.size(); i++) {
+            energies.push_back(0.25 * (blocks_[i] + blocks_[i + 1] + blocks_[i + 2] + blocks_[i + 3]));
+        }
+        auto level = [](double energy) { return -0.691 + 10. * log10(energy); };
+        auto gated = [&](double threshold) {
+            double sum = 0;
+            size_t count = 0;
+            for (double energy : energies) {
+                if ((energy > 0) && (level(energy) > threshold)) {
+                    sum += energy;
+                    count++;
+                }
+            }
+            return count > 0 ? sum / double(count) : 0.;
+        };
+        double absolute = gated(SilenceLoudness);
+        if (absolute <= 0) {
+            return SilenceLoudness;
+        }
+        double relative = gated(level(absolute) - 10.);
+        return relative > 0 ? std::max(SilenceLoudness, level(relative)) : SilenceLoudness;
+    }
+
+    void grid(SampleAnalysis& analysis) const {
+        const double period = double(hop_) / double(sampleRate_);
+        if ((double(frames_) / double(sampleRate_) < ShortestSeconds) || (envelope_.size() < 8)) {
+            return;
+        }
+
+        // keep what stands out of its surroundings
+        const size_t count = envelope_.size();
+        const size_t radius = std::max<size_t>(1, size_t(0.1 / period));
+        std::vector<double> onsets = peaks(envelope_, radius);
+        std::vector<double> bass = peaks(bassEnvelope_, radius);
+
+        // coarse period: autocorrelation weighted towards the preferred tempo
+        const size_t shortest = std::max<size_t>(2, size_t(60. / FastestTempo / period));
+        const size_t longest = std::min(count / 2, size_t(ceil(60. / SlowestTempo / period)));
+        if (longest <= shortest) {
+            return;
+        }
+        double bestScore = 0;
+        size_t bestLag = 0;
+        for (size_t lag = shortest; lag <= longest; lag++) {
+            double sum = 0;
+            for (size_t i = lag; i < count; i++) {
+                sum += onsets[i] * onsets[i - lag];
+            }
+            double octaves = log2(60. / (double(lag) * period) / PreferredTempo);
+            double score = sum / double(count - lag) * exp(-0.5 * octaves * octaves);
+            if (score > bestScore) {
+                bestScore = score;
+                bestLag = lag;
+            }
+        }
+        if (bestLag == 0) {
+            return;
+        }
+
+        // fine period and phase: the strongest pulse train near it over the whole envelope,
+        // a pulse that is really twice as fast has next to nothing at the slower period
+        double total = 0;
+        double loudest = 0;
+        for (double value : onsets) {
+            total += value;
+            loudest = std::max(loudest, value);
+        }
+        if ((total < Quiet * double(count)) || (loudest > Solitary * total)) {
+            return;
+        }
+        double phase = 0;
+        double strength = 0;
+        double beat = refine(onsets, double(bestLag), phase, strength);
+        if (bestLag >= 2 * shortest) {
+            double halfPhase = 0;
+            double halfStrength = 0;
+            double half = refine(onsets, 0.5 * double(bestLag), halfPhase, halfStrength);
+            if (strength < 0.5 * halfStrength) {
+                beat = half;
+                phase = halfPhase;
+                strength = halfStrength;
+            }
+        }
+        if (strength / total < Steadiness) {
+            return;
+        }
+        if (comb(bass, beat, phase + 0.5 * beat) > comb(bass, beat, phase)) {
+            phase = fmod(phase + 0.5 * beat, beat);
+        }
+
+        double beatLength = beat * double(hop_);
+        double firstBeat = fmod(phase * double(hop_), beatLength);
+        double length = double(frames_);
+
+        // loops cut on the beat get a grid that closes exactly
+        double fit = length / beatLength;
+        double whole = std::round(fit);
+        double offset = firstBeat / beatLength;
+        if ((whole >= 1.) && (fabs(fit - whole) < 0.05) && ((offset < 0.1) || (offset > 0.9))) {
+            beatLength = length / whole;
+            firstBeat = 0;
+        }
+
+        analysis.beatLength = beatLength;
+        analysis.firstBeat = firstBeat;
+        analysis.tempo = 60. * double(sampleRate_) / beatLength;
+        analysis.beats = size_t(ceil((length - firstBeat) / beatLength - 1e-6));
+    }
+
+    static std::vector<double> peaks(const std::vector<double>& envelope, size_t radius) {
+        const size_t count = envelope.size();
+        std::vector<double> result(count);
+        double running = 0;
+        for (size_t i = 0; i < std::min(count, radius); i++) {
+            running += envelope[i];
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (i + radius < count) {
+                running += envelope[i + radius];
+            }
+            if (i > radius) {
+                running -= envelope[i - radius - 1];
+            }
+            size_t width = std::min(count, i + radius + 1) - (i > radius ? i - radius : 0);
+            result[i] = std::max(0., envelope[i] - running / double(width));
+        }
+        return result;
+    }
+
+    // a hop either side in 1/64 steps, then the best step in 1/1024
+    static double refine(const std::vector<double>& onsets, double lag, double& phase, double& strength) {
+        double best = lag;
+        strength = 0;
+        for (double span = 1., step = 1. / 64.; step >= 1. / 1024.; span = step, step /= 16.) {
+            const double center = best;
+            for (double candidate = center - span; candidate <= center + span; candidate += step) {
+                double candidatePhase = 0;
+                double candidateStrength = pulse(onsets, candidate, candidatePhase);
+                if (candidateStrength > strength) {
+                    strength = candidateStrength;
+                    best = candidate;
+                    phase = candidatePhase;
+                }
+            }
+        }
+        return best;
+    }
+
+    // onsets at phase + k * beat, each taken from the hop either side
+    static double comb(const std::vector<double>& onsets, double beat, double phase) {
+        double sum = 0;
+        for (double position = fmod(phase, beat); position + 1. < double(onsets.size()); position += beat) {
+            size_t index = size_t(position);
+            sum += std::max({onsets[index], onsets[index + 1], index > 0 ? onsets[index - 1] : 0.});
+        }
+        return sum;
+    }
+
+    // magnitude of the envelope's component at the given period, phase gets where its peaks fall
+    static double pulse(const std::vector<double>& onsets, double beat, double& phase) {
+        const double step = 2. * Pi / beat;
+        const double rotateReal = cos(step);
+        const double rotateImaginary = -sin(step);
+        double real = 1.;
+        double imaginary = 0.;
+        double sumReal = 0;
+        double sumImaginary = 0;
+        for (size_t i = 0; i < onsets.size(); i++) {
+            sumReal += onsets[i] * real;
+            sumImaginary += onsets[i] * imaginary;
+            double turned = real * rotateReal - imaginary * rotateImaginary;
+            imaginary = real * rotateImaginary + imaginary * rotateReal;
+            real = turned;
+            if ((i & 255) == 255) {
+                // keep the rotation on the unit circle
+                double norm = 1. / std::hypot(real, imaginary);
+                real *= norm;
+                imaginary *= norm;
+            }
+        }
+        double angle = -atan2(sumImaginary, sumReal) / step;
+        phase = angle < 0 ? angle + beat : angle;
+        return std::hypot(sumReal, sumImaginary);
+    }
+
+    size_t sampleRate_;
+    size_t hop_;
+    size_t filled_;
+    size_t frames_;
+
+    FftPlan<double> plan_;
+    std::vector<double> window_;
+    std::vector<double> frame_;
+    std::vector<Complex<double>> spectrum_;
+    std::vector<double> magnitudes_;
+    std::vector<double> envelope_;
+    std::vector<double> bassEnvelope_;
+
+    Biquad<double> shelf_[2];
+    Biquad<double> highpass_[2];
+    std::vector<double> weightedLeft_;
+    std::vector<double> weightedRight_;
+    size_t blockFrames_;
+    size_t blockCount_;
+    double blockEnergy_;
+    std::vector<double> blocks_;
+};
+
+}
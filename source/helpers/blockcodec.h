@@ -0,0 +1,522 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Steinberg::Vst {
+
+namespace Helper {
+
+// most significant bit first, blocks start on a byte boundary
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& bytes):
+        bytes_(bytes)
+    {}
+
+    void write(uint32_t value, int count) {
+        for (int shift = count; shift > 0;) {
+            int chunk = std::min(shift, 24);
+            shift -= chunk;
+            accumulator_ = (accumulator_ << chunk) | ((value >> shift) & ((uint32_t(1) << chunk) - 1));
+            pending_ += chunk;
+            while (pending_ >= 8) {
+                pending_ -= 8;
+                bytes_.push_back(uint8_t(accumulator_ >> pending_));
+            }
+        }
+    }
+
+    void zeros(uint32_t count) {
+        for (; count >= 24; count -= 24) {
+            write(0, 24);
+        }
+        write(0, int(count));
+    }
+
+    void flush() {
+        if (pending_ > 0) {
+            bytes_.push_back(uint8_t(accumulator_ << (8 - pending_)));
+            pending_ = 0;
+        }
+    }
+
+private:
+    std::vector<uint8_t>& bytes_;
+    uint64_t accumulator_ {0};
+    int pending_ {0};
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* bytes, size_t size):
+        bytes_(bytes),
+        size_(size)
+    {}
+
+    uint32_t read(int count) {
+        if (count == 0) {
+            return 0;
+        }
+        if (available_ < count) {
+            refill();
+        }
+        uint32_t value = uint32_t(window_ >> (64 - count));
+        consume(count);
+        return value;
+    }
+
+    // zigzag folded Rice code, a run of escape zeros is followed by the raw 32 bit value
+    uint32_t rice(int parameter, int escape) {
+        if (available_ <= 56) {
+            refill();
+        }
+        int zeros = leadingZeros(window_ | (uint64_t(1) << (63 - escape)));
+        if (zeros >= escape) {
+            consume(escape);
+            uint32_t value = uint32_t(window_ >> 32);
+            consume(32);
+            return value;
+        }
+        consume(zeros + 1);
+        uint32_t low = parameter > 0 ? uint32_t(window_ >> (64 - parameter)) : 0;
+        consume(parameter);
+        return (uint32_t(zeros) << parameter) | low;
+    }
+
+private:
+
+    static int leadingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - int(index);
+#else
+        return __builtin_clzll(value);
+#endif
+    }
+
+    void consume(int count) {
+        window_ <<= count;
+        available_ -= count;
+    }
+
+    void refill() {
+        while (available_ <= 56) {
+            uint64_t byte = position_ < size_ ? bytes_[position_] : 0;
+            window_ |= byte << (56 - available_);
+            position_++;
+            available_ += 8;
+        }
+    }
+
+    const uint8_t* bytes_;
+    size_t size_;
+    size_t position_ {0};
+    uint64_t window_ {0};
+    int available_ {0};
+};
+
+}
+
+/**
+ *  Lossless in-memory store for audio decoded from integer PCM.
+ *  Frames are cut into independently decodable blocks; each channel of a block
+ *  picks the best fixed polynomial predictor (order 0..3) and Rice codes the
+ *  residual in partitions with their own parameter. Stereo blocks may store
+ *  right as the difference to left. Random access costs one block decode.
+ **/
+template<typename SampleType>
+class CompressedSamples {
+public:
+    static constexpr size_t BlockFrames = 4096;
+
+    // false when the audio is not an exact 8/16/24 bit quantisation (float files, converted audio)
+    bool encode(const SampleType* left, const SampleType* right, size_t frames) {
+        clear();
+        if ((frames == 0) || !findScale(left, right, frames)) {
+            return false;
+        }
+
+        std::vector<int32_t> channelLeft(BlockFrames);
+        std::vector<int32_t> channelRight(BlockFrames);
+        std::vector<int32_t> residual(BlockFrames);
+        Helper::BitWriter writer(bytes_);
+        for (size_t first = 0; first < frames; first += BlockFrames) {
+            size_t count = std::min(BlockFrames, frames - first);
+            for (size_t i = 0; i < count; i++) {
+                channelLeft[i] = quantise(left[first + i]);
+                channelRight[i] = quantise(right[first + i]);
+            }
+            // a difference channel costs less than a second copy for anything near mono
+            bool difference = cost(channelRight.data(), count, false) > cost(channelRight.data(), count, true, channelLeft.data());
+            if (difference) {
+                for (size_t i = 0; i < count; i++) {
+                    channelRight[i] -= channelLeft[i];
+                }
+            }
+
+            offsets_.push_back(bytes_.size());
+            writer.write(difference ? 1 : 0, 1);
+            encodeChannel(writer, channelLeft.data(), residual.data(), count);
+            encodeChannel(writer, channelRight.data(), residual.data(), count);
+            writer.flush();
+        }
+        bytes_.shrink_to_fit();
+        offsets_.shrink_to_fit();
+        frames_ = frames;
+        return true;
+    }
+
+    // fills BlockFrames frames, the tail of the last block reads as silence
+    void decode(size_t block, SampleType* left, SampleType* right) const {
+        size_t first = block * BlockFrames;
+        if (block >= offsets_.size()) {
+            std::fill(left, left + BlockFrames, SampleType(0));
+            std::fill(right, right + BlockFrames, SampleType(0));
+            return;
+        }
+        size_t count = std::min(BlockFrames, frames_ - first);
+        size_t begin = offsets_[block];
+        size_t end = block + 1 < offsets_.size() ? offsets_[block + 1] : bytes_.size();
+        Helper::BitReader reader(bytes_.data() + begin, end - begin);
+
+        int32_t channelLeft[BlockFrames];
+        int32_t channelRight[BlockFrames];
+        bool difference = reader.read(1) != 0;
+        decodeChannel(reader, channelLeft, count);
+        decodeChannel(reader, channelRight, count);
+
+        for (size_t i = 0; i < count; i++) {
+            int32_t rightValue = difference ? channelRight[i] + channelLeft[i] : channelRight[i];
+            left[i] = SampleType(channelLeft[i] / scale_);
+            right[i] = SampleType(rightValue / scale_);
+        }
+        std::fill(left + count, left + BlockFrames, SampleType(0));
+        std::fill(right + count, right + BlockFrames, SampleType(0));
+    }
+
+    size_t frames() const {
+        return frames_;
+    }
+
+    size_t blocks() const {
+        return offsets_.size();
+    }
+
+    bool empty() const {
+        return frames_ == 0;
+    }
+
+    void clear() {
+        bytes_.clear();
+        offsets_.clear();
+        frames_ = 0;
+        scale_ = 1.;
+    }
+
+    size_t memorySize() const {
+        return bytes_.capacity() + offsets_.capacity() * sizeof(size_t);
+    }
+
+    // the block stream as a cache file keeps it
+    double scale() const {
+        return scale_;
+    }
+
+    const std::vector<uint8_t>& bytes() const {
+        return bytes_;
+    }
+
+    const std::vector<size_t>& offsets() const {
+        return offsets_;
+    }
+
+    // takes a stream written by encode() back, false when it does not fit the frame count
+    bool assign(size_t frames, double scale, const uint8_t* bytes, size_t size, const uint64_t* offsets, size_t blocks) {
+        clear();
+        if ((frames == 0) || (blocks != (frames + BlockFrames - 1) / BlockFrames)) {
+            return false;
+        }
+        offsets_.resize(blocks);
+        for (size_t block = 0; block < blocks; block++) {
+            if ((offsets[block] >= size) || ((block > 0) && (offsets[block] <= offsets[block - 1]))) {
+                offsets_.clear();
+                return false;
+            }
+            offsets_[block] = size_t(offsets[block]);
+        }
+        bytes_.assign(bytes, bytes + size);
+        frames_ = frames;
+        scale_ = scale;
+        return true;
+    }
+
+    bool operator == (const CompressedSamples& other) const {
+        return (frames_ == other.frames_) && (scale_ == other.scale_) && (bytes_ == other.bytes_);
+    }
+
+private:
+
+    static constexpr size_t PartitionFrames = 256;
+    static constexpr int MaximumOrder = 3;
+    static constexpr int RiceBits = 5;
+    static constexpr uint32_t EscapeLength = 24;
+
+    // same divisors SampleData converts the integer formats with
+    bool findScale(const SampleType* left, const SampleType* right, size_t frames) {
+        for (double scale : {127.0, 32767.0, 8388607.0}) {
+            scale_ = scale;
+            bool lossless = true;
+            for (size_t i = 0; (i < frames) && lossless; i++) {
+                lossless = exact(left[i]) && exact(right[i]);
+            }
+            if (lossless) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool exact(SampleType value) const {
+        double scaled = double(value) * scale_;
+        if (!(fabs(scaled) <= scale_ + 1.)) {
+            return false;
+        }
+        return SampleType(quantise(value) / scale_) == value;
+    }
+
+    int32_t quantise(SampleType value) const {
+        return int32_t(std::llrint(double(value) * scale_));
+    }
+
+    static int64_t predict(const int32_t* x, size_t i, int order) {
+        switch (order) {
+        case 1:
+            return x[i - 1];
+        case 2:
+            return 2 * int64_t(x[i - 1]) - x[i - 2];
+        case 3:
+            return 3 * int64_t(x[i - 1]) - 3 * int64_t(x[i - 2]) + x[i - 3];
+        default:
+            return 0;
+        }
+    }
+
+    static uint32_t zigzag(int64_t value) {
+        return uint32_t((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+    }
+
+    static int32_t unzigzag(uint32_t value) {
+        return int32_t(value >> 1) ^ -int32_t(value & 1);
+    }
+
+    // sum of residual magnitudes of the best predictor, optionally of x - reference
+    static uint64_t cost(const int32_t* x, size_t count, bool difference, const int32_t* reference = nullptr) {
+        int64_t history[MaximumOrder] = {0, 0, 0};
+        uint64_t sums[MaximumOrder + 1] = {0, 0, 0, 0};
+        for (size_t i = 0; i < count; i++) {
+            int64_t value = difference ? int64_t(x[i]) - reference[i] : x[i];
+            int64_t first = value - history[0];
+            int64_t second = first - (history[0] - history[1]);
+            int64_t third = second - ((history[0] - history[1]) - (history[1] - history[2]));
+            sums[0] += uint64_t(std::llabs(value));
+            sums[1] += uint64_t(std::llabs(first));
+            sums[2] += uint64_t(std::llabs(second));
+            sums[3] += uint64_t(std::llabs(third));
+            history[2] = history[1];
+            history[1] = history[0];
+            history[0] = value;
+        }
+        return *std::min_element(sums, sums + MaximumOrder + 1);
+    }
+
+    static int bestOrder(const int32_t* x, size_t count) {
+        uint64_t sums[MaximumOrder + 1] = {0, 0, 0, 0};
+        for (size_t i = MaximumOrder; i < count; i++) {
+            for (int order = 0; order <= MaximumOrder; order++) {
+                sums[order] += uint64_t(std::llabs(int64_t(x[i]) - predict(x, i, order)));
+            }
+        }
+        return int(std::min_element(sums, sums + MaximumOrder + 1) - sums);
+    }
+
+    static uint64_t riceCost(const uint32_t* values, size_t count, int parameter) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t quotient = values[i] >> parameter;
+            bits += quotient < EscapeLength ? quotient + 1 + uint64_t(parameter) : EscapeLength + 32;
+        }
+        return bits;
+    }
+
+    void encodeChannel(Helper::BitWriter& writer, const int32_t* x, int32_t* residual, size_t count) {
+        int order = count > size_t(MaximumOrder) ? bestOrder(x, count) : 0;
+        writer.write(uint32_t(order), 2);
+        for (int i = 0; i < order; i++) {
+            writer.write(uint32_t(x[i]), 32);
+        }
+
+        uint32_t* values = reinterpret_cast<uint32_t*>(residual);
+        for (size_t i = size_t(order); i < count; i++) {
+            values[i] = zigzag(int64_t(x[i]) - predict(x, i, order));
+        }
+
+        for (size_t begin = size_t(order); begin < count;) {
+            size_t end = std::min(count, (begin / PartitionFrames + 1) * PartitionFrames);
+            size_t length = end - begin;
+            uint64_t mean = 0;
+            for (size_t i = begin; i < end; i++) {
+                mean += values[i];
+            }
+            mean /= length;
+            int estimate = 0;
+            while ((estimate < 30) && ((uint64_t(1) << (estimate + 1)) <= mean)) {
+                estimate++;
+            }
+            int parameter = estimate;
+            uint64_t bits = riceCost(values + begin, length, parameter);
+            for (int candidate : {estimate - 1, estimate + 1}) {
+                if ((candidate >= 0) && (candidate < (1 << RiceBits))) {
+                    uint64_t candidateBits = riceCost(values + begin, length, candidate);
+                    if (candidateBits < bits) {
+                        bits = candidateBits;
+                        parameter = candidate;
+                    }
+                }
+            }
+
+            writer.write(uint32_t(parameter), RiceBits);
+            for (size_t i = begin; i < end; i++) {
+                uint32_t quotient = values[i] >> parameter;
+                if (quotient < EscapeLength) {
+                    writer.zeros(quotient);
+                    writer.write(1, 1);
+                    writer.write(values[i], parameter);
+                } else {
+                    // outliers are stored raw so a block never decodes unboundedly long
+                    writer.zeros(EscapeLength);
+                    writer.write(values[i], 32);
+                }
+            }
+            begin = end;
+        }
+    }
+
+    static void decodeChannel(Helper::BitReader& reader, int32_t* x, size_t count) {
+        int order = int(reader.read(2));
+        for (int i = 0; (i < order) && (size_t(i) < count); i++) {
+            x[i] = int32_t(reader.read(32));
+        }
+        for (size_t begin = size_t(order); begin < count;) {
+            size_t end = std::min(count, (begin / PartitionFrames + 1) * PartitionFrames);
+            int parameter = int(reader.read(RiceBits));
+            for (size_t i = begin; i < end; i++) {
+                x[i] = unzigzag(reader.rice(parameter, int(EscapeLength)));
+            }
+            begin = end;
+        }
+        // residuals first, then one tight pass per predictor
+        switch (order) {
+        case 1:
+            for (size_t i = 1; i < count; i++) {
+                x[i] += x[i - 1];
+            }
+            break;
+        case 2:
+            for (size_t i = 2; i < count; i++) {
+                x[i] += 2 * x[i - 1] - x[i - 2];
+            }
+            break;
+        case 3:
+            for (size_t i = 3; i < count; i++) {
+                x[i] += 3 * (x[i - 1] - x[i - 2]) + x[i - 3];
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::vector<uint8_t> bytes_;
+    std::vector<size_t> offsets_;
+    size_t frames_ {0};
+    double scale_ {1.};
+};
+
+/**
+ *  A few decoded blocks of one compressed store, least recently used goes first.
+ *  Owned by a single reader (one playing slot), so there is nothing to lock.
+ **/
+template<typename SampleType>
+class BlockCache {
+public:
+    using Store = CompressedSamples<SampleType>;
+
+    static constexpr size_t Slots = 4;
+
+    // allocates on first use, call off the audio thread
+    void attach(const Store* store) {
+        store_ = store;
+        for (auto& slot : slots_) {
+            slot.block = -1;
+            if (store && slot.left.empty()) {
+                slot.left.resize(Store::BlockFrames);
+                slot.right.resize(Store::BlockFrames);
+            }
+        }
+    }
+
+    struct Block {
+        const SampleType* left;
+        const SampleType* right;
+    };
+
+    Block fetch(size_t block) {
+        Slot* victim = &slots_[0];
+        for (auto& slot : slots_) {
+            if (slot.block == int64_t(block)) {
+                slot.used = ++clock_;
+                return {slot.left.data(), slot.right.data()};
+            }
+            if (slot.used < victim->used) {
+                victim = &slot;
+            }
+        }
+        store_->decode(block, victim->left.data(), victim->right.data());
+        victim->block = int64_t(block);
+        victim->used = ++clock_;
+        return {victim->left.data(), victim->right.data()};
+    }
+
+    size_t memorySize() const {
+        size_t frames = 0;
+        for (auto& slot : slots_) {
+            frames += slot.left.capacity() + slot.right.capacity();
+        }
+        return frames * sizeof(SampleType);
+    }
+
+private:
+
+    struct Slot {
+        int64_t block {-1};
+        uint64_t used {0};
+        std::vector<SampleType> left;
+        std::vector<SampleType> right;
+    };
+
+    const Store* store_ {nullptr};
+    Slot slots_[Slots];
+    uint64_t clock_ {0};
+};
+
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define VINYL_DSP_SSE 1
+#endif
+
+namespace Steinberg::Vst {
+
+/**
+ *  Small building blocks for the audio thread. A recursive filter cannot be vectorised along
+ *  time, its block methods instead keep the state in a register for the whole block.
+ *  Whatever decays below Tiny is flushed to zero at the end of a block,
+ *  DenormalGuard does the same in hardware for everything else.
+ **/
+namespace dsp {
+
+template<typename SampleType>
+constexpr SampleType Tiny = SampleType(1e-15);
+
+template<typename SampleType>
+inline SampleType flush(SampleType value) {
+    return (std::fabs(value) < Tiny<SampleType>) ? SampleType(0) : value;
+}
+
+}
+
+// flush-to-zero and denormals-are-zero for the scope, the previous mode comes back on exit
+class DenormalGuard {
+public:
+
+    DenormalGuard() {
+#if defined(VINYL_DSP_SSE)
+        state_ = _mm_getcsr();
+        _mm_setcsr(state_ | 0x8040u);
+#elif defined(__aarch64__)
+        asm volatile("mrs %0, fpcr" : "=r"(state_));
+        asm volatile("msr fpcr, %0" : : "r"(state_ | (uint64_t(1) << 24)));
+#endif
+    }
+
+    ~DenormalGuard() {
+#if defined(VINYL_DSP_SSE)
+        _mm_setcsr(state_);
+#elif defined(__aarch64__)
+        asm volatile("msr fpcr, %0" : : "r"(state_));
+#endif
+    }
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+private:
+
+#if defined(__aarch64__) && !defined(VINYL_DSP_SSE)
+    uint64_t state_;
+#else
+    unsigned int state_;
+#endif
+};
+
+/**
+ *  One-pole smoother, every step goes 1/round of the way to the new value.
+ *  The step is a multiply by a constant, and once within Tolerance of a target it can be
+ *  snapped there with settled(), after which a block of it is a constant.
+ **/
+template<typename SampleType, int round = 4>
+class Smoother {
+public:
+
+    static constexpr SampleType Tolerance = SampleType(1e-6);
+
+    Smoother(SampleType val = 0):
+        value_(val)
+    {}
+
+    SampleType set(SampleType val) {
+        value_ += (val - value_) * Step;
+        return value_;
+    }
+
+    Smoother& append(SampleType val) {
+        value_ += (val - value_) * Step;
+        return *this;
+    }
+
+    operator SampleType() const {
+        return value_;
+    }
+
+    // true once the value is close enough to target to be target, it is then set to it
+    bool settled(SampleType target) {
+        if (std::fabs(target - value_) <= Tolerance) {
+            value_ = target;
+            return true;
+        }
+        return false;
+    }
+
+    // count steps toward target, out gets the value after each
+    void glide(SampleType target, SampleType* out, size_t count) {
+        if (settled(target)) {
+            std::fill(out, out + count, target);
+            return;
+        }
+        SampleType value = value_;
+        for (size_t i = 0; i < count; i++) {
+            value += (target - value) * Step;
+            out[i] = value;
+        }
+        value_ = dsp::flush(value);
+    }
+
+    // smooths in into out, they may be the same buffer
+    void process(const SampleType* in, SampleType* out, size_t count) {
+        SampleType value = value_;
+        for (size_t i = 0; i < count; i++) {
+            value += (in[i] - value) * Step;
+            out[i] = value;
+        }
+        value_ = dsp::flush(value);
+    }
+
+private:
+
+    static constexpr SampleType Step = SampleType(1) / SampleType(round);
+
+    SampleType value_;
+};
+
+/**
+ *  Biquad in transposed direct form II, the coefficients are divided by a0 already.
+ **/
+template<typename SampleType>
+class Biquad {
+public:
+
+    void set(SampleType b0, SampleType b1, SampleType b2, SampleType a1, SampleType a2) {
+        b0_ = b0;
+        b1_ = b1;
+        b2_ = b2;
+        a1_ = a1;
+        a2_ = a2;
+    }
+
+    SampleType process(SampleType x) {
+        SampleType y = b0_ * x + z1_;
+        z1_ = b1_ * x - a1_ * y + z2_;
+        z2_ = b2_ * x - a2_ * y;
+        return y;
+    }
+
+    // filters in into out, they may be the same buffer
+    void process(const SampleType* in, SampleType* out, size_t count) {
+        SampleType z1 = z1_;
+        SampleType z2 = z2_;
+        for (size_t i = 0; i < count; i++) {
+            SampleType x = in[i];
+            SampleType y = b0_ * x + z1;
+            z1 = b1_ * x - a1_ * y + z2;
+            z2 = b2_ * x - a2_ * y;
+            out[i] = y;
+        }
+        z1_ = dsp::flush(z1);
+        z2_ = dsp::flush(z2);
+    }
+
+    void reset() {
+        z1_ = 0;
+        z2_ = 0;
+    }
+
+private:
+
+    SampleType b0_ {1};
+    SampleType b1_ {0};
+    SampleType b2_ {0};
+    SampleType a1_ {0};
+    SampleType a2_ {0};
+    SampleType z1_ {0};
+    SampleType z2_ {0};
+};
+
+/**
+ *  DC blocker, a zero at DC and a pole just inside it. The pole follows the rate so the
+ *  corner stays at the same frequency, a few hertz leaves everything audible alone.
+ **/
+template<typename SampleType>
+class DcBlocker {
+public:
+
+    static constexpr SampleType Tolerance = SampleType(1e-6);
+
+    explicit DcBlocker(double corner = 5.)
+        : corner_(corner)
+        , rate_(0)
+        , pole_(1)
+        , in_(0)
+        , out_(0)
+    {}
+
+    void sampleRate(double rate) {
+        if ((rate == rate_) || (rate <= 0)) {
+            return;
+        }
+        rate_ = rate;
+        pole_ = SampleType(exp(-2. * 3.14159265358979323846 * corner_ / rate_));
+    }
+
+    SampleType process(SampleType x) {
+        out_ = x - in_ + pole_ * out_;
+        in_ = x;
+        return out_;
+    }
+
+    // filters in into out, they may be the same buffer
+    void process(const SampleType* in, SampleType* out, size_t count) {
+        SampleType previous = in_;
+        SampleType y = out_;
+        for (size_t i = 0; i < count; i++) {
+            SampleType x = in[i];
+            y = x - previous + pole_ * y;
+            previous = x;
+            out[i] = y;
+        }
+        in_ = previous;
+        out_ = dsp::flush(y);
+    }
+
+    // true once a silent input has let the output die away
+    bool settled() const {
+        return (std::fabs(in_) <= Tolerance) && (std::fabs(out_) <= Tolerance);
+    }
+
+    void reset() {
+        in_ = 0;
+        out_ = 0;
+    }
+
+private:
+
+    double corner_;
+    double rate_;
+    SampleType pole_;
+    SampleType in_;
+    SampleType out_;
+};
+
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Record surface noise made up on the fly instead of played from a file:
+ *  hiss and rumble from a bank of xorshift generators, crackle from click and pop shapes
+ *  tabulated at the running rate and added whole, so nothing is interpolated.
+ *  It runs with the platter, a stopped record is silent and a fast one crackles more often.
+ **/
+template<typename SampleType>
+class CrackleGenerator {
+public:
+
+    static constexpr size_t MaximumFrames = 64;
+
+    explicit CrackleGenerator(uint32_t seed)
+        : rate_(0)
+        , random_(scramble(seed ^ 0x5bd1e995u) | 1u)
+        , countdown_(0)
+        , rumble_{}
+        , pops_{}
+    {
+        for (size_t i = 0; i < Lanes; i++) {
+            lanes_[i] = scramble(seed + uint32_t(i)) | 1u;
+        }
+        // room for the usual rates, the shapes are then rebuilt without allocating
+        for (size_t i = 0; i < ShapeCount; i++) {
+            shapes_[i].reserve(shapeFrames(Shapes[i], 192000.));
+        }
+    }
+
+    // rebuilds the shapes when the rate changes, the pops still sounding are dropped
+    void sampleRate(double rate) {
+        if ((rate == rate_) || (rate <= 0)) {
+            return;
+        }
+        rate_ = rate;
+        for (size_t i = 0; i < ShapeCount; i++) {
+            buildShape(shapes_[i], Shapes[i]);
+        }
+        for (auto& pop : pops_) {
+            pop.shape = nullptr;
+        }
+        rumbleCoeff_ = SampleType(1. - exp(-2. * Pi * RumbleTop / rate_));
+        rumbleFloorCoeff_ = SampleType(1. - exp(-2. * Pi * RumbleBottom / rate_));
+        countdown_ = interval();
+    }
+
+    // writes count (up to MaximumFrames) frames of noise, speed holds the platter speed of each
+    void process(SampleType* left, SampleType* right, const double* speed, size_t count) {
+        if (rate_ <= 0) {
+            std::fill(left, left + count, SampleType(0));
+            std::fill(right, right + count, SampleType(0));
+            return;
+        }
+
+        size_t padded = (count + Lanes - 1) / Lanes * Lanes;
+        fill(white_[0], padded);
+        fill(white_[1], padded);
+
+        SampleType level[MaximumFrames];
+        for (size_t i = 0; i < count; i++) {
+            level[i] = std::min(SampleType(fabs(speed[i])), SampleType(1));
+        }
+        noise(left, right, level, count);
+
+        SampleType countdown = countdown_;
+        for (size_t i = 0; i < count; i++) {
+            countdown -= SampleType(fabs(speed[i]));
+            if (countdown <= 0) {
+                start(i, level[i]);
+                countdown = interval();
+            }
+        }
+        countdown_ = countdown;
+
+        for (auto& pop : pops_) {
+            if (pop.shape) {
+                mix(pop, left, right, count);
+            }
+        }
+    }
+
+private:
+
+    static constexpr size_t Lanes = 8;
+    static constexpr size_t MaximumPops = 4;
+    static constexpr double Pi = 3.14159265358979323846264338327950288;
+    static constexpr double EventsPerSecond = 16.;
+    static constexpr double RumbleTop = 60.;
+    static constexpr double RumbleBottom = 15.;
+    static constexpr SampleType HissLevel = SampleType(.004);
+    static constexpr SampleType RumbleLevel = SampleType(1.3);
+
+    // times in seconds: rise, fall, and the slow undershoot that follows a pop (0 - none)
+    struct Shape {
+        double attack;
+        double decay;
+        double undershoot;
+        SampleType level;
+    };
+
+    static constexpr size_t ShapeCount = 4;
+    static constexpr Shape Shapes[ShapeCount] = {
+        {.00003, .00015, 0., SampleType(.12)},
+        {.00005, .0004, 0., SampleType(.2)},
+        {.0001, .001, .008, SampleType(.6)},
+        {.0002, .002, .012, SampleType(.9)},
+    };
+
+    struct Pop {
+        const SampleType* shape;
+        size_t length;
+        size_t position;
+        size_t start;
+        SampleType left;
+        SampleType right;
+    };
+
+    static uint32_t scramble(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    static uint32_t next(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // uniform in (0, 1]
+    SampleType uniform() {
+        return SampleType(next(random_) >> 8 | 1u) * SampleType(1. / 16777216.);
+    }
+
+    // the lanes are independent so each round of them vectorises, count is a multiple of Lanes
+    void fill(SampleType* out, size_t count) {
+        uint32_t lanes[Lanes];
+        std::copy(lanes_, lanes_ + Lanes, lanes);
+        for (size_t done = 0; done < count; done += Lanes) {
+            for (size_t i = 0; i < Lanes; i++) {
+                lanes[i] ^= lanes[i] << 13;
+                lanes[i] ^= lanes[i] >> 17;
+                lanes[i] ^= lanes[i] << 5;
+                out[done + i] = SampleType(int32_t(lanes[i])) * SampleType(1. / 2147483648.);
+            }
+        }
+        std::copy(lanes, lanes + Lanes, lanes_);
+    }
+
+    // a band of rumble between RumbleBottom and RumbleTop with a little hiss on top. Both channels
+    // share the loop so their filter chains overlap, and run on locals the stores cannot alias
+    void noise(SampleType* left, SampleType* right, const SampleType* level, size_t count) {
+        SampleType keep = 1 - rumbleCoeff_;
+        SampleType keepFloor = 1 - rumbleFloorCoeff_;
+        SampleType state[2][3];
+        std::copy(&rumble_[0][0], &rumble_[0][0] + 6, &state[0][0]);
+        for (size_t i = 0; i < count; i++) {
+            for (size_t channel = 0; channel < 2; channel++) {
+                SampleType* filter = state[channel];
+                SampleType white = white_[channel][i];
+                filter[0] = filter[0] * keep + white * rumbleCoeff_;
+                filter[1] = filter[1] * keep + filter[0] * rumbleCoeff_;
+                filter[2] = filter[2] * keepFloor + filter[1] * rumbleFloorCoeff_;
+            }
+            left[i] = ((state[0][1] - state[0][2]) * RumbleLevel + white_[0][i] * HissLevel) * level[i];
+            right[i] = ((state[1][1] - state[1][2]) * RumbleLevel + white_[1][i] * HissLevel) * level[i];
+        }
+        std::copy(&state[0][0], &state[0][0] + 6, &rumble_[0][0]);
+    }
+
+    SampleType interval() {
+        return SampleType(-log(double(uniform())) * rate_ / EventsPerSecond);
+    }
+
+    void start(size_t frame, SampleType level) {
+        for (auto& pop : pops_) {
+            if (pop.shape == nullptr) {
+                uint32_t pick = next(random_);
+                // mostly clicks, now and then a pop
+                size_t index = (pick & 7u) < 5u ? (pick >> 3) & 1u : 2 + ((pick >> 3) & 1u);
+                SampleType size = uniform();
+                SampleType gain = Shapes[index].level * (SampleType(.15) + SampleType(.85) * size * size) * level;
+                gain = (pick & 0x100u) ? gain : -gain;
+                SampleType pan = uniform();
+                pop.shape = shapes_[index].data();
+                pop.length = shapes_[index].size();
+                pop.position = 0;
+                pop.start = frame;
+                pop.left = gain * (SampleType(1.2) - pan * SampleType(.7));
+                pop.right = gain * (SampleType(.5) + pan * SampleType(.7));
+                return;
+            }
+        }
+    }
+
+    static void mix(Pop& pop, SampleType* left, SampleType* right, size_t count) {
+        size_t frames = std::min(count - pop.start, pop.length - pop.position);
+        const SampleType* shape = pop.shape + pop.position;
+        SampleType* outL = left + pop.start;
+        SampleType* outR = right + pop.start;
+        for (size_t i = 0; i < frames; i++) {
+            outL[i] += shape[i] * pop.left;
+            outR[i] += shape[i] * pop.right;
+        }
+        pop.position += frames;
+        pop.start = 0;
+        if (pop.position >= pop.length) {
+            pop.shape = nullptr;
+        }
+    }
+
+    static size_t shapeFrames(const Shape& shape, double rate) {
+        return size_t(std::max(shape.decay * 10., shape.undershoot * 8.) * rate) + 1;
+    }
+
+    // a sharp rise and fall; pops pull back below zero afterwards as much as they went up
+    void buildShape(std::vector<SampleType>& table, const Shape& shape) {
+        table.resize(shapeFrames(shape, rate_));
+        double up = 0;
+        double down = 0;
+        for (size_t i = 0; i < table.size(); i++) {
+            double t = double(i) / rate_;
+            up += (1. - exp(-t / shape.attack)) * exp(-t / shape.decay);
+            if (shape.undershoot > 0) {
+                down += (1. - exp(-t / (shape.attack * 8.))) * exp(-t / shape.undershoot);
+            }
+        }
+        double balance = down > 0 ? up / down : 0;
+        double peak = 0;
+        for (size_t i = 0; i < table.size(); i++) {
+            double t = double(i) / rate_;
+            double value = (1. - exp(-t / shape.attack)) * exp(-t / shape.decay);
+            if (shape.undershoot > 0) {
+                value -= balance * (1. - exp(-t / (shape.attack * 8.))) * exp(-t / shape.undershoot);
+            }
+            table[i] = SampleType(value);
+            peak = std::max(peak, fabs(value));
+        }
+        for (auto& value : table) {
+            value = SampleType(value / peak);
+        }
+    }
+
+    double rate_;
+    uint32_t lanes_[Lanes];
+    uint32_t random_;
+    SampleType countdown_;
+    SampleType rumbleCoeff_;
+    SampleType rumbleFloorCoeff_;
+    SampleType rumble_[2][3];
+    SampleType white_[2][MaximumFrames];
+    Pop pops_[MaximumPops];
+    std::vector<SampleType> shapes_[ShapeCount];
+};
+
+}
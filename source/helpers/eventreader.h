@@ -0,0 +1,59 @@
+#pragma once
+
+#include <limits>
+
+#include "pluginterfaces/vst/ivstevents.h"
+
+namespace Steinberg {
+namespace Vst {
+
+/**
+ *  Reads a block's events in offset order. One event is always fetched ahead,
+ *  so the offset of the next change is known before the frames up to it are rendered.
+ **/
+class EventReader {
+public:
+
+    explicit EventReader(IEventList* eventList):
+        list_(eventList)
+    {
+        fetch();
+    }
+
+    // hands every event due by sampleOffset to handler
+    template<typename Handler>
+    void checkOffset(int32 sampleOffset, Handler&& handler) {
+        while (pending_ && (event_.sampleOffset <= sampleOffset)) {
+            handler(event_);
+            fetch();
+        }
+    }
+
+    // the offset of the next event, the int32 maximum when there is none
+    int32 nextOffset() const {
+        return pending_ ? event_.sampleOffset : std::numeric_limits<int32>::max();
+    }
+
+    // hands over whatever is left, events past the end of the block included
+    template<typename Handler>
+    void flush(Handler&& handler) {
+        while (pending_) {
+            handler(event_);
+            fetch();
+        }
+    }
+
+private:
+
+    void fetch() {
+        pending_ = list_ && (list_->getEvent(index_++, event_) == kResultOk);
+    }
+
+    IEventList* list_;
+    Event event_ = {};
+    int32 index_ = 0;
+    bool pending_ = false;
+};
+
+}
+}
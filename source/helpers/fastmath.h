@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Sine and cosine without a libm call: the argument is brought into [-pi/2, pi/2] by a
+ *  multiple of pi and the sine there is its Taylor polynomial to degree 17. There is no branch,
+ *  so the block versions vectorise. Against libm the error stays below 5e-14 for
+ *  |x| < 100 and 2e-12 for |x| < 1e4, beyond that it grows with |x|.
+ **/
+namespace fastmath {
+
+namespace detail {
+
+// pi split in two so x - k * pi keeps its low bits
+constexpr double PiHigh = 3.141592653589793116;
+constexpr double PiLow = 1.2246467991473532e-16;
+constexpr double InversePi = 0.318309886183790671538;
+constexpr double HalfPi = 1.57079632679489661923;
+
+// adding and taking away 1.5 * 2^52 rounds to the nearest integer without a call,
+// which holds as long as the compiler keeps to IEEE arithmetic (no fast-math)
+constexpr double Round = 6755399441055744.;
+
+template<typename SampleType>
+inline SampleType sinReduced(double x) {
+    double k = (x * InversePi + Round) - Round;
+    double r = (x - k * PiHigh) - k * PiLow;
+    // odd multiples of pi flip the sign
+    double odd = k - 2. * ((k * .5 + Round) - Round);
+    double sign = 1. - 2. * std::fabs(odd);
+    double r2 = r * r;
+    double p = 2.8114572543455207632e-15;
+    p = p * r2 - 7.6471637318198164759e-13;
+    p = p * r2 + 1.6059043836821614599e-10;
+    p = p * r2 - 2.5052108385441718775e-8;
+    p = p * r2 + 2.7557319223985890653e-6;
+    p = p * r2 - 1.9841269841269841270e-4;
+    p = p * r2 + 8.3333333333333333333e-3;
+    p = p * r2 - 1.6666666666666666667e-1;
+    return SampleType(sign * (r + r * r2 * p));
+}
+
+}
+
+template<typename SampleType>
+inline SampleType sin(SampleType x) {
+    return detail::sinReduced<SampleType>(double(x));
+}
+
+template<typename SampleType>
+inline SampleType cos(SampleType x) {
+    return detail::sinReduced<SampleType>(double(x) + detail::HalfPi);
+}
+
+template<typename SampleType>
+void sin(const SampleType* in, SampleType* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = detail::sinReduced<SampleType>(double(in[i]));
+    }
+}
+
+template<typename SampleType>
+void cos(const SampleType* in, SampleType* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = detail::sinReduced<SampleType>(double(in[i]) + detail::HalfPi);
+    }
+}
+
+}
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <utility>
+#include <vector>
 
 
 namespace Steinberg::Vst {
@@ -60,6 +62,82 @@ void fft(Complex<T> *a, size_t n) {
 }
 
 
+/**
+ *  Radix-2 transforms up to a fixed size with the twiddles worked out once.
+ *  Smaller powers of two reuse the same table at a stride, so one plan serves
+ *  every frame size and nothing is computed or allocated per call.
+ **/
+template<typename T>
+class FftPlan {
+public:
+    explicit FftPlan(size_t size = 0) {
+        resize(size);
+    }
+
+    // allocates, not for the audio thread
+    void resize(size_t size) {
+        constexpr T Pi = 3.1415926535897932384626433832;
+        size_ = size;
+        twiddles_.resize(size / 2);
+        for (size_t k = 0; k < twiddles_.size(); k++) {
+            twiddles_[k] = {T(cos(2. * Pi * k / size)), T(-sin(2. * Pi * k / size))};
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    void forward(Complex<T>* a, size_t n) const {
+        transform(a, n, false);
+    }
+
+    // scaled by 1/n, forward then inverse gives the input back
+    void inverse(Complex<T>* a, size_t n) const {
+        transform(a, n, true);
+        const T scale = T(1) / T(n);
+        for (size_t i = 0; i < n; i++) {
+            a[i].real *= scale;
+            a[i].imaginary *= scale;
+        }
+    }
+
+private:
+    void transform(Complex<T>* a, size_t n, bool inverse) const {
+        for (size_t i = 1, j = 0; i < n; i++) {
+            size_t bit = (n >> 1);
+            while (j >= bit) {
+                j -= bit;
+                bit >>= 1;
+            }
+            j += bit;
+            if (i < j) {
+                std::swap(a[i], a[j]);
+            }
+        }
+
+        for (size_t len = 2; len <= n; len <<= 1) {
+            const size_t half = len / 2;
+            const size_t stride = size_ / len;
+            for (size_t i = 0; i < n; i += len) {
+                for (size_t j = 0; j < half; j++) {
+                    Complex<T> w = twiddles_[j * stride];
+                    if (inverse) {
+                        w.imaginary = -w.imaginary;
+                    }
+                    Complex<T> u = a[i + j];
+                    Complex<T> v = a[i + j + half] * w;
+                    a[i + j] = u + v;
+                    a[i + j + half] = u - v;
+                }
+            }
+        }
+    }
+
+    size_t size_;
+    std::vector<Complex<T>> twiddles_;
+};
+
 template<typename T>
 inline T sqr(T x) {
     return x * x;
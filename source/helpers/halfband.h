@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Half-band FIR (Kaiser windowed sinc) split into its two polyphase branches.
+ *  Every other tap is zero and one branch is just the centre tap, so doubling the rate
+ *  costs HalfTaps * 2 multiplies per input and halving it the same per output.
+ *  Both directions together delay the signal by HalfTaps * 2 - 1 frames of the lower rate.
+ **/
+template<typename SampleType, size_t HalfTaps = 8>
+class HalfBand {
+public:
+
+    static constexpr size_t Taps = HalfTaps * 2;
+
+    HalfBand() {
+        double sum = 0;
+        for (size_t i = 0; i < Taps; i++) {
+            // odd offsets -(Taps - 1) .. Taps - 1 around the centre tap
+            double t = double(2 * int(i) - int(Taps - 1));
+            double value = 0.5 * sinc(0.5 * t) * kaiser(t / double(Taps + 1));
+            coefficients_[i] = SampleType(value);
+            sum += value;
+        }
+        // unity gain at DC with the 0.5 centre tap
+        for (size_t i = 0; i < Taps; i++) {
+            coefficients_[i] = SampleType(coefficients_[i] * 0.5 / sum);
+        }
+        reset();
+    }
+
+    void reset() {
+        for (size_t i = 0; i < Taps * 2; i++) {
+            input_[i] = 0;
+            even_[i] = 0;
+        }
+        for (size_t i = 0; i < Centre * 2; i++) {
+            odd_[i] = 0;
+        }
+        inputIndex_ = 0;
+        evenIndex_ = 0;
+        oddIndex_ = 0;
+    }
+
+    // one frame in, two out at twice the rate
+    void upsample(SampleType in, SampleType& first, SampleType& second) {
+        const SampleType* history = push(input_, inputIndex_, Taps, in);
+        first = 2 * dot(history);
+        second = history[Centre - 1];
+    }
+
+    // two frames in at twice the rate, one out
+    SampleType downsample(SampleType first, SampleType second) {
+        const SampleType* history = push(even_, evenIndex_, Taps, first);
+        // the centre tap falls on the odd frame Centre pairs back, read before this pair goes in
+        SampleType acc = dot(history) + 0.5 * odd_[oddIndex_ + Centre - 1];
+        push(odd_, oddIndex_, Centre, second);
+        return acc;
+    }
+
+private:
+
+    static constexpr size_t Centre = HalfTaps;
+    static constexpr double Pi = 3.14159265358979323846264338327950288;
+    static constexpr double beta = 7.;
+
+    // twice as long as needed so the newest length values always lie in one piece, newest first
+    static const SampleType* push(SampleType* buffer, size_t& index, size_t length, SampleType value) {
+        index = (index == 0 ? length : index) - 1;
+        buffer[index] = value;
+        buffer[index + length] = value;
+        return buffer + index;
+    }
+
+    SampleType dot(const SampleType* history) const {
+        SampleType acc = 0;
+        for (size_t i = 0; i < Taps; i++) {
+            acc += history[i] * coefficients_[i];
+        }
+        return acc;
+    }
+
+    static double sinc(double x) {
+        return (x == 0.) ? 1. : sin(Pi * x) / (Pi * x);
+    }
+
+    static double besselI0(double x) {
+        double sum = 1.;
+        double term = 1.;
+        for (int k = 1; k < 32; k++) {
+            term *= (x / (2. * k)) * (x / (2. * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    static double kaiser(double x) {
+        if (fabs(x) >= 1.) {
+            return 0.;
+        }
+        return besselI0(beta * sqrt(1. - x * x)) / besselI0(beta);
+    }
+
+    SampleType coefficients_[Taps];
+    SampleType input_[Taps * 2];
+    SampleType even_[Taps * 2];
+    SampleType odd_[Centre * 2];
+    size_t inputIndex_;
+    size_t evenIndex_;
+    size_t oddIndex_;
+};
+
+/**
+ *  Runs a per-sample nonlinearity on a stereo pair at 1, 2 or 4 times the rate
+ *  through cascaded half-band pairs, so what it folds above Nyquist is filtered away first.
+ **/
+template<typename SampleType>
+class Oversampler {
+public:
+
+    static constexpr size_t MaximumFactor = 4;
+
+    Oversampler()
+        : factor_(1)
+        , padding_{0, 0}
+    {}
+
+    size_t factor() const {
+        return factor_;
+    }
+
+    // frames the output lags the input at a factor: one half-band pair, plus the inner
+    // pair at 4x whose delay counts at twice the rate, padded to a whole frame
+    static constexpr size_t latency(size_t factor) {
+        return factor >= 4 ? PairDelay + (PairDelay + 1) / 2 : factor >= 2 ? PairDelay : 0;
+    }
+
+    // other factors are rounded down to the nearest supported one, the filters start empty
+    void factor(size_t factor) {
+        factor = factor >= 4 ? 4 : factor >= 2 ? 2 : 1;
+        if (factor != factor_) {
+            factor_ = factor;
+            for (size_t channel = 0; channel < 2; channel++) {
+                outer_[channel].reset();
+                inner_[channel].reset();
+                padding_[channel] = 0;
+            }
+        }
+    }
+
+    template<typename Shape>
+    void process(SampleType& left, SampleType& right, Shape&& shape) {
+        if (factor_ == 1) {
+            shape(left, right);
+            return;
+        }
+
+        SampleType wideLeft[2];
+        SampleType wideRight[2];
+        outer_[0].upsample(left, wideLeft[0], wideLeft[1]);
+        outer_[1].upsample(right, wideRight[0], wideRight[1]);
+        for (size_t i = 0; i < 2; i++) {
+            if (factor_ == 4) {
+                SampleType fineLeft[2];
+                SampleType fineRight[2];
+                inner_[0].upsample(wideLeft[i], fineLeft[0], fineLeft[1]);
+                inner_[1].upsample(wideRight[i], fineRight[0], fineRight[1]);
+                shape(fineLeft[0], fineRight[0]);
+                shape(fineLeft[1], fineRight[1]);
+                // the inner pair lags an odd number of frames at twice the rate, one more
+                // makes the whole delay a whole number of frames
+                SampleType paddedLeft = padding_[0];
+                SampleType paddedRight = padding_[1];
+                padding_[0] = inner_[0].downsample(fineLeft[0], fineLeft[1]);
+                padding_[1] = inner_[1].downsample(fineRight[0], fineRight[1]);
+                wideLeft[i] = paddedLeft;
+                wideRight[i] = paddedRight;
+            } else {
+                shape(wideLeft[i], wideRight[i]);
+            }
+        }
+        left = outer_[0].downsample(wideLeft[0], wideLeft[1]);
+        right = outer_[1].downsample(wideRight[0], wideRight[1]);
+    }
+
+private:
+
+    static constexpr size_t PairDelay = HalfBand<SampleType>::Taps - 1;
+
+    size_t factor_;
+    HalfBand<SampleType> outer_[2];
+    HalfBand<SampleType> inner_[2];
+    SampleType padding_[2];
+};
+
+}
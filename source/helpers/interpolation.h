@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Interpolation kernels for sample playback.
+ *  Each kernel reads the points y[-Before] .. y[After] around the integer
+ *  position, x is the fractional part in [0, 1). weights() gives the factors
+ *  of those points, for callers reading many points at the same fraction.
+ **/
+enum class InterpolationQuality {
+    Linear = 0,
+    Hermite,
+    Lagrange,
+    Sinc
+};
+
+static constexpr size_t InterpolationQualityCount = 4;
+
+struct LinearInterpolation {
+    static constexpr int Before = 0;
+    static constexpr int After = 1;
+
+    template<typename SampleType>
+    static SampleType interpolate(const SampleType* y, SampleType x) {
+        return y[0] + x * (y[1] - y[0]);
+    }
+
+    template<typename SampleType>
+    static void weights(SampleType x, SampleType* w) {
+        w[0] = 1. - x;
+        w[1] = x;
+    }
+};
+
+struct HermiteInterpolation {
+    static constexpr int Before = 1;
+    static constexpr int After = 2;
+
+    template<typename SampleType>
+    static SampleType interpolate(const SampleType* y, SampleType x) {
+        SampleType c0 = y[0];
+        SampleType c1 = 0.5 * (y[1] - y[-1]);
+        SampleType c2 = y[-1] - 2.5 * y[0] + 2. * y[1] - 0.5 * y[2];
+        SampleType c3 = 1.5 * (y[0] - y[1]) + 0.5 * (y[2] - y[-1]);
+        return ((c3 * x + c2) * x + c1) * x + c0;
+    }
+
+    template<typename SampleType>
+    static void weights(SampleType x, SampleType* w) {
+        SampleType x2 = x * x;
+        SampleType x3 = x2 * x;
+        w[0] = -0.5 * x + x2 - 0.5 * x3;
+        w[1] = 1. - 2.5 * x2 + 1.5 * x3;
+        w[2] = 0.5 * x + 2. * x2 - 1.5 * x3;
+        w[3] = -0.5 * x2 + 0.5 * x3;
+    }
+};
+
+// 6-point, 5th order
+struct LagrangeInterpolation {
+    static constexpr int Before = 2;
+    static constexpr int After = 3;
+
+    template<typename SampleType>
+    static SampleType interpolate(const SampleType* y, SampleType x) {
+        SampleType a = x + 2.;
+        SampleType b = x + 1.;
+        SampleType d = x - 1.;
+        SampleType e = x - 2.;
+        SampleType f = x - 3.;
+        SampleType ab = a * b;
+        SampleType de = d * e;
+        SampleType abx = ab * x;
+        SampleType def = de * f;
+        return y[-2] * (b * x * def / -120.)
+               + y[-1] * (a * x * def / 24.)
+               + y[0] * (ab * def / -12.)
+               + y[1] * (abx * e * f / 12.)
+               + y[2] * (abx * d * f / -24.)
+               + y[3] * (abx * de / 120.);
+    }
+
+    template<typename SampleType>
+    static void weights(SampleType x, SampleType* w) {
+        SampleType a = x + 2.;
+        SampleType b = x + 1.;
+        SampleType d = x - 1.;
+        SampleType e = x - 2.;
+        SampleType f = x - 3.;
+        SampleType ab = a * b;
+        SampleType de = d * e;
+        SampleType abx = ab * x;
+        SampleType def = de * f;
+        w[0] = b * x * def / -120.;
+        w[1] = a * x * def / 24.;
+        w[2] = ab * def / -12.;
+        w[3] = abx * e * f / 12.;
+        w[4] = abx * d * f / -24.;
+        w[5] = abx * de / 120.;
+    }
+};
+
+// 16-point Kaiser windowed sinc, tabulated and blended between neighbouring phases
+struct SincInterpolation {
+    static constexpr int Before = 7;
+    static constexpr int After = 8;
+
+    // builds the table, call once off the audio thread
+    static void prepare() {
+        table();
+    }
+
+    template<typename SampleType>
+    static SampleType interpolate(const SampleType* y, SampleType x) {
+        const Table& weights = table();
+        double position = double(x) * Phases;
+        size_t phase = size_t(position);
+        if (phase >= Phases) {
+            phase = Phases - 1;
+        }
+        double blend = position - double(phase);
+        const double* first = weights.values[phase];
+        const double* second = weights.values[phase + 1];
+
+        double acc = 0.;
+        for (int k = 0; k < Taps; k++) {
+            acc += double(y[k - Before]) * (first[k] + blend * (second[k] - first[k]));
+        }
+        return SampleType(acc);
+    }
+
+    template<typename SampleType>
+    static void weights(SampleType x, SampleType* w) {
+        const Table& weights = table();
+        double position = double(x) * Phases;
+        size_t phase = size_t(position);
+        if (phase >= Phases) {
+            phase = Phases - 1;
+        }
+        double blend = position - double(phase);
+        const double* first = weights.values[phase];
+        const double* second = weights.values[phase + 1];
+        for (int k = 0; k < Taps; k++) {
+            w[k] = SampleType(first[k] + blend * (second[k] - first[k]));
+        }
+    }
+
+private:
+    static constexpr int Taps = Before + After + 1;
+    static constexpr size_t Phases = 256;
+
+    struct Table {
+        Table() {
+            const double Pi = 3.14159265358979323846264338327950288;
+            const double beta = 7.;
+            auto besselI0 = [](double x) {
+                double sum = 1.;
+                double term = 1.;
+                for (int k = 1; k < 32; k++) {
+                    term *= (x / (2. * k)) * (x / (2. * k));
+                    sum += term;
+                }
+                return sum;
+            };
+            for (size_t phase = 0; phase <= Phases; phase++) {
+                double fraction = double(phase) / double(Phases);
+                double sum = 0.;
+                for (int k = 0; k < Taps; k++) {
+                    double t = double(k - Before) - fraction;
+                    double window = fabs(t) < double(After) ? besselI0(beta * sqrt(1. - (t / After) * (t / After))) / besselI0(beta) : 0.;
+                    values[phase][k] = (t == 0. ? 1. : sin(Pi * t) / (Pi * t)) * window;
+                    sum += values[phase][k];
+                }
+                for (int k = 0; k < Taps; k++) {
+                    values[phase][k] /= sum;
+                }
+            }
+        }
+
+        double values[Phases + 1][Taps];
+    };
+
+    static const Table& table() {
+        static const Table weights;
+        return weights;
+    }
+};
+
+}
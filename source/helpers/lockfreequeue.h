@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Single producer / single consumer ring buffer.
+ *  Neither side ever blocks or allocates, so one end may live on the audio thread.
+ **/
+template<typename T, size_t Capacity>
+class LockFreeQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+
+    LockFreeQueue()
+        : head_(0)
+        , tail_(0)
+    {}
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    bool push(T&& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        buffer_[head & mask] = std::move(value);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(buffer_[tail & mask]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool full() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire) >= Capacity;
+    }
+
+private:
+
+    static constexpr size_t mask = Capacity - 1;
+
+    std::array<T, Capacity> buffer_;
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+};
+
+}
@@ -1,7 +1,10 @@
 #pragma once
 
-#include <map>
+#include <array>
 #include <memory>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
 
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 
@@ -31,29 +34,39 @@ public:
 
     virtual void setQueue(IParamValueQueue* paramQueue) = 0;
 
-    virtual void checkOffset(int32 sampleOffset) = 0;
+    // applies every point due at or before sampleOffset, false once the queue is used up
+    virtual bool checkOffset(int32 sampleOffset) = 0;
 
-    //virtual void set(Sample64 initial) = 0;
+    // offset of the next point still to come, the int32 maximum when there is none
+    virtual int32 pending() const = 0;
 
-    virtual void reset() = 0;
+    // true while the value ramps toward the next point
+    virtual bool ramping() const = 0;
+
+    // count values from frame from on: the ramp toward the next point, or the value as it is
+    virtual void ramp(int32 from, size_t count, ParamValue* out) const = 0;
+
+    // hands the ramp value at sampleOffset to the setter, once the frames up to it are rendered
+    virtual void settle(int32 sampleOffset) = 0;
 
     virtual void flush() = 0;
 };
 
-template<typename Initializer, typename Setter, typename Approximator>
+/**
+ *  Reads one parameter's queue. Ramped parameters go in a straight line from the last point
+ *  (or the value before the block) to the next, its start and slope are worked out once
+ *  per point and the frames read them with ramp().
+ **/
+template<typename Initializer, typename Setter>
 class ParameterReader: public Reader {
 public:
 
     ParameterReader(Initializer && init,
                     Setter &&set,
-                    Approximator &&approx):
+                    bool ramps):
         initializer_(std::forward<Initializer>(init)),
         setter_(std::forward<Setter>(set)),
-        approximator_(std::forward<Approximator>(approx)),
-        value_(0),
-        queue_(nullptr),
-        index_(0),
-        offset_(0)
+        ramps_(ramps)
     {}
 
     ~ParameterReader() override {
@@ -62,36 +75,50 @@ public:
 
     void setQueue(IParamValueQueue* paramQueue) override final {
         queue_ = paramQueue;
-        if (queue_->getPoint(index_++, offset_, value_) != kResultTrue) {
-            queue_ = nullptr;
-        }
+        index_ = 0;
+        lastCheckdOffset_ = -1;
+        // the frame before the block holds the value as it is
+        start_ = -1;
+        startValue_ = initializer_();
+        next();
     }
 
-    void checkOffset(int32 sampleOffset) override final {
-        if (queue_ && offset_ == sampleOffset){
+    bool checkOffset(int32 sampleOffset) override final {
+        // hosts may queue several points on one frame, the last of them is the value there
+        while (queue_ && offset_ <= sampleOffset) {
             setter_(value_);
-            if (queue_->getPoint(index_++, offset_, value_) != kResultTrue) {
-                queue_ = nullptr;
-            }
-        } else if (queue_ && offset_ > sampleOffset){
-            approximator_(sampleOffset, offset_, value_);
+            start_ = sampleOffset;
+            startValue_ = value_;
+            next();
         }
         lastCheckdOffset_ = sampleOffset;
+        return queue_ != nullptr;
     }
 
-    // void set(Sample64 initial) override final {
-    //     value = initial;
-    //     queue = nullptr;
-    //     index = 0;
-    //     offset = 0;
-    // }
+    int32 pending() const override final {
+        return queue_ ? offset_ : std::numeric_limits<int32>::max();
+    }
 
-    void reset() override final {
-        value_ = initializer_();
-        queue_ = nullptr;
-        index_ = 0;
-        offset_ = 0;
-        lastCheckdOffset_ = -1;
+    bool ramping() const override final {
+        return ramps_ && queue_;
+    }
+
+    void ramp(int32 from, size_t count, ParamValue* out) const override final {
+        if (ramping()) {
+            ParamValue value = startValue_ + slope_ * ParamValue(from - start_);
+            for (size_t i = 0; i < count; i++) {
+                out[i] = value + slope_ * ParamValue(i);
+            }
+        } else {
+            std::fill(out, out + count, ParamValue(initializer_()));
+        }
+    }
+
+    void settle(int32 sampleOffset) override final {
+        if (ramping() && sampleOffset > start_) {
+            setter_(startValue_ + slope_ * ParamValue(sampleOffset - start_));
+        }
+        lastCheckdOffset_ = sampleOffset;
     }
 
     void flush() override final {
@@ -99,96 +126,144 @@ public:
             if (lastCheckdOffset_ < offset_) {
                 setter_(value_);
             }
-            if (queue_->getPoint(index_++, offset_, value_) != kResultTrue) {
-                queue_ = nullptr;
-            }
+            next();
         }
     }
 
 private:
 
+    void next() {
+        if (queue_->getPoint(index_++, offset_, value_) != kResultTrue) {
+            queue_ = nullptr;
+            return;
+        }
+        if (ramps_) {
+            slope_ = (value_ - startValue_) / ParamValue(std::max(offset_ - start_, int32(1)));
+        }
+    }
+
     Initializer initializer_;
     Setter setter_;
-    Approximator approximator_;
+    bool ramps_;
     ParamValue value_ = {};
-    IParamValueQueue* queue_ = 0;
+    IParamValueQueue* queue_ = nullptr;
     int32 index_ = 0;
     int32 offset_ = 0;
-    int32 lastCheckdOffset_ = 0;
+    int32 lastCheckdOffset_ = -1;
+    int32 start_ = -1;
+    ParamValue startValue_ = {};
+    ParamValue slope_ = {};
 
 };
 
+/**
+ *  Readers sit in a flat array indexed by ParamID. Only the ones with a queue this block are
+ *  walked, and each drops out of that list once its last point is applied.
+ **/
+template<size_t Size>
 class ReaderManager {
 public:
 
     ReaderManager() = default;
 
-    template<typename Initializer, typename Setter, typename Approximator>
+    // a parameter that steps to each point on its frame
+    template<typename Initializer, typename Setter>
     void addReader(ParamID id,
                    Initializer &&init,
-                   Setter &&setter,
-                   Approximator &&approx) {
-        readers_.emplace(id, std::make_unique<ParameterReader<Initializer, Setter, Approximator>>(std::forward<Initializer>(init),
-                                                               std::forward<Setter>(setter),
-                                                               std::forward<Approximator>(approx)));
+                   Setter &&setter) {
+        add(id, std::forward<Initializer>(init), std::forward<Setter>(setter), false);
     }
 
+    // a parameter that ramps from point to point
     template<typename Initializer, typename Setter>
-    void addReader(ParamID id,
-                   Initializer &&init,
-                   Setter &&setter) {
-        auto approx = [](int32, int32, Sample64) {};
-        readers_.emplace(id, std::make_unique<ParameterReader<Initializer, Setter, decltype(approx)>>(std::forward<Initializer>(init),
-                                                               std::forward<Setter>(setter),
-                                                               std::move(approx)));
+    void addRampReader(ParamID id,
+                       Initializer &&init,
+                       Setter &&setter) {
+        add(id, std::forward<Initializer>(init), std::forward<Setter>(setter), true);
     }
 
     void flush() {
-        for(auto &[_, reader]: readers_) {
-            reader->flush();
+        for (size_t i = 0; i < activeCount_; i++) {
+            active_[i]->flush();
         }
+        activeCount_ = 0;
     }
 
-    void reset() {
-        for(auto &[_, reader]: readers_) {
-            reader->reset();
+    void checkOffset(int32 sampleOffset) {
+        size_t kept = 0;
+        for (size_t i = 0; i < activeCount_; i++) {
+            if (active_[i]->checkOffset(sampleOffset)) {
+                active_[kept++] = active_[i];
+            }
         }
+        activeCount_ = kept;
     }
 
-    void checkOffset(int32 sampleOffset) {
-        for(auto &[_, reader]: readers_) {
-            reader->checkOffset(sampleOffset);
+    // the earliest offset a reader still has a point at
+    int32 nextOffset() const {
+        int32 next = std::numeric_limits<int32>::max();
+        for (size_t i = 0; i < activeCount_; i++) {
+            next = std::min(next, active_[i]->pending());
         }
+        return next;
     }
 
-    // void set(ParamID id, Sample64 value) {
-    //     auto found = readers_.find(id);
-    //     if (found != readers_.end()) {
-    //         found->second->set(value);
-    //     }
-    // }
+    bool ramping() const {
+        for (size_t i = 0; i < activeCount_; i++) {
+            if (active_[i]->ramping()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // count values of a parameter from frame from on, up to (not including) its next point
+    void ramp(ParamID id, int32 from, size_t count, ParamValue* out) const {
+        readers_[id]->ramp(from, count, out);
+    }
+
+    // the ramps have been rendered through sampleOffset, their parameters take the value there
+    void settle(int32 sampleOffset) {
+        for (size_t i = 0; i < activeCount_; i++) {
+            active_[i]->settle(sampleOffset);
+        }
+    }
 
     void setQueue(IParameterChanges* paramChanges) {
-        reset();
+        activeCount_ = 0;
         if (!paramChanges) {
             return;
         }
         for (int32 i = 0, numParamsChanged = paramChanges->getParameterCount(); i < numParamsChanged; i++) {
             IParamValueQueue* paramQueue = paramChanges->getParameterData(i);
             if (paramQueue) {
-                auto found = readers_.find(paramQueue->getParameterId());
-                if (found != readers_.end()) {
-                    found->second->setQueue(paramQueue);
+                ParamID id = paramQueue->getParameterId();
+                if ((id < Size) && readers_[id] && (activeCount_ < Size)) {
+                    readers_[id]->setQueue(paramQueue);
+                    active_[activeCount_++] = readers_[id].get();
                 }
             }
         }
     }
 
 private:
-    std::map<ParamID, std::unique_ptr<Reader>> readers_;
+
+    template<typename Initializer, typename Setter>
+    void add(ParamID id, Initializer &&init, Setter &&setter, bool ramps) {
+        if (id >= Size) {
+            fprintf(stderr, "[ReaderManager] parameter %u is past the reader table\n", unsigned(id));
+            return;
+        }
+        readers_[id] = std::make_unique<ParameterReader<Initializer, Setter>>(std::forward<Initializer>(init),
+                                                                              std::forward<Setter>(setter),
+                                                                              ramps);
+    }
+
+    std::array<std::unique_ptr<Reader>, Size> readers_;
+    std::array<Reader*, Size> active_ = {};
+    size_t activeCount_ = 0;
 };
 
 
 }
 }
-
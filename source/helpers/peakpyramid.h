@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Min / max / energy summary of the mono mix, one leaf per 256 frames,
+ *  every level above merges two nodes of the one below.
+ *  Range queries touch at most two partial leaves plus O(log n) nodes.
+ **/
+template<typename SampleType>
+class PeakPyramid {
+public:
+    static constexpr size_t LeafSize = 256;
+
+    struct Summary {
+        SampleType min {0};
+        SampleType max {0};
+        double energy {0};
+        size_t frames {0};
+
+        SampleType peak() const {
+            return std::max(SampleType(fabs(min)), SampleType(fabs(max)));
+        }
+
+        SampleType rms() const {
+            return frames > 0 ? SampleType(sqrt(energy / double(frames))) : 0;
+        }
+
+        void merge(const Summary& other) {
+            if (other.frames == 0) {
+                return;
+            }
+            min = frames > 0 ? std::min(min, other.min) : other.min;
+            max = frames > 0 ? std::max(max, other.max) : other.max;
+            energy += other.energy;
+            frames += other.frames;
+        }
+    };
+
+    void build(const SampleType* left, const SampleType* right, size_t length) {
+        std::vector<Summary> level(length / LeafSize);
+        for (size_t leaf = 0; leaf < level.size(); leaf++) {
+            level[leaf] = scan(left, right, leaf * LeafSize, (leaf + 1) * LeafSize);
+        }
+        assign(std::move(level));
+    }
+
+    // the bottom level, the ones above are merged from it again
+    void assign(std::vector<Summary>&& leaves) {
+        levels_.clear();
+        if (leaves.empty()) {
+            return;
+        }
+        levels_.push_back(std::move(leaves));
+
+        while (levels_.back().size() > 1) {
+            const std::vector<Summary>& below = levels_.back();
+            std::vector<Summary> above((below.size() + 1) / 2);
+            for (size_t node = 0; node < above.size(); node++) {
+                above[node] = below[node * 2];
+                if (node * 2 + 1 < below.size()) {
+                    above[node].merge(below[node * 2 + 1]);
+                }
+            }
+            levels_.push_back(std::move(above));
+        }
+    }
+
+    // frames [from, to), the raw buffers are needed for the partial leaves at the edges
+    Summary range(const SampleType* left, const SampleType* right, size_t length, size_t from, size_t to) const {
+        return range(length, from, to, [left, right](size_t first, size_t last) { return scan(left, right, first, last); });
+    }
+
+    // same, edge(first, last) summarises the partial leaves for storage that is not a plain buffer
+    template<typename EdgeScan>
+    Summary range(size_t length, size_t from, size_t to, EdgeScan&& edge) const {
+        to = std::min(to, length);
+        if (from >= to) {
+            return {};
+        }
+
+        size_t first = (from + LeafSize - 1) / LeafSize;
+        size_t last = std::min(to / LeafSize, levels_.empty() ? 0 : levels_.front().size());
+        if (first >= last) {
+            return edge(from, to);
+        }
+
+        Summary result = edge(from, first * LeafSize);
+        result.merge(edge(last * LeafSize, to));
+        for (size_t level = 0; (level < levels_.size()) && (first < last); level++) {
+            if (first & 1) {
+                result.merge(levels_[level][first++]);
+            }
+            if (last & 1) {
+                result.merge(levels_[level][--last]);
+            }
+            first >>= 1;
+            last >>= 1;
+        }
+        return result;
+    }
+
+    const std::vector<Summary>& leaves() const {
+        static const std::vector<Summary> none;
+        return levels_.empty() ? none : levels_.front();
+    }
+
+    static Summary scan(const SampleType* left, const SampleType* right, size_t from, size_t to) {
+        Summary summary;
+        if (from >= to) {
+            return summary;
+        }
+        SampleType low = (left[from] + right[from]) * SampleType(0.5);
+        SampleType high = low;
+        double energy = 0;
+        for (size_t i = from; i < to; i++) {
+            SampleType value = (left[i] + right[i]) * SampleType(0.5);
+            low = value < low ? value : low;
+            high = value > high ? value : high;
+            energy += double(value) * double(value);
+        }
+        summary.min = low;
+        summary.max = high;
+        summary.energy = energy;
+        summary.frames = to - from;
+        return summary;
+    }
+
+    size_t memorySize() const {
+        size_t nodes = 0;
+        for (auto& level : levels_) {
+            nodes += level.capacity();
+        }
+        return nodes * sizeof(Summary);
+    }
+
+private:
+
+    std::vector<std::vector<Summary>> levels_;
+};
+
+/**
+ *  Peak preserving reduction of a long recording for display:
+ *  every bucket keeps the frame with the largest mono magnitude.
+ **/
+template<typename SampleType>
+class OverviewBuilder {
+public:
+    OverviewBuilder(size_t frames, size_t maxFrames)
+        : bucket_(maxFrames > 0 ? std::max<size_t>(1, (frames + maxFrames - 1) / maxFrames) : 1)
+    {
+        left_.reserve(frames / bucket_ + 1);
+        right_.reserve(frames / bucket_ + 1);
+    }
+
+    void add(SampleType left, SampleType right) {
+        SampleType magnitude = SampleType(fabs(left + right));
+        if ((count_ == 0) || (magnitude > best_)) {
+            best_ = magnitude;
+            bestLeft_ = left;
+            bestRight_ = right;
+        }
+        if (++count_ == bucket_) {
+            flush();
+        }
+    }
+
+    const std::vector<SampleType>& left() {
+        flush();
+        return left_;
+    }
+
+    const std::vector<SampleType>& right() {
+        flush();
+        return right_;
+    }
+
+private:
+
+    void flush() {
+        if (count_ > 0) {
+            left_.push_back(bestLeft_);
+            right_.push_back(bestRight_);
+            count_ = 0;
+        }
+    }
+
+    size_t bucket_;
+    size_t count_ {0};
+    SampleType best_ {0};
+    SampleType bestLeft_ {0};
+    SampleType bestRight_ {0};
+    std::vector<SampleType> left_;
+    std::vector<SampleType> right_;
+};
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "cuepoint.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace Steinberg::Vst::Helper {
+
+/**
+ *  Playback position as a 32.32 fixed point phase accumulator.
+ *  Stepping is a single integer add and the fraction never accumulates
+ *  rounding error, so long looped sessions do not drift.
+ **/
+class PhaseCursor {
+public:
+    static constexpr int FractionBits = 32;
+    static constexpr int64_t One = int64_t(1) << FractionBits;
+    static constexpr int64_t FractionMask = One - 1;
+
+    explicit PhaseCursor(int64_t integerPart = 0, double floatPart = 0.):
+        value_(compose(integerPart, floatPart))
+    {}
+
+    template<typename IntegerType, typename FloatType>
+    explicit PhaseCursor(const CuePoint<IntegerType, FloatType>& cue):
+        value_(compose(int64_t(cue.integerPart()), double(cue.floatPart())))
+    {}
+
+    // exact, every 32.32 value is representable by a double fraction
+    template<typename Cue>
+    Cue cuePoint() const {
+        return Cue(typename Cue::IntegerType(integerPart()), typename Cue::FloatType(floatPart()));
+    }
+
+    // per sample step for a speed given in frames
+    static int64_t increment(double offset) {
+        return int64_t(std::llrint(offset * double(One)));
+    }
+
+    // loop length in cursor units
+    static int64_t span(size_t frames) {
+        return int64_t(frames) * One;
+    }
+
+    void step(int64_t increment) {
+        value_ += increment;
+    }
+
+    // brings the cursor back into [0, period), branch free for steps shorter than the period
+    void wrap(int64_t period) {
+        value_ += (value_ >> 63) & period;
+        value_ -= ~((value_ - period) >> 63) & period;
+        if (uint64_t(value_) >= uint64_t(period)) {
+            value_ %= period;
+            value_ += (value_ >> 63) & period;
+        }
+    }
+
+    void set(int64_t integerPart, double floatPart) {
+        value_ = compose(integerPart, floatPart);
+    }
+
+    void clear() {
+        value_ = 0;
+    }
+
+    int64_t integerPart() const {
+        return value_ >> FractionBits;
+    }
+
+    double floatPart() const {
+        return double(value_ & FractionMask) / double(One);
+    }
+
+    double asDouble() const {
+        return double(value_) / double(One);
+    }
+
+    int64_t raw() const {
+        return value_;
+    }
+
+    bool operator > (const PhaseCursor& cursor) const {
+        return value_ > cursor.value_;
+    }
+
+    bool operator < (const PhaseCursor& cursor) const {
+        return value_ < cursor.value_;
+    }
+
+    bool operator == (const PhaseCursor& cursor) const {
+        return value_ == cursor.value_;
+    }
+
+    bool operator >= (const PhaseCursor& cursor) const {
+        return value_ >= cursor.value_;
+    }
+
+    bool operator <= (const PhaseCursor& cursor) const {
+        return value_ <= cursor.value_;
+    }
+
+private:
+
+    static int64_t compose(int64_t integerPart, double floatPart) {
+        return integerPart * One + int64_t(std::llrint(floatPart * double(One)));
+    }
+
+    int64_t value_;
+};
+
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Offline polyphase sample rate converter (Kaiser windowed sinc).
+ *  Meant for load time on a background thread, not for the audio path.
+ *  HalfTaps * 2 taps at the lower of the two rates, beta 8.6, the cutoff at 0.95 of the lower
+ *  Nyquist: between 44.1, 48 and 96 kHz it is flat within 0.01 dB up to 20 kHz and rejects
+ *  87 dB from Nyquist on (tests/resampler_check).
+ **/
+template<typename SampleType, size_t HalfTaps = 64>
+class Resampler {
+public:
+
+    Resampler(size_t fromRate, size_t toRate)
+        : up_(1)
+        , down_(1)
+        , phases_(1)
+        , halfTaps_(HalfTaps)
+        , taps_(HalfTaps * 2)
+    {
+        if (fromRate == 0 || toRate == 0) {
+            return;
+        }
+        size_t divisor = std::gcd(fromRate, toRate);
+        up_ = toRate / divisor;
+        down_ = fromRate / divisor;
+        phases_ = up_ < maxPhases ? up_ : maxPhases;
+        // decimating, the kernel spans as many frames of the lower rate as it does when interpolating
+        if (up_ < down_) {
+            halfTaps_ = (HalfTaps * down_ + up_ - 1) / up_;
+            taps_ = halfTaps_ * 2;
+        }
+
+        // below the lower Nyquist when decimating
+        double cutoff = (up_ < down_) ? passband * double(up_) / double(down_) : passband;
+        table_.resize(phases_ * taps_);
+        for (size_t phase = 0; phase < phases_; phase++) {
+            double fraction = double(phase) / double(phases_);
+            double sum = 0;
+            for (size_t k = 0; k < taps_; k++) {
+                double t = double(k) - double(halfTaps_ - 1) - fraction;
+                double value = cutoff * sinc(cutoff * t) * kaiser(t / double(halfTaps_));
+                table_[phase * taps_ + k] = SampleType(value);
+                sum += value;
+            }
+            // unity gain at DC for every phase
+            for (size_t k = 0; k < taps_; k++) {
+                table_[phase * taps_ + k] = SampleType(table_[phase * taps_ + k] / sum);
+            }
+        }
+    }
+
+    bool identity() const {
+        return up_ == down_;
+    }
+
+    size_t outputLength(size_t inputLength) const {
+        return size_t((uint64_t(inputLength) * up_ + down_ - 1) / down_);
+    }
+
+    void process(const SampleType* input, size_t inputLength, std::vector<SampleType>& output) const {
+        output.resize(outputLength(inputLength));
+        if (identity()) {
+            output.assign(input, input + inputLength);
+            return;
+        }
+
+        for (size_t n = 0; n < output.size(); n++) {
+            uint64_t position = uint64_t(n) * down_;
+            int64_t base = int64_t(position / up_);
+            size_t phase = size_t((position % up_) * phases_ / up_);
+            const SampleType* kernel = table_.data() + phase * taps_;
+
+            int64_t first = base - int64_t(halfTaps_ - 1);
+            SampleType acc = 0;
+            if ((first >= 0) && (first + int64_t(taps_) <= int64_t(inputLength))) {
+                const SampleType* source = input + first;
+                for (size_t k = 0; k < taps_; k++) {
+                    acc += source[k] * kernel[k];
+                }
+            } else {
+                for (size_t k = 0; k < taps_; k++) {
+                    int64_t index = first + int64_t(k);
+                    if ((index >= 0) && (index < int64_t(inputLength))) {
+                        acc += input[index] * kernel[k];
+                    }
+                }
+            }
+            output[n] = acc;
+        }
+    }
+
+private:
+
+    static constexpr size_t maxPhases = 4096;
+    static constexpr double Pi = 3.14159265358979323846264338327950288;
+    static constexpr double beta = 8.6;
+    static constexpr double passband = 0.95;
+
+    static double sinc(double x) {
+        return (x == 0.) ? 1. : sin(Pi * x) / (Pi * x);
+    }
+
+    static double besselI0(double x) {
+        double sum = 1.;
+        double term = 1.;
+        for (int k = 1; k < 32; k++) {
+            term *= (x / (2. * k)) * (x / (2. * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    static double kaiser(double x) {
+        if (fabs(x) >= 1.) {
+            return 0.;
+        }
+        return besselI0(beta * sqrt(1. - x * x)) / besselI0(beta);
+    }
+
+    size_t up_;
+    size_t down_;
+    size_t phases_;
+    size_t halfTaps_;
+    size_t taps_;
+    std::vector<SampleType> table_;
+};
+
+/**
+ *  Halves the rate with a linear phase half-band FIR (Kaiser windowed).
+ *  Output frame n is centred on input frame 2n.
+ **/
+template<typename SampleType, size_t HalfTaps = 16>
+void decimateHalfBand(const SampleType* input, size_t inputLength, std::vector<SampleType>& output) {
+    constexpr int64_t reach = 2 * int64_t(HalfTaps) - 1;
+    static const auto kernel = []() {
+        const double Pi = 3.14159265358979323846264338327950288;
+        const double beta = 8.;
+        auto besselI0 = [](double x) {
+            double sum = 1.;
+            double term = 1.;
+            for (int k = 1; k < 32; k++) {
+                term *= (x / (2. * k)) * (x / (2. * k));
+                sum += term;
+            }
+            return sum;
+        };
+        // only the centre and odd offsets are non zero
+        std::vector<double> taps(HalfTaps, 0.);
+        double sum = 0.5;
+        for (int k = 0; k < int(HalfTaps); k++) {
+            int offset = 2 * k + 1;
+            double t = double(offset) / double(2 * HalfTaps);
+            double window = besselI0(beta * sqrt(1. - t * t)) / besselI0(beta);
+            taps[k] = sin(Pi * offset / 2.) / (Pi * offset) * window;
+            sum += 2. * taps[k];
+        }
+        for (auto& tap : taps) {
+            tap /= sum;
+        }
+        return std::make_pair(0.5 / sum, taps);
+    }();
+
+    output.resize((inputLength + 1) / 2);
+    for (size_t n = 0; n < output.size(); n++) {
+        int64_t position = int64_t(n) * 2;
+        double acc = kernel.first * double(input[position]);
+        if ((position >= reach) && (position + reach < int64_t(inputLength))) {
+            for (int k = 0; k < int(HalfTaps); k++) {
+                int offset = 2 * k + 1;
+                acc += kernel.second[k] * (double(input[position - offset]) + double(input[position + offset]));
+            }
+        } else {
+            for (int k = 0; k < int(HalfTaps); k++) {
+                int64_t offset = 2 * k + 1;
+                SampleType before = (position - offset >= 0) ? input[position - offset] : 0;
+                SampleType after = (position + offset < int64_t(inputLength)) ? input[position + offset] : 0;
+                acc += kernel.second[k] * (double(before) + double(after));
+            }
+        }
+        output[n] = SampleType(acc);
+    }
+}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Memory budget of the sample slots of one plugin instance.
+ *  Slots carry a use stamp; when the resident bytes exceed the limit the least
+ *  recently used slots that are not pinned (needed right now) are evicted.
+ *  Evicted slots are remembered with their size until they are back.
+ **/
+template<size_t Slots>
+class SampleBudget {
+public:
+    struct Usage {
+        size_t resident {0};
+        size_t evicted {0};
+        size_t pending {0};   // evicted and already on the way back
+
+        bool operator != (const Usage& other) const {
+            return (resident != other.resident) || (evicted != other.evicted) || (pending != other.pending);
+        }
+    };
+
+    // 0 - unbounded
+    explicit SampleBudget(size_t limit = 0):
+        limit_(limit)
+    {
+        reset();
+    }
+
+    void limit(size_t bytes) {
+        limit_ = bytes;
+    }
+
+    size_t limit() const {
+        return limit_;
+    }
+
+    void reset() {
+        used_.fill(0);
+        evicted_.fill(0);
+        pending_.fill(false);
+        clock_ = 0;
+    }
+
+    void touch(size_t slot) {
+        if (slot < Slots) {
+            used_[slot] = ++clock_;
+        }
+    }
+
+    // the slot was erased, the following ones move down by one
+    void erase(size_t slot) {
+        for (size_t i = slot; i + 1 < Slots; i++) {
+            used_[i] = used_[i + 1];
+            evicted_[i] = evicted_[i + 1];
+            pending_[i] = pending_[i + 1];
+        }
+        used_[Slots - 1] = 0;
+        evicted_[Slots - 1] = 0;
+        pending_[Slots - 1] = false;
+    }
+
+    void restoring(size_t slot) {
+        if ((slot < Slots) && (evicted_[slot] > 0)) {
+            pending_[slot] = true;
+        }
+    }
+
+    // new audio arrived for the slot, whatever was evicted from it is no longer owed
+    void restored(size_t slot) {
+        if (slot < Slots) {
+            evicted_[slot] = 0;
+            pending_[slot] = false;
+            touch(slot);
+        }
+    }
+
+    bool evicted(size_t slot) const {
+        return (slot < Slots) && (evicted_[slot] > 0);
+    }
+
+    /**
+     *  resident(slot) - bytes the slot holds, pinned(slot) - the slot must stay,
+     *  evict(slot) - drops the slot's audio. Evicts least recently used first
+     *  until the rest fits and reports the resulting usage.
+     **/
+    template<typename Resident, typename Pinned, typename Evict>
+    Usage balance(size_t count, Resident&& resident, Pinned&& pinned, Evict&& evict) {
+        count = count < Slots ? count : Slots;
+        std::array<size_t, Slots> bytes;
+        size_t total = 0;
+        for (size_t slot = 0; slot < count; slot++) {
+            bytes[slot] = resident(slot);
+            total += bytes[slot];
+        }
+
+        while ((limit_ > 0) && (total > limit_)) {
+            size_t victim = count;
+            for (size_t slot = 0; slot < count; slot++) {
+                if ((bytes[slot] > 0) && !pinned(slot) && ((victim == count) || (used_[slot] < used_[victim]))) {
+                    victim = slot;
+                }
+            }
+            if (victim == count) {
+                break;
+            }
+            evict(victim);
+            evicted_[victim] = bytes[victim];
+            pending_[victim] = false;
+            total -= bytes[victim];
+            bytes[victim] = 0;
+        }
+
+        Usage usage;
+        usage.resident = total;
+        for (size_t slot = 0; slot < count; slot++) {
+            (pending_[slot] ? usage.pending : usage.evicted) += evicted_[slot];
+        }
+        return usage;
+    }
+
+private:
+    size_t limit_;
+    std::array<uint64_t, Slots> used_;
+    std::array<size_t, Slots> evicted_;
+    std::array<bool, Slots> pending_;
+    uint64_t clock_;
+};
+
+}
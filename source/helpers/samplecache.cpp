@@ -0,0 +1,265 @@
+#include "samplecache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Steinberg {
+namespace Vst {
+
+namespace {
+
+std::filesystem::path cacheDirectory() {
+#if WINDOWS
+    const char* base = getenv("LOCALAPPDATA");
+    if (base && *base) {
+        return std::filesystem::path(base) / "BassBuster" / "VinylSampler" / "Cache";
+    }
+#elif MAC
+    const char* home = getenv("HOME");
+    if (home && *home) {
+        return std::filesystem::path(home) / "Library" / "Caches" / "BassBuster" / "VinylSampler";
+    }
+#else
+    const char* base = getenv("XDG_CACHE_HOME");
+    if (base && *base) {
+        return std::filesystem::path(base) / "bassbuster" / "vinylsampler";
+    }
+    const char* home = getenv("HOME");
+    if (home && *home) {
+        return std::filesystem::path(home) / ".cache" / "bassbuster" / "vinylsampler";
+    }
+#endif
+    return {};
+}
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::atomic<uint64_t> cacheLimit {0};
+std::mutex pruneMutex;
+
+// drops the least recently used files until the directory fits the limit again
+void pruneCache(const std::filesystem::path& directory, const std::filesystem::path& written) {
+    uint64_t limit = cacheLimit.load();
+    if (limit == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pruneMutex);
+
+    struct Cached {
+        std::filesystem::path path;
+        uint64_t bytes;
+        std::filesystem::file_time_type used;
+    };
+    std::vector<Cached> files;
+    uint64_t total = 0;
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+        if ((item.path().extension() != ".vsc") || !item.is_regular_file(error)) {
+            continue;
+        }
+        Cached file {item.path(), item.file_size(error), item.last_write_time(error)};
+        if (!error) {
+            total += file.bytes;
+            files.push_back(std::move(file));
+        }
+    }
+    if (total <= limit) {
+        return;
+    }
+
+    std::sort(files.begin(), files.end(), [](const Cached& a, const Cached& b) { return a.used < b.used; });
+    for (const auto& file : files) {
+        if (total <= limit) {
+            break;
+        }
+        // a file still mapped by a reader may refuse, it goes with a later sweep
+        if ((file.path != written) && std::filesystem::remove(file.path, error)) {
+            total -= file.bytes;
+        }
+    }
+}
+
+FILE* openForWrite(const std::filesystem::path& path) {
+#if WINDOWS
+    return _wfopen(path.c_str(), L"wb");
+#else
+    return fopen(path.c_str(), "wb");
+#endif
+}
+
+}
+
+MappedFile::MappedFile(const std::string& path)
+    : data_(nullptr)
+    , size_(0)
+    , handle_(nullptr)
+{
+#if WINDOWS
+    HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (data_) {
+                size_ = size_t(fileSize.QuadPart);
+                handle_ = mapping;
+            } else {
+                CloseHandle(mapping);
+            }
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return;
+    }
+    struct stat info;
+    if ((fstat(file, &info) == 0) && (info.st_size > 0)) {
+        void* mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped != MAP_FAILED) {
+            data_ = static_cast<const uint8_t*>(mapped);
+            size_ = size_t(info.st_size);
+        }
+    }
+    close(file);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    if (!data_) {
+        return;
+    }
+#if WINDOWS
+    UnmapViewOfFile(data_);
+    CloseHandle(handle_);
+#else
+    munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+}
+
+std::string sampleFileKey(const char* fileName, size_t sampleSize, size_t targetRate)
+{
+    if (!fileName || !*fileName) {
+        return {};
+    }
+
+    std::error_code error;
+    std::filesystem::path source(fileName);
+    auto fileSize = std::filesystem::file_size(source, error);
+    if (error) {
+        return {};
+    }
+    auto modified = std::filesystem::last_write_time(source, error).time_since_epoch().count();
+    if (error) {
+        return {};
+    }
+
+    std::string canonical = std::filesystem::absolute(source, error).u8string();
+    uint64_t key = 0xcbf29ce484222325ULL;
+    key = fnv1a(key, canonical.data(), canonical.size());
+    key = fnv1a(key, &fileSize, sizeof(fileSize));
+    key = fnv1a(key, &modified, sizeof(modified));
+    key = fnv1a(key, &sampleSize, sizeof(sampleSize));
+    key = fnv1a(key, &SampleCacheHeader::currentVersion, sizeof(SampleCacheHeader::currentVersion));
+    if (targetRate > 0) {
+        key = fnv1a(key, &targetRate, sizeof(targetRate));
+    }
+
+    char name[20];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return name;
+}
+
+std::string sampleCachePath(const char* fileName, size_t sampleSize, size_t targetRate, bool packed)
+{
+    auto directory = cacheDirectory();
+    if (directory.empty()) {
+        return {};
+    }
+    auto key = sampleFileKey(fileName, sampleSize, targetRate);
+    if (key.empty()) {
+        return {};
+    }
+    return (directory / (key + (packed ? ".packed.vsc" : ".vsc"))).u8string();
+}
+
+bool writeSampleCache(const std::string& cachePath,
+                      const SampleCacheHeader& header,
+                      std::initializer_list<SampleCacheSection> sections)
+{
+    std::error_code error;
+    std::filesystem::path target(cachePath);
+    std::filesystem::create_directories(target.parent_path(), error);
+    if (error) {
+        return false;
+    }
+
+    // written aside and renamed, so a reader never maps a half written file
+    std::filesystem::path temporary(target);
+    temporary += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+    FILE* fileHandle = openForWrite(temporary);
+    if (!fileHandle) {
+        return false;
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, fileHandle) == 1;
+    for (const auto& section : sections) {
+        written = written && ((section.bytes == 0) || (fwrite(section.data, 1, section.bytes, fileHandle) == section.bytes));
+    }
+    written = (fclose(fileHandle) == 0) && written;
+
+    if (written) {
+        std::filesystem::rename(temporary, target, error);
+        written = !error;
+    }
+    if (!written) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    pruneCache(target.parent_path(), target);
+    return true;
+}
+
+void touchSampleCache(const std::string& cachePath)
+{
+    std::error_code error;
+    std::filesystem::last_write_time(std::filesystem::path(cachePath), std::filesystem::file_time_type::clock::now(), error);
+}
+
+void sampleCacheLimit(uint64_t bytes)
+{
+    cacheLimit = bytes;
+}
+
+}}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+namespace Steinberg {
+namespace Vst {
+
+/**
+ *  Decoded samples are kept on disk in the plugin's own format: header, the left
+ *  and right channel at the width of the file (integer PCM) or as float, then
+ *  what was derived from them - the peak summaries and the half-band pyramid -
+ *  so a warm load reads everything straight from the mapping and computes nothing.
+ *  Packed entries keep the block offsets and the encoded stream instead of the channels.
+ *  Files are named after the source path, size, mtime, frame type and,
+ *  for converted audio, the target rate, so any change to the source produces a new key.
+ *  The directory is kept under a size limit, least recently used files go first.
+ **/
+struct SampleCacheHeader {
+    enum AcidMode : uint32_t {
+        NoAcid = 0,
+        AcidLoop,
+        AcidOneShoot
+    };
+
+    enum Encoding : uint32_t {
+        Float32 = 0,
+        Int16,          // 8 and 16 bit files
+        Int32,          // 24 bit files
+        Packed          // CompressedSamples blocks, no pyramid
+    };
+
+    static constexpr uint32_t currentMagic = 0x32435356; // "VSC2"
+    static constexpr uint32_t currentVersion = 3;    // also bumped when converted audio changes
+
+    uint32_t magic {currentMagic};
+    uint32_t version {currentVersion};
+    uint32_t sampleSize {0};
+    uint32_t sampleRate {0};
+    uint32_t acidBeats {0};
+    uint32_t acidMode {NoAcid};
+    uint64_t frames {0};
+    uint32_t encoding {Float32};
+    uint32_t sourceBits {0};     // integer scale of the file, 0 - float
+    uint64_t hash {0};
+    uint64_t leaves {0};         // peak summaries following the audio
+    uint32_t summarySize {0};
+    uint32_t levels {0};         // pyramid levels following the summaries, float
+    uint64_t packedBytes {0};    // Packed: encoded stream after the block offsets
+    uint32_t blocks {0};         // Packed: block offsets following the header, uint64
+    uint32_t packedScale {0};    // Packed: integer divisor of the stream
+};
+
+struct SampleCacheSection {
+    const void* data;
+    size_t bytes;
+};
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const {
+        return data_ != nullptr;
+    }
+
+    const uint8_t* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    void* handle_;
+};
+
+// identity of the source file and target format, empty when the file can not be identified
+// targetRate 0 - audio at the file's own rate
+std::string sampleFileKey(const char* fileName, size_t sampleSize, size_t targetRate = 0);
+
+// empty string when the source can not be identified, packed entries have a file of their own
+std::string sampleCachePath(const char* fileName, size_t sampleSize, size_t targetRate = 0, bool packed = false);
+
+// the sections are written after the header in the given order
+bool writeSampleCache(const std::string& cachePath,
+                      const SampleCacheHeader& header,
+                      std::initializer_list<SampleCacheSection> sections);
+
+// marks a cache file as used, the size limit drops the least recently used first
+void touchSampleCache(const std::string& cachePath);
+
+// bytes the cache directory may take, 0 - unbounded
+void sampleCacheLimit(uint64_t bytes);
+
+}}
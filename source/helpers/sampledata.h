@@ -0,0 +1,710 @@
+#pragma once
+
+#include "samplecache.h"
+#include "resampler.h"
+#include "peakpyramid.h"
+#include "blockcodec.h"
+
+#include <vector>
+#include <string>
+#include <inttypes.h>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+namespace Steinberg {
+namespace Vst {
+
+template<typename SampleType>
+class SampleStream;
+
+/**
+ *  Immutable decoded audio of one file.
+ *  Shared between every slot (and plugin instance) playing the same content,
+ *  per slot settings and cursors live in SampleEntry.
+ **/
+template<typename SampleType>
+class SampleData {
+public:
+    using Type = SampleType;
+    using AcidMode = SampleCacheHeader::AcidMode;
+    using Summary = typename PeakPyramid<SampleType>::Summary;
+    using Packed = CompressedSamples<SampleType>;
+
+    // half-band decimated copies for fast playback: 2x, 4x, 8x
+    static constexpr size_t PyramidLevels = 3;
+
+    SampleData() :
+        sampleRate_(0),
+        acidBeats_(0),
+        acidMode_(SampleCacheHeader::NoAcid),
+        sourceBits_(0),
+        hash_(0)
+    {}
+
+    SampleData(const SampleType *left, const SampleType *right, size_t size) :
+        soundBufferLeft_(left, left + size),
+        soundBufferRight_(right, right + size),
+        sampleRate_(0),
+        acidBeats_(0),
+        acidMode_(SampleCacheHeader::NoAcid),
+        sourceBits_(0),
+        hash_(0)
+    {
+        analyse();
+    }
+
+    // converted copy of the source at another rate, tempo metadata is kept;
+    // held at float precision like its cache file, so cold and warm loads pool together
+    SampleData(const SampleData& source, size_t targetRate) :
+        sampleRate_(targetRate),
+        acidBeats_(source.acidBeats_),
+        acidMode_(source.acidMode_),
+        sourceBits_(0),
+        hash_(0)
+    {
+        Resampler<SampleType> resampler(source.sampleRate_, targetRate);
+        resampler.process(source.soundBufferLeft_.data(), source.soundBufferLeft_.size(), soundBufferLeft_);
+        resampler.process(source.soundBufferRight_.data(), source.soundBufferRight_.size(), soundBufferRight_);
+        for (auto* buffer : {&soundBufferLeft_, &soundBufferRight_}) {
+            for (auto& sample : *buffer) {
+                sample = SampleType(float(sample));
+            }
+        }
+        analyse();
+    }
+
+    bool loadFromFile(const char *fileName) {
+        std::string cachePath = sampleCachePath(fileName, sizeof(SampleType));
+        if (!cachePath.empty() && loadFromCache(cachePath)) {
+            return true;
+        }
+        if (!decodeFile(fileName)) {
+            return false;
+        }
+        analyse();
+        if (!cachePath.empty()) {
+            buildPyramid();
+            storeToCache(cachePath);
+        }
+        return true;
+    }
+
+    // packed entries keep only their encoded blocks on disk. false for audio the codec
+    // can not hold exactly, its plain decode is left in the cache for the caller
+    bool loadPacked(const char *fileName) {
+        std::string cachePath = sampleCachePath(fileName, sizeof(SampleType), 0, true);
+        if (!cachePath.empty() && loadFromCache(cachePath)) {
+            return compressed();
+        }
+        std::string plainPath = sampleCachePath(fileName, sizeof(SampleType));
+        if (plainPath.empty() || !loadFromCache(plainPath)) {
+            if (!decodeFile(fileName)) {
+                return false;
+            }
+            analyse();
+            if ((sourceBits_ == 0) && !plainPath.empty()) {
+                buildPyramid();
+                storeToCache(plainPath);
+            }
+        }
+        if ((sourceBits_ == 0) || !compress()) {
+            return false;
+        }
+        if (!cachePath.empty()) {
+            storeToCache(cachePath);
+        }
+        return true;
+    }
+
+    size_t size() const {
+        return packed_.empty() ? soundBufferLeft_.size() : packed_.frames();
+    }
+
+    // loader threads, before the data is shared: integer PCM is kept losslessly packed
+    // and the plain buffers are released, false for audio the codec can not hold exactly
+    bool compress() {
+        if (!packed_.encode(soundBufferLeft_.data(), soundBufferRight_.data(), soundBufferLeft_.size())) {
+            return false;
+        }
+        std::vector<SampleType>().swap(soundBufferLeft_);
+        std::vector<SampleType>().swap(soundBufferRight_);
+        for (auto& level : pyramid_) {
+            std::vector<SampleType>().swap(level.left);
+            std::vector<SampleType>().swap(level.right);
+        }
+        return true;
+    }
+
+    // packed audio has no plain buffers and no pyramid, read it through a BlockCache
+    bool compressed() const {
+        return !packed_.empty();
+    }
+
+    const Packed& packed() const {
+        return packed_;
+    }
+
+    // loader threads, before the data is shared; the levels are held at float
+    // precision, which is what the cache keeps of them
+    void buildPyramid() {
+        if (compressed()) {
+            return;
+        }
+        const std::vector<SampleType>* left = &soundBufferLeft_;
+        const std::vector<SampleType>* right = &soundBufferRight_;
+        for (size_t level = 0; level < PyramidLevels; level++) {
+            decimateHalfBand(left->data(), left->size(), pyramid_[level].left);
+            decimateHalfBand(right->data(), right->size(), pyramid_[level].right);
+            for (auto* buffer : {&pyramid_[level].left, &pyramid_[level].right}) {
+                for (auto& sample : *buffer) {
+                    sample = SampleType(float(sample));
+                }
+            }
+            left = &pyramid_[level].left;
+            right = &pyramid_[level].right;
+        }
+    }
+
+    // 0 until the pyramid is built
+    size_t levels() const {
+        return pyramid_[0].left.empty() ? 0 : PyramidLevels;
+    }
+
+    // level 0 is the audio itself, level n is decimated by 2^n
+    size_t size(size_t level) const {
+        return level == 0 ? size() : pyramid_[level - 1].left.size();
+    }
+
+    const SampleType* left(size_t level) const {
+        return level == 0 ? soundBufferLeft_.data() : pyramid_[level - 1].left.data();
+    }
+
+    const SampleType* right(size_t level) const {
+        return level == 0 ? soundBufferRight_.data() : pyramid_[level - 1].right.data();
+    }
+
+    const SampleType* left() const {
+        return soundBufferLeft_.data();
+    }
+
+    const SampleType* right() const {
+        return soundBufferRight_.data();
+    }
+
+    size_t sampleRate() const {
+        return sampleRate_;
+    }
+
+    size_t acidBeats() const {
+        return acidBeats_;
+    }
+
+    AcidMode acidMode() const {
+        return acidMode_;
+    }
+
+    uint64_t hash() const {
+        return hash_;
+    }
+
+    // display copy of at most maxFrames frames, peaks are kept
+    std::shared_ptr<const SampleData> overview(size_t maxFrames) const {
+        OverviewBuilder<SampleType> builder(size(), maxFrames);
+        if (compressed()) {
+            std::vector<SampleType> left(Packed::BlockFrames);
+            std::vector<SampleType> right(Packed::BlockFrames);
+            for (size_t block = 0; block < packed_.blocks(); block++) {
+                packed_.decode(block, left.data(), right.data());
+                size_t count = std::min(Packed::BlockFrames, size() - block * Packed::BlockFrames);
+                for (size_t i = 0; i < count; i++) {
+                    builder.add(left[i], right[i]);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < size(); i++) {
+                builder.add(soundBufferLeft_[i], soundBufferRight_[i]);
+            }
+        }
+        return std::make_shared<SampleData>(builder.left().data(), builder.right().data(), builder.left().size());
+    }
+
+    // min / max / rms of the mono mix over frames [from, to)
+    Summary summary(size_t from, size_t to) const {
+        if (!compressed()) {
+            return peaks_.range(left(), right(), size(), from, to);
+        }
+        // partial leaves are shorter than a block, so at most two get decoded
+        return peaks_.range(size(), from, to, [this](size_t first, size_t last) {
+            Summary result;
+            std::vector<SampleType> left(Packed::BlockFrames);
+            std::vector<SampleType> right(Packed::BlockFrames);
+            for (size_t block = first / Packed::BlockFrames; (first < last) && (block * Packed::BlockFrames < last); block++) {
+                size_t start = block * Packed::BlockFrames;
+                packed_.decode(block, left.data(), right.data());
+                result.merge(PeakPyramid<SampleType>::scan(left.data(), right.data(),
+                                                           std::max(first, start) - start,
+                                                           std::min(last, start + Packed::BlockFrames) - start));
+            }
+            return result;
+        });
+    }
+
+    size_t memorySize() const {
+        size_t frames = soundBufferLeft_.capacity() + soundBufferRight_.capacity();
+        for (auto& level : pyramid_) {
+            frames += level.left.capacity() + level.right.capacity();
+        }
+        return frames * sizeof(SampleType) + packed_.memorySize() + peaks_.memorySize();
+    }
+
+    bool operator == (const SampleData & other) const {
+        return (hash_ == other.hash_)
+               && (other.packed_ == packed_)
+               && (other.soundBufferLeft_ == soundBufferLeft_)
+               && (other.soundBufferRight_ == soundBufferRight_);
+    }
+
+    // converts straight from the mapped file, the hash, peaks and pyramid come with it
+    bool loadFromCache(const std::string& cachePath) {
+        MappedFile mapped(cachePath);
+        if (!mapped.valid() || mapped.size() < sizeof(SampleCacheHeader)) {
+            return false;
+        }
+
+        SampleCacheHeader header;
+        memcpy(&header, mapped.data(), sizeof(header));
+        auto encoding = SampleCacheHeader::Encoding(header.encoding);
+        size_t frames = size_t(header.frames);
+        size_t audioBytes = encoding == SampleCacheHeader::Packed
+                            ? header.blocks * sizeof(uint64_t) + size_t(header.packedBytes)
+                            : 2 * frames * encodedWidth(encoding);
+        size_t pyramidFrames = 0;
+        for (size_t level = 0, length = frames; level < header.levels; level++) {
+            length = (length + 1) / 2;
+            pyramidFrames += length;
+        }
+        if ((header.magic != SampleCacheHeader::currentMagic)
+            || (header.version != SampleCacheHeader::currentVersion)
+            || (header.sampleSize != sizeof(SampleType))
+            || (frames == 0) || (audioBytes == 0)
+            || (header.summarySize != sizeof(Summary))
+            || ((header.levels != 0) && (header.levels != PyramidLevels))
+            || ((encoding == SampleCacheHeader::Packed) && (header.levels != 0))
+            || (mapped.size() != sizeof(header) + audioBytes + header.leaves * sizeof(Summary) + 2 * pyramidFrames * sizeof(float))) {
+            return false;
+        }
+
+        const uint8_t* data = mapped.data() + sizeof(header);
+        sourceBits_ = header.sourceBits;
+        if (encoding == SampleCacheHeader::Packed) {
+            std::vector<uint64_t> offsets(header.blocks);
+            memcpy(offsets.data(), data, offsets.size() * sizeof(uint64_t));
+            data += offsets.size() * sizeof(uint64_t);
+            if (!packed_.assign(frames, header.packedScale, data, size_t(header.packedBytes), offsets.data(), offsets.size())) {
+                return false;
+            }
+            data += header.packedBytes;
+        } else {
+            decode(encoding, data, frames, soundBufferLeft_);
+            data += frames * encodedWidth(encoding);
+            decode(encoding, data, frames, soundBufferRight_);
+            data += frames * encodedWidth(encoding);
+        }
+
+        std::vector<Summary> leaves(size_t(header.leaves));
+        memcpy(leaves.data(), data, leaves.size() * sizeof(Summary));
+        peaks_.assign(std::move(leaves));
+        data += header.leaves * sizeof(Summary);
+
+        for (size_t level = 0, length = frames; level < header.levels; level++) {
+            length = (length + 1) / 2;
+            decode(SampleCacheHeader::Float32, data, length, pyramid_[level].left);
+            data += length * sizeof(float);
+            decode(SampleCacheHeader::Float32, data, length, pyramid_[level].right);
+            data += length * sizeof(float);
+        }
+
+        sampleRate_ = header.sampleRate;
+        acidBeats_ = header.acidBeats;
+        acidMode_ = AcidMode(header.acidMode);
+        hash_ = header.hash;
+        touchSampleCache(cachePath);
+        return true;
+    }
+
+    bool storeToCache(const std::string& cachePath) const {
+        SampleCacheHeader header;
+        header.sampleSize = sizeof(SampleType);
+        header.sampleRate = uint32_t(sampleRate_);
+        header.acidBeats = uint32_t(acidBeats_);
+        header.acidMode = acidMode_;
+        header.frames = size();
+        header.encoding = sourceBits_ > 16 ? SampleCacheHeader::Int32 : sourceBits_ > 0 ? SampleCacheHeader::Int16 : SampleCacheHeader::Float32;
+        header.sourceBits = sourceBits_;
+        header.hash = hash_;
+        header.leaves = peaks_.leaves().size();
+        header.summarySize = sizeof(Summary);
+        header.levels = uint32_t(levels());
+
+        if (compressed()) {
+            header.encoding = SampleCacheHeader::Packed;
+            header.levels = 0;
+            header.packedBytes = packed_.bytes().size();
+            header.blocks = uint32_t(packed_.blocks());
+            header.packedScale = uint32_t(packed_.scale());
+            std::vector<uint64_t> offsets(packed_.offsets().begin(), packed_.offsets().end());
+            return writeSampleCache(cachePath, header, {{offsets.data(), offsets.size() * sizeof(uint64_t)},
+                                                        {packed_.bytes().data(), packed_.bytes().size()},
+                                                        {peaks_.leaves().data(), peaks_.leaves().size() * sizeof(Summary)}});
+        }
+
+        auto encoding = SampleCacheHeader::Encoding(header.encoding);
+        std::vector<uint8_t> left = encode(encoding, soundBufferLeft_);
+        std::vector<uint8_t> right = encode(encoding, soundBufferRight_);
+        std::vector<uint8_t> pyramid;
+        for (size_t level = 0; level < header.levels; level++) {
+            for (const auto* buffer : {&pyramid_[level].left, &pyramid_[level].right}) {
+                auto bytes = encode(SampleCacheHeader::Float32, *buffer);
+                pyramid.insert(pyramid.end(), bytes.begin(), bytes.end());
+            }
+        }
+        return writeSampleCache(cachePath, header, {{left.data(), left.size()},
+                                                    {right.data(), right.size()},
+                                                    {peaks_.leaves().data(), peaks_.leaves().size() * sizeof(Summary)},
+                                                    {pyramid.data(), pyramid.size()}});
+    }
+
+private:
+
+    friend class SampleStream<SampleType>;
+
+    bool decodeFile(const char *fileName) {
+        std::vector<uint8_t> buffer;
+        uint8_t header[9];
+
+        FILE * fileHandle = fopen(fileName, "rb");
+        if (!fileHandle) {
+            fprintf(stderr,
+                    "[SampeEntry] Error: File not found or not access(%s)",
+                    fileName);
+            return false;
+        }
+
+        size_t bytesRead = fread(header, 1, 8, fileHandle);
+        if (bytesRead != 8) {
+            fprintf(stderr,
+                    "[SampeEntry] Error: File empty or not access (%s)",
+                    fileName);
+            fclose(fileHandle);
+            return false;
+        }
+
+        size_t riffSize = analyseWavHeader(header);
+        if (riffSize == 0) {
+            fprintf(stderr,
+                    "[SampeEntry] Error: Wrong file format (not RIFF file in %s)",
+                    fileName);
+            fclose(fileHandle);
+            return false;
+        }
+
+        buffer.resize(riffSize + 1);
+        bytesRead = fread(buffer.data(), 1, riffSize, fileHandle);
+        fclose(fileHandle);
+
+        if (bytesRead != riffSize) {
+
+            fprintf(stderr,
+                    "[SampeEntry] Error: Corrupted file(%s)",
+                    fileName);
+            return false;
+        }
+
+        return analyseContainers(buffer.data(), riffSize, fileName);
+    }
+
+    static size_t encodedWidth(SampleCacheHeader::Encoding encoding) {
+        switch (encoding) {
+        case SampleCacheHeader::Float32:
+            return sizeof(float);
+        case SampleCacheHeader::Int16:
+            return sizeof(int16_t);
+        case SampleCacheHeader::Int32:
+            return sizeof(int32_t);
+        case SampleCacheHeader::Packed:
+            break;
+        }
+        return 0;
+    }
+
+    // the divisor the decoder scaled integer PCM by, so the cache gives back the same values
+    double integerScale() const {
+        return sourceBits_ == 8 ? 127.0 : sourceBits_ == 16 ? 32767.0 : 8388607.0;
+    }
+
+    std::vector<uint8_t> encode(SampleCacheHeader::Encoding encoding, const std::vector<SampleType>& buffer) const {
+        std::vector<uint8_t> bytes(buffer.size() * encodedWidth(encoding));
+        double scale = integerScale();
+        for (size_t i = 0; i < buffer.size(); i++) {
+            if (encoding == SampleCacheHeader::Int16) {
+                int16_t value = int16_t(lround(double(buffer[i]) * scale));
+                memcpy(&bytes[i * sizeof(value)], &value, sizeof(value));
+            } else if (encoding == SampleCacheHeader::Int32) {
+                int32_t value = int32_t(lround(double(buffer[i]) * scale));
+                memcpy(&bytes[i * sizeof(value)], &value, sizeof(value));
+            } else {
+                float value = float(buffer[i]);
+                memcpy(&bytes[i * sizeof(value)], &value, sizeof(value));
+            }
+        }
+        return bytes;
+    }
+
+    void decode(SampleCacheHeader::Encoding encoding, const uint8_t* data, size_t frames, std::vector<SampleType>& buffer) const {
+        buffer.resize(frames);
+        double scale = integerScale();
+        for (size_t i = 0; i < frames; i++) {
+            if (encoding == SampleCacheHeader::Int16) {
+                int16_t value;
+                memcpy(&value, data + i * sizeof(value), sizeof(value));
+                buffer[i] = value / scale;
+            } else if (encoding == SampleCacheHeader::Int32) {
+                int32_t value;
+                memcpy(&value, data + i * sizeof(value), sizeof(value));
+                buffer[i] = value / scale;
+            } else {
+                float value;
+                memcpy(&value, data + i * sizeof(value), sizeof(value));
+                buffer[i] = value;
+            }
+        }
+    }
+
+    // everything derived from the decoded buffers
+    void analyse() {
+        updateHash();
+        peaks_.build(soundBufferLeft_.data(), soundBufferRight_.data(), soundBufferLeft_.size());
+    }
+
+    void updateHash() {
+        // word wise FNV-1a, good enough to find identical decodes
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        auto mix = [&hash](const std::vector<SampleType>& buffer) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(buffer.data());
+            size_t length = buffer.size() * sizeof(SampleType);
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, bytes + i, sizeof(word));
+                hash = (hash ^ word) * 0x100000001b3ULL;
+            }
+            for (; i < length; i++) {
+                hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+            }
+        };
+        mix(soundBufferLeft_);
+        mix(soundBufferRight_);
+        hash_ = hash ^ (uint64_t(sampleRate_) << 32) ^ acidBeats_;
+    }
+
+    bool analyseContainers(uint8_t *buffer, size_t bufferSize, const char *resourceName) {
+
+        size_t iFormLength = analyseWavForm(buffer);
+        if (iFormLength == 0) {
+            fprintf(stderr,
+                    "[SampeEntry] Error: Wrong format (not WAVE form in %s)",
+                    resourceName);
+            return false;
+        }
+
+        uint16_t nCannels = 0;
+        uint32_t iSamplesPerSec = 0;
+        uint16_t iBitsPerSample = 0;
+        size_t iCursor = iFormLength + 12;
+        bool foundDataContainer = false;
+        size_t SoundBufferLength = 0;
+        if (!analysePCMCodec(buffer, nCannels, iSamplesPerSec, iBitsPerSample)) {
+            fprintf(stderr,
+                    "[SampeEntry] Error: Wrong format (not PCM wave in %s)",
+                    resourceName);
+            return false;
+        }
+
+        while (iCursor < (bufferSize - 8)) {
+
+            iFormLength = containerSize(buffer + iCursor + 4);
+
+            if (isDataContainer(buffer + iCursor)) {
+                foundDataContainer = true;
+                SoundBufferLength = iFormLength / (nCannels * iBitsPerSample / 8);
+                soundBufferLeft_.resize(SoundBufferLength + 1);
+                soundBufferRight_.resize(SoundBufferLength + 1);
+
+                uint8_t *Data = buffer + iCursor + 8;
+                unsigned step = nCannels * iBitsPerSample / 8;
+                for (unsigned i = 0; i < iFormLength; i = i + step) {
+
+                    for (unsigned j = 0; j < nCannels; j++) {
+                        uint32_t CannelData = getChannelData(Data + i, j, iBitsPerSample);
+                        SampleType FSample = convertToSample(CannelData, buffer[12], iBitsPerSample);
+
+                        switch (j) {
+                        case 0:
+                            soundBufferLeft_[i / step] = FSample;
+                            if (nCannels >= 2) {
+                                break;
+                            }
+                        case 1:
+                            soundBufferRight_[i / step] = FSample;
+                            break;
+                        default:
+                            break;
+                        }
+
+                    }
+                }
+                sampleRate_ = iSamplesPerSec;
+                sourceBits_ = ((buffer[12] == 1) && (iBitsPerSample <= 24)) ? iBitsPerSample : 0;
+            }
+
+            // TODO: analyze containers second time if ACID container is before Data
+            if (isAcidContainer(buffer + iCursor) && foundDataContainer) {
+                if (isLoop(buffer + iCursor)) {
+                    acidBeats_ = getAcidBeats(buffer + iCursor);
+                    acidMode_ = SampleCacheHeader::AcidLoop;
+                } else if (isOneShoot(buffer + iCursor)) {
+                    acidBeats_ = getAcidBeats(buffer + iCursor);
+                    acidMode_ = SampleCacheHeader::AcidOneShoot;
+                }
+            }
+            iCursor += iFormLength + 8;
+        }
+
+        if (!foundDataContainer) {
+            fprintf(stderr,
+                    "[SampeEntry] Error: Wrong format (not found 'data' container in %s)",
+                    resourceName);
+            return false;
+        }
+        return true;
+    }
+
+    size_t analyseWavHeader(uint8_t *header) {
+        if ((header[0] == 'R') && (header[1] == 'I') && (header[2] == 'F') && (header[3] == 'F')) {
+            return containerSize(header + 4);
+        }
+        return 0;
+    }
+
+    size_t analyseWavForm(uint8_t *form) {
+        if ((form[0] == 'W') && (form[1] == 'A') && (form[2] == 'V') &&
+            (form[3] == 'E') && (form[4] == 'f') && (form[5] == 'm') &&
+            (form[6] == 't') && (form[7] == ' ')) {
+            return containerSize(form + 8);
+        }
+        return 0;
+    }
+
+    bool analysePCMCodec(uint8_t *form, uint16_t &nCannels, uint32_t &iSamplesPerSec, uint16_t &iBitsPerSample) {
+        if ((((form[12] == 3)) || (form[12] == 1)) && (form[13] == 0)) {
+            nCannels = (form[14] & 0xff) + ((form[15] & 0xff) << 8);
+            iSamplesPerSec = (form[16] & 0xff) + ((form[17] & 0xff) << 8) +
+                             ((form[18] & 0xff) << 16) + ((form[19] & 0xff) << 24);
+            iBitsPerSample = (form[26] & 0xff) + ((form[27] & 0xff) << 8);
+            return true;
+        }
+        return false;
+    }
+
+    size_t containerSize(uint8_t *container) {
+        size_t length = container[3] & 0xff;
+        length = (length << 8) + (container[2] & 0xff);
+        length = (length << 8) + (container[1] & 0xff);
+        length = (length << 8) + (container[0] & 0xff);
+        return length;
+    }
+
+    bool isDataContainer(uint8_t *container) {
+        if ((container[0] == 'd') && (container[1] == 'a') &&
+            (container[2] == 't') && (container[3] == 'a')) {
+            return true;
+        }
+        return false;
+    }
+
+    bool isAcidContainer(uint8_t *container) {
+        if ((container[0] == 'a') && (container[1] == 'c') &&
+            (container[2] == 'i') && (container[3] == 'd')) {
+            return true;
+        }
+        return false;
+    }
+
+    bool isLoop(uint8_t *container) {
+        if ((container[8] == 0) || (container[8] == 2)) {
+            return true;
+        }
+        return false;
+    }
+
+    bool isOneShoot(uint8_t *container) {
+        if ((container[8] == 1) || (container[8] == 3)) {
+            return true;
+        }
+        return false;
+    }
+
+    uint8_t getAcidBeats(uint8_t *container) {
+        return container[20];
+    }
+
+    static uint32_t getChannelData(uint8_t *Buffer, uint8_t channel, uint8_t BitsPerSample) {
+        uint32_t cannelData = (Buffer[BitsPerSample / 8 - 1 + channel * BitsPerSample / 8] >= 0) ? 0. : 0xffffffff;
+        for (int k = BitsPerSample / 8 - 1; k >= 0; k--) {
+            cannelData = (cannelData << 8) + (Buffer[k + channel * BitsPerSample / 8] & 0xff);
+        }
+        return cannelData;
+    }
+
+    static SampleType convertToSample(uint32_t cannelData, uint8_t sampleType, uint8_t bitsPerSample) {
+        /**
+         *  Supported bitrates 8/16/24/32(IEEE Float)
+         **/
+        if (sampleType == 1) {
+            if (bitsPerSample == 8) {
+                return int8_t(cannelData) / 127.0;
+            }
+            if (bitsPerSample == 16) {
+                return int16_t(cannelData) / 32767.0;
+            }
+            if (bitsPerSample == 24) {
+                return int32_t(cannelData) / 8388607.0;
+            }
+        } else if (bitsPerSample == 32) { // 32bit IEEE Float
+            return *reinterpret_cast<float *>(&cannelData);
+        }
+        return 0.;
+    }
+
+    struct Level {
+        std::vector<SampleType> left;
+        std::vector<SampleType> right;
+    };
+
+    std::vector<SampleType> soundBufferLeft_;
+    std::vector<SampleType> soundBufferRight_;
+    Level pyramid_[PyramidLevels];
+    Packed packed_;
+    PeakPyramid<SampleType> peaks_;
+
+    size_t sampleRate_;
+    size_t acidBeats_;
+    AcidMode acidMode_;
+    uint32_t sourceBits_;   // integer PCM the buffers were scaled from, 0 - float
+    uint64_t hash_;
+};
+
+}
+}
@@ -1,11 +1,19 @@
 #pragma once
 
 #include "cuepoint.h"
-
+#include "phasecursor.h"
+#include "samplepool.h"
+#include "samplestream.h"
+#include "interpolation.h"
+#include "beatanalysis.h"
+#include "fastmath.h"
+
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <inttypes.h>
 #include <cmath>
+#include <memory>
 
 namespace Steinberg {
 namespace Vst {
@@ -15,6 +23,31 @@ class SampleEntry {
 public:
     using Type = SampleType;
     using CuePoint = Helper::CuePoint<int64_t, ParameterType>;
+    using Cursor = Helper::PhaseCursor;
+
+    using Data = SampleData<SampleType>;
+    using DataPtr = typename SamplePool<SampleType>::DataPtr;
+    using Stream = SampleStream<SampleType>;
+    using Packed = typename Data::Packed;
+
+    // one reader of the sample: where it is, its beat crossfade and its stream fade;
+    // the slot plays its own and effects keep theirs, the audio stays shared
+    struct Voice {
+        Cursor cursor;
+        Cursor overlapFirst;
+        Cursor overlapSecond;
+        ParameterType smoothOverlap {-1};
+        SampleType streamGain {0};
+        SampleType streamLeft {0};
+        SampleType streamRight {0};
+
+        CuePoint cue() const {
+            return cursor.cuePoint<CuePoint>();
+        }
+    };
+
+    // longest display copy sent to the editor
+    static constexpr size_t OverviewFrames = size_t(1) << 20;
 
     explicit SampleEntry(const char * name = nullptr, const char * fileName = nullptr) :
         Loop(false),
@@ -22,14 +55,23 @@ public:
         Reverse(false),
         Tune(1.),
         Level(1.),
-        currentBeat_(0),
-        sampleName_(name),
+        packed_(nullptr),
+        levels_(0),
+        left_(nullptr),
+        right_(nullptr),
+        length_(0),
+        sampleName_(name ? name : ""),
         index_(0),
         acidBeats_(0),
-        sampleRate_(0),
         beatLength_(0),
         beatOverlap_(0),
-        smoothOverlap_(-1)
+        beatOffset_(0),
+        slices_(0),
+        beatFrames_(0),
+        sampleRate_(0),
+        loading_(false),
+        evicted_(false),
+        interpolation_(InterpolationQuality::Hermite)
     {
         if (fileName) {
             loadFromFile(fileName);
@@ -42,17 +84,25 @@ public:
         Reverse(false),
         Tune(1.),
         Level(1.),
-        soundBufferRight_(right, right + size),
-        soundBufferLeft_(left, left + size),
-        currentBeat_(0),
-        sampleName_(name),
+        packed_(nullptr),
+        levels_(0),
+        left_(nullptr),
+        right_(nullptr),
+        length_(0),
+        sampleName_(name ? name : ""),
         index_(0),
         acidBeats_(0),
-        sampleRate_(0),
         beatLength_(0),
         beatOverlap_(0),
-        smoothOverlap_(-1)
+        beatOffset_(0),
+        slices_(0),
+        beatFrames_(0),
+        sampleRate_(0),
+        loading_(false),
+        evicted_(false),
+        interpolation_(InterpolationQuality::Hermite)
     {
+        assign(SamplePool<SampleType>::instance().share(left, right, size));
     }
 
     ~SampleEntry() {
@@ -75,90 +125,199 @@ public:
         return sampleFile_.c_str();
     }
 
-    bool loadFromFile(const char *fileName) {
+    // targetRate 0 plays the file at its own rate and converts on the fly,
+    // compress keeps integer PCM packed in memory (and at the file rate)
+    bool loadFromFile(const char *fileName, size_t targetRate = 0, bool compress = false) {
         clear();
 
-        std::vector<uint8_t> buffer;
-        uint8_t header[9];
-
-        FILE * fileHandle = fopen(fileName, "rb");
-        if (!fileHandle) {
-            fprintf(stderr,
-                    "[SampeEntry] Error: File not found or not access(%s)",
-                    fileName);
+        auto data = SamplePool<SampleType>::instance().load(fileName, targetRate, compress);
+        if (!data) {
             return false;
         }
-
-        size_t bytesRead = fread(header, 1, 8, fileHandle);
-        if (bytesRead != 8) {
-            fprintf(stderr,
-                    "[SampeEntry] Error: File empty or not access (%s)",
-                    fileName);
-            fclose(fileHandle);
-            return false;
+        assign(std::move(data));
+        if (data_->acidMode() != SampleCacheHeader::NoAcid) {
+            Loop = data_->acidMode() == SampleCacheHeader::AcidLoop;
+            Sync = true;
         }
+        sampleFile_ = fileName;
+        return true;
+    }
 
-        size_t riffSize = analyseWavHeader(header);
-        if (riffSize == 0) {
-            fprintf(stderr,
-                    "[SampeEntry] Error: Wrong file format (not RIFF file in %s)",
-                    fileName);
-            fclose(fileHandle);
+    // plays the file from disk, only the pages around the cursor stay in memory
+    bool openStream(const char *fileName) {
+        clear();
+
+        auto stream = std::make_shared<Stream>();
+        if (!stream->open(fileName, OverviewFrames)) {
             return false;
         }
+        stream_ = std::move(stream);
+        overview_ = stream_->overview();
+        layout(stream_->frames(), stream_->sampleRate(), stream_->acidBeats());
+        if (stream_->acidMode() != SampleCacheHeader::NoAcid) {
+            Loop = stream_->acidMode() == SampleCacheHeader::AcidLoop;
+            Sync = true;
+        }
+        sampleFile_ = fileName;
+        return true;
+    }
 
-        buffer.resize(riffSize + 1);
-        bytesRead = fread(buffer.data(), 1, riffSize, fileHandle);
-        fclose(fileHandle);
+    const std::shared_ptr<Stream>& stream() const {
+        return stream_;
+    }
 
-        if (bytesRead != riffSize) {
+    bool streaming() const {
+        return stream_ != nullptr;
+    }
 
-            fprintf(stderr,
-                    "[SampeEntry] Error: Corrupted file(%s)",
-                    fileName);
-            return false;
+    // shares already decoded audio, slot settings and cursors are left untouched
+    void assign(DataPtr data) {
+        data_ = std::move(data);
+        stream_.reset();
+        overview_ = (data_ && (data_->compressed() || (data_->size() > OverviewFrames))) ? data_->overview(OverviewFrames) : data_;
+        packed_ = (data_ && data_->compressed()) ? &data_->packed() : nullptr;
+        blocks_.attach(packed_);
+        left_ = data_ ? data_->left() : nullptr;
+        right_ = data_ ? data_->right() : nullptr;
+        length_ = data_ ? data_->size() : 0;
+        levels_ = data_ ? data_->levels() : 0;
+        for (size_t level = 0; level <= Data::PyramidLevels; level++) {
+            bool present = data_ && (level <= levels_);
+            levelLeft_[level] = present ? data_->left(level) : nullptr;
+            levelRight_[level] = present ? data_->right(level) : nullptr;
+            levelLength_[level] = present ? data_->size(level) : 0;
         }
+        layout(length_, data_ ? data_->sampleRate() : 0, data_ ? data_->acidBeats() : 0);
+    }
 
-        if (analyseContainers(buffer.data(), riffSize, fileName)) {
-            sampleFile_ = fileName;
-            return true;
+    const DataPtr& data() const {
+        return data_;
+    }
+
+    // what this slot keeps alive, shared audio is counted in full
+    size_t memorySize() const {
+        size_t bytes = blocks_.memorySize();
+        if (stream_) {
+            bytes += stream_->memorySize();
         }
-        return false;
+        if (data_) {
+            bytes += data_->memorySize();
+        }
+        if (overview_ && (overview_ != data_)) {
+            bytes += overview_->memorySize();
+        }
+        return bytes;
+    }
+
+    // drops the audio, name, file and slot settings stay for reloading it;
+    // release(DataPtr&&) takes the buffers so they can be freed elsewhere
+    template<typename Release>
+    void evict(Release&& release) {
+        release(std::move(data_));
+        release(std::move(overview_));
+        assign(nullptr);
+        voice_.cursor.clear();
+        voice_.overlapFirst.clear();
+        evicted_ = true;
+    }
+
+    bool evicted() const {
+        return evicted_;
+    }
+
+    // what the editor draws: the audio itself or a reduced copy of long and streamed entries
+    const DataPtr& overview() const {
+        return overview_;
     }
 
     void resetCursor() {
-        realCursor_.clear();
-        overlapCursorFirst_.clear();
+        voice_.cursor.clear();
+        voice_.overlapFirst.clear();
         beginLockStrobe();
     }
 
     bool moveCursor(ParameterType offset) {
-        if (soundBufferLeft_.size() >= 4) {
-            realCursor_ = calcNewCursor(offset);
+        if (length_ >= 4) {
+            voice_.cursor = calcNewCursor(voice_.cursor, offset);
             return true;
         }
         return false;
     }
 
     void cue(CuePoint newCue) {
-        realCursor_ = normalizeCue(newCue);
-        overlapCursorFirst_ = realCursor_;
+        voice_ = voiceAt(newCue, voice_);
+    }
+
+    CuePoint cue() const {
+        return voice_.cue();
     }
 
-    const CuePoint& cue() const {
-        return realCursor_;
+    // cue to a fractional frame, the way engines that move the cursor themselves report back
+    void seek(ParameterType position) {
+        ParameterType whole = floor(position);
+        voice_.cursor = normalizeCursor(Cursor(int64_t(whole), position - whole));
+        voice_.overlapFirst = voice_.cursor;
     }
 
     void beginLockStrobe() {
-        overlapCursorFirst_ = realCursor_;
-        smoothOverlap_ = -1;
+        voice_.overlapFirst = voice_.cursor;
+        voice_.smoothOverlap = -1;
+    }
+
+    // the slot's own voice, the one the deck plays and the cue calls move
+    Voice& voice() {
+        return voice_;
+    }
+
+    // a voice reading from cue on, crossfade and stream state taken over from like
+    Voice voiceAt(const CuePoint& cue, const Voice& like = Voice()) const {
+        Voice voice(like);
+        voice.cursor = normalizeCursor(Cursor(cue));
+        voice.overlapFirst = voice.cursor;
+        return voice;
     }
 
     void playStereoSample(SampleType *left, SampleType *right, ParameterType speed, ParameterType tempo, ParameterType sampleRate, bool changeCursors) {
-        if (Sync && (acidBeats_ > 0)) {
-            playStereoSampleTempo(left, right, speed * (ParameterType(sampleRate_) / ParameterType(sampleRate)), fabs(tempo * speed), sampleRate, changeCursors);
+        playStereoSample(voice_, left, right, speed, tempo, sampleRate, changeCursors);
+    }
+
+    void playStereoSample(Voice& voice, SampleType *left, SampleType *right, ParameterType speed, ParameterType tempo, ParameterType sampleRate, bool changeCursors) {
+        if (Sync && (beats() > 0)) {
+            playStereoSampleTempo(voice, left, right, speed * (ParameterType(sampleRate_) / ParameterType(sampleRate)), fabs(tempo * speed), sampleRate, changeCursors);
         } else {
-            playStereoSample(left, right, calcRealSpeed(speed, sampleRate), changeCursors);
+            playStereoSample(voice, left, right, calcRealSpeed(speed, sampleRate), changeCursors);
+        }
+    }
+
+    /**
+     *  Plays count voices at the same speed, left[i] and right[i] get voice i.
+     *  The speeds and the interpolation kernel are worked out once, then the voices
+     *  are read one after another; synced false plays at the plain speed whatever Sync says.
+     **/
+    void playVoices(Voice* const* voices, size_t count, SampleType* left, SampleType* right, ParameterType speed, ParameterType tempo, ParameterType sampleRate, bool synced = true) {
+        if (synced && Sync && (beats() > 0)) {
+            ParameterType rate = speed * (ParameterType(sampleRate_) / ParameterType(sampleRate));
+            ParameterType beatRate = fabs(tempo * speed);
+            for (size_t i = 0; i < count; i++) {
+                playStereoSampleTempo(*voices[i], left + i, right + i, rate, beatRate, sampleRate, true);
+            }
+            return;
+        }
+
+        ParameterType offset = calcRealSpeed(speed, sampleRate);
+        switch (interpolation_) {
+        case InterpolationQuality::Linear:
+            playVoices<LinearInterpolation>(voices, count, left, right, offset);
+            break;
+        case InterpolationQuality::Lagrange:
+            playVoices<LagrangeInterpolation>(voices, count, left, right, offset);
+            break;
+        case InterpolationQuality::Sinc:
+            playVoices<SincInterpolation>(voices, count, left, right, offset);
+            break;
+        default:
+            playVoices<HermiteInterpolation>(voices, count, left, right, offset);
+            break;
         }
     }
 
@@ -168,93 +327,102 @@ public:
                                ParameterType tempo,
                                ParameterType sampleRate,
                                bool changeCursors) {
+        playStereoSampleTempo(voice_, left, right, speed, tempo, sampleRate, changeCursors);
+    }
+
+    void playStereoSampleTempo(Voice& voice,
+                               SampleType* left,
+                               SampleType* right,
+                               ParameterType speed,
+                               ParameterType tempo,
+                               ParameterType sampleRate,
+                               bool changeCursors) {
         auto newSpeed = calcRealSpeed(speed, sampleRate);
         auto newTempoSpeed = calcTempoSpeed(speed, tempo, sampleRate);
 
-        CuePoint PushCue = calcNewCursor(newTempoSpeed);
-        CuePoint PushCue2 = realCursor_;
+        Cursor PushCue = calcNewCursor(voice.cursor, newTempoSpeed);
+        Cursor PushCue2 = voice.cursor;
         if ((newSpeed / newTempoSpeed) <= 1.3) {
-            if (checkOverlapEvent(PushCue, newTempoSpeed) && (smoothOverlap_ <= 0.00005)) {
-                overlapStrobe(newTempoSpeed, fabs(newSpeed));
+            if (checkOverlapEvent(voice, PushCue, newTempoSpeed) && (voice.smoothOverlap <= 0.00005)) {
+                overlapStrobe(voice, newTempoSpeed, fabs(newSpeed));
             } else {
-                realCursor_ = overlapCursorFirst_;
+                voice.cursor = voice.overlapFirst;
             }
         } else if ((newSpeed / newTempoSpeed) > 1.3) {
-            if (checkStratchEvent(PushCue, newSpeed, newTempoSpeed) && (smoothOverlap_ <= 0.00005)) {
-                stratchStrobe(PushCue);
+            if (checkStratchEvent(voice, PushCue, newSpeed, newTempoSpeed) && (voice.smoothOverlap <= 0.00005)) {
+                stratchStrobe(voice, PushCue);
             }
-            realCursor_ = overlapCursorFirst_;
+            voice.cursor = voice.overlapFirst;
         }
 
-        playStereoSample(left, right, newSpeed, true);
-        overlapCursorFirst_ = realCursor_;
+        playStereoSample(voice, left, right, newSpeed, true);
+        voice.overlapFirst = voice.cursor;
 
-        if (smoothOverlap_ > 0.0) {
-            realCursor_ = overlapCursorSecond_;
+        if (voice.smoothOverlap > 0.0) {
+            voice.cursor = voice.overlapSecond;
             SampleType OverlapLeft;
             SampleType OverlapRight;
-            playStereoSample(&OverlapLeft, &OverlapRight, newSpeed, true);
-            overlapCursorSecond_ = realCursor_;
-            ParameterType CorrectorCoef = (1. - cos(smoothOverlap_ * 2. * Pi)) / 10.;
+            playStereoSample(voice, &OverlapLeft, &OverlapRight, newSpeed, true);
+            voice.overlapSecond = voice.cursor;
+            ParameterType CorrectorCoef = (1. - fastmath::cos(voice.smoothOverlap * 2. * Pi)) / 10.;
 
-            *left = *left * (smoothOverlap_ + CorrectorCoef) + OverlapLeft * (1. - smoothOverlap_ + CorrectorCoef);
-            *right = *right * (smoothOverlap_ + CorrectorCoef) + OverlapRight * (1. - smoothOverlap_ + CorrectorCoef);
-            overlapCursorSecond_ = realCursor_;
+            *left = *left * (voice.smoothOverlap + CorrectorCoef) + OverlapLeft * (1. - voice.smoothOverlap + CorrectorCoef);
+            *right = *right * (voice.smoothOverlap + CorrectorCoef) + OverlapRight * (1. - voice.smoothOverlap + CorrectorCoef);
+            voice.overlapSecond = voice.cursor;
 
             if ((newSpeed / newTempoSpeed) <= 1.3) {
-                smoothOverlap_ -= (fabs(newTempoSpeed / (ParameterType(beatOverlap_) * newSpeed)));
-                if (smoothOverlap_ < 0.00001) {
-                    overlapCursorFirst_ = overlapCursorSecond_;
-                    smoothOverlap_ = -1;
+                voice.smoothOverlap -= (fabs(newTempoSpeed / (ParameterType(beatOverlap_) * newSpeed)));
+                if (voice.smoothOverlap < 0.00001) {
+                    voice.overlapFirst = voice.overlapSecond;
+                    voice.smoothOverlap = -1;
                 }
             } else {
-                smoothOverlap_ -= (2.3 / ParameterType(beatOverlap_));
-                if (smoothOverlap_ < 0.00001) {
-                    smoothOverlap_ = 0.00001;
+                voice.smoothOverlap -= (2.3 / ParameterType(beatOverlap_));
+                if (voice.smoothOverlap < 0.00001) {
+                    voice.smoothOverlap = 0.00001;
                 }
             }
         }
-        realCursor_ = changeCursors ? PushCue : PushCue2;
+        voice.cursor = changeCursors ? PushCue : PushCue2;
     }
 
     void playStereoSample(SampleType* Left, SampleType* Right, ParameterType offset, bool changeCursors) {
+        playStereoSample(voice_, Left, Right, offset, changeCursors);
+    }
 
-        if (soundBufferLeft_.size() >= 4) {
+    void playStereoSample(Voice& voice, SampleType* Left, SampleType* Right, ParameterType offset, bool changeCursors) {
+        switch (interpolation_) {
+        case InterpolationQuality::Linear:
+            playStereoSample<LinearInterpolation>(voice, Left, Right, offset, changeCursors);
+            break;
+        case InterpolationQuality::Lagrange:
+            playStereoSample<LagrangeInterpolation>(voice, Left, Right, offset, changeCursors);
+            break;
+        case InterpolationQuality::Sinc:
+            playStereoSample<SincInterpolation>(voice, Left, Right, offset, changeCursors);
+            break;
+        default:
+            playStereoSample<HermiteInterpolation>(voice, Left, Right, offset, changeCursors);
+            break;
+        }
+    }
 
-            CuePoint NewCursor = calcNewCursor(offset);
+    template<typename Kernel>
+    void playStereoSample(Voice& voice, SampleType* Left, SampleType* Right, ParameterType offset, bool changeCursors) {
 
-            SampleType Point0 = 0;
-            SampleType Point1 = soundBufferLeft_[NewCursor.integerPart()];
-            SampleType Point2 = 0;
-            SampleType Point3 = 0;
-            if (NewCursor.integerPart() > 0) {
-                Point0 = soundBufferLeft_[NewCursor.integerPart() - 1];
-            }
-            if (NewCursor.integerPart() < int64_t(soundBufferLeft_.size()) - 2) {
-                Point2 = soundBufferLeft_[NewCursor.integerPart() + 1];
-            }
-            if (NewCursor.integerPart() < int64_t(soundBufferLeft_.size()) - 3) {
-                Point3 = soundBufferLeft_[NewCursor.integerPart() + 2];
-            }
-            *Left = Level * hermite(NewCursor.floatPart(), Point0, Point1, Point2, Point3);
-
-            Point0 = 0;
-            Point1 = soundBufferRight_[NewCursor.integerPart()];
-            Point2 = 0;
-            Point3 = 0;
-            if (NewCursor.integerPart() > 0) {
-                Point0 = soundBufferRight_[NewCursor.integerPart() - 1];
-            }
-            if (NewCursor.integerPart() < int64_t(soundBufferRight_.size()) - 2) {
-                Point2 = soundBufferRight_[NewCursor.integerPart() + 1];
-            }
-            if (NewCursor.integerPart() < int64_t(soundBufferRight_.size()) - 3) {
-                Point3 = soundBufferRight_[NewCursor.integerPart() + 2];
+        if (length_ >= 4) {
+
+            Cursor NewCursor = calcNewCursor(voice.cursor, offset);
+            if (stream_) {
+                stream_->follow(NewCursor.integerPart(), offset, Loop);
             }
-            *Right = Level * hermite(NewCursor.floatPart(), Point0, Point1, Point2, Point3);
+            // a read that leaves the cursor where it is (the roll taps) passes a distance, not a rate
+            read<Kernel>(voice, NewCursor, changeCursors ? fabs(offset) : 1., Left, Right);
+            *Left *= Level;
+            *Right *= Level;
 
             if (changeCursors) {
-                realCursor_ = NewCursor;
+                voice.cursor = NewCursor;
             }
 
         } else {
@@ -262,10 +430,184 @@ public:
             *Right = 0;
         }
     }
+    /**
+     *  Reads count frames step apart from position on without touching the play cursor,
+     *  for engines that pick their own grains (key lock). Loops wrap around,
+     *  one shots read silence past their ends. The stream fade is kept in voice,
+     *  the caller's own, so the deck's fade is left alone.
+     **/
+    void render(Voice& voice, ParameterType position, ParameterType step, size_t count, SampleType* left, SampleType* right) {
+        switch (interpolation_) {
+        case InterpolationQuality::Linear:
+            render<LinearInterpolation>(voice, position, step, count, left, right);
+            break;
+        case InterpolationQuality::Lagrange:
+            render<LagrangeInterpolation>(voice, position, step, count, left, right);
+            break;
+        case InterpolationQuality::Sinc:
+            render<SincInterpolation>(voice, position, step, count, left, right);
+            break;
+        default:
+            render<HermiteInterpolation>(voice, position, step, count, left, right);
+            break;
+        }
+    }
+
+    template<typename Kernel>
+    void render(Voice& voice, ParameterType position, ParameterType step, size_t count, SampleType* left, SampleType* right) {
+        if (length_ < 4) {
+            std::fill(left, left + count, SampleType(0));
+            std::fill(right, right + count, SampleType(0));
+            return;
+        }
+
+        ParameterType whole = floor(position);
+        Cursor cursor(int64_t(whole), position - whole);
+        const int64_t increment = Cursor::increment(step);
+        const int64_t span = Cursor::span(length_);
+        const ParameterType rate = fabs(step);
+        if (Loop) {
+            cursor.wrap(span);
+        }
+        if (stream_) {
+            stream_->follow(cursor.integerPart(), step, Loop);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (!Loop && ((cursor.integerPart() < 0) || (cursor.integerPart() >= int64_t(length_)))) {
+                left[i] = 0;
+                right[i] = 0;
+            } else {
+                read<Kernel>(voice, cursor, rate, left + i, right + i);
+                left[i] *= Level;
+                right[i] *= Level;
+            }
+            cursor.step(increment);
+            if (Loop) {
+                cursor.wrap(span);
+            }
+        }
+    }
+
+    static constexpr size_t MaximumTaps = 16;
+
+    /**
+     *  Sums taps reads around the cursor without moving it, tap i first + i * spacing frames
+     *  away and weighted by gains[i] (the roll echoes). Both distances are rounded to whole
+     *  frames so every tap shares the cursor's fraction and the kernel weights are worked out once.
+     **/
+    void renderTaps(ParameterType first, ParameterType spacing, size_t taps, const SampleType* gains, SampleType* left, SampleType* right) {
+        switch (interpolation_) {
+        case InterpolationQuality::Linear:
+            renderTaps<LinearInterpolation>(first, spacing, taps, gains, left, right);
+            break;
+        case InterpolationQuality::Lagrange:
+            renderTaps<LagrangeInterpolation>(first, spacing, taps, gains, left, right);
+            break;
+        case InterpolationQuality::Sinc:
+            renderTaps<SincInterpolation>(first, spacing, taps, gains, left, right);
+            break;
+        default:
+            renderTaps<HermiteInterpolation>(first, spacing, taps, gains, left, right);
+            break;
+        }
+    }
+
+    template<typename Kernel>
+    void renderTaps(ParameterType first, ParameterType spacing, size_t taps, const SampleType* gains, SampleType* left, SampleType* right) {
+        *left = 0;
+        *right = 0;
+        if (length_ < 4) {
+            return;
+        }
+        taps = std::min(taps, MaximumTaps);
+
+        constexpr int Points = Kernel::Before + Kernel::After + 1;
+        const SampleType fraction = SampleType(voice_.cursor.floatPart());
+        SampleType weights[Points];
+        Kernel::weights(fraction, weights);
+
+        const int64_t length = int64_t(length_);
+        int64_t step = int64_t(std::llround(spacing));
+        int64_t position = voice_.cursor.integerPart() + int64_t(std::llround(first));
+        if (Loop) {
+            // wrapped once here, a step shorter than the loop needs one compare per tap
+            step %= length;
+            position %= length;
+            position += (position < 0) ? length : 0;
+        }
+        int64_t positions[MaximumTaps];
+        bool inside = !stream_ && !packed_;
+        for (size_t i = 0; i < taps; i++, position += step) {
+            if (Loop) {
+                position += (position >= length) ? -length : (position < 0) ? length : 0;
+            }
+            positions[i] = position;
+            inside = inside && (position >= Kernel::Before) && (position + Kernel::After < length);
+        }
+
+        SampleType tapLeft[MaximumTaps] = {};
+        SampleType tapRight[MaximumTaps] = {};
+        if (inside) {
+            // point by point across the taps, the inner loop is a gather the compiler can vectorise
+            const SampleType* bufferLeft = levelLeft_[0] - Kernel::Before;
+            const SampleType* bufferRight = levelRight_[0] - Kernel::Before;
+            for (int k = 0; k < Points; k++) {
+                const SampleType weight = weights[k];
+                for (size_t i = 0; i < taps; i++) {
+                    tapLeft[i] += weight * bufferLeft[positions[i] + k];
+                    tapRight[i] += weight * bufferRight[positions[i] + k];
+                }
+            }
+        } else {
+            // near the ends of one shots taps hold the edge frame, streams keep their own fade
+            Voice scratch;
+            scratch.streamGain = 1;
+            for (size_t i = 0; i < taps; i++) {
+                int64_t tap = std::clamp(positions[i], int64_t(0), length - 1);
+                Cursor cursor(tap, tap == positions[i] ? fraction : 0);
+                read<Kernel>(scratch, cursor, 1., tapLeft + i, tapRight + i);
+            }
+        }
+
+        SampleType sumLeft = 0;
+        SampleType sumRight = 0;
+        for (size_t i = 0; i < taps; i++) {
+            sumLeft += gains[i] * tapLeft[i];
+            sumRight += gains[i] * tapRight[i];
+        }
+        *left = sumLeft * Level;
+        *right = sumRight * Level;
+    }
+
+    // the same position brought into the sample the way the play cursor is
+    ParameterType normalizePosition(ParameterType position) const {
+        if (length_ == 0) {
+            return 0;
+        } else if (Loop) {
+            ParameterType length = ParameterType(length_);
+            position = fmod(position, length);
+            return position < 0 ? position + length : position;
+        }
+        return std::clamp(position, ParameterType(0), ParameterType(length_ - 1));
+    }
+
+    ParameterType position() const {
+        return voice_.cursor.asDouble();
+    }
+
+    // frames of the sample per host sample, as normal play and as tempo synced play
+    ParameterType realSpeed(ParameterType speed, ParameterType sampleRate) {
+        return calcRealSpeed(speed, sampleRate);
+    }
+
+    ParameterType tempoSpeed(ParameterType speed, ParameterType tempo, ParameterType sampleRate) {
+        return calcTempoSpeed(speed, tempo, sampleRate);
+    }
 
     ParameterType noteLength(ParameterType note, ParameterType tempo) {
-        if (Sync && (acidBeats_ > 0)) {
-            return ParameterType(soundBufferLeft_.size()) / acidBeats_ * note;
+        if (Sync && (beats() > 0)) {
+            return beatFrames_ * note;
         } else if (tempo > 0 && note > 0) {
             return ParameterType(sampleRate_) / tempo * 60. * note;
         }
@@ -273,43 +615,83 @@ public:
     }
 
     SampleType peakSample(size_t from_position, size_t to_position) {
-        if (from_position > soundBufferLeft_.size()) {
+        if (!data_ || (from_position > length_)) {
             return 0;
         }
 
-        if (to_position > soundBufferLeft_.size()) {
-            to_position = soundBufferLeft_.size();
+        if (to_position > length_) {
+            to_position = length_;
         }
 
         if (from_position > to_position) {
             std::swap(from_position, to_position);
         }
 
-        SampleType peak = 0;
-        for (size_t i = from_position; i < to_position; i++) {
-            if (peak < fabs(avgSample(i))) {
-                peak = fabs(avgSample(i));
-            }
-        }
-        return peak;
+        return data_->summary(from_position, to_position).peak();
     }
 
     ParameterType tempo() const {
-        return acidBeats_ > 0
-                   ? 60. / (ParameterType(bufferLength()) / ParameterType(sampleRate_)) * acidBeats_
-                   : 60. / (ParameterType(bufferLength()) / ParameterType(sampleRate_)) * defaultBeats;
+        return beatFrames_ > 0 ? 60. * ParameterType(sampleRate_) / beatFrames_ : 0;
     }
 
     size_t bufferLength() const {
-        return soundBufferLeft_.size();
+        return length_;
     }
 
     size_t acidBeats() const {
         return acidBeats_;
     }
 
+    size_t sampleRate() const {
+        return sampleRate_;
+    }
+
     void acidBeats(size_t beats) {
-        acidBeats_ = beats;
+        layout(length_, sampleRate_, beats);
+    }
+
+    // beats of the grid in use: the ACID chunk, else the analysis, 0 - unknown
+    size_t beats() const {
+        return acidBeats_ > 0 ? acidBeats_ : analysis_.beats;
+    }
+
+    // frames per beat and where the first one falls, as slicing and sync use them
+    ParameterType beatFrames() const {
+        return beatFrames_;
+    }
+
+    ParameterType firstBeat() const {
+        return (acidBeats_ > 0) ? 0 : analysis_.firstBeat;
+    }
+
+    // arrives from the loader some time after the audio
+    void analysis(const SampleAnalysis& result) {
+        analysis_ = result;
+        layout(length_, sampleRate_, acidBeats_);
+    }
+
+    const SampleAnalysis& analysis() const {
+        return analysis_;
+    }
+
+    // synced samples with a known grid hold and freeze from the grid line before the cue,
+    // the grid halved until its lines are at most frames apart
+    CuePoint beatCue(const CuePoint& cue, ParameterType frames) const {
+        if (!Sync || (beats() == 0) || (beatFrames_ <= 0) || (frames <= 0)) {
+            return cue;
+        }
+        ParameterType step = beatFrames_;
+        for (size_t i = 0; (i < 8) && (step > frames); i++) {
+            step *= 0.5;
+        }
+        ParameterType position = ParameterType(cue.integerPart()) + cue.floatPart() - firstBeat();
+        ParameterType snapped = floor(position / step) * step + firstBeat();
+        return CuePoint(int64_t(snapped), snapped - floor(snapped));
+    }
+
+    // identifies the audio behind the entry, for results that arrive later
+    const void* source() const {
+        return stream_ ? static_cast<const void*>(stream_.get()) : static_cast<const void*>(data_.get());
     }
 
     size_t index() const {
@@ -320,11 +702,27 @@ public:
         index_ = idx;
     }
 
+    bool loading() const {
+        return loading_;
+    }
+
+    InterpolationQuality interpolation() const {
+        return interpolation_;
+    }
+
+    void interpolation(InterpolationQuality quality) {
+        interpolation_ = quality;
+    }
+
+    void loading(bool state) {
+        loading_ = state;
+    }
+
     void clear() {
-        soundBufferLeft_.clear();
-        soundBufferRight_.clear();
-        realCursor_.clear();
-        overlapCursorFirst_.clear();
+        analysis_ = SampleAnalysis();
+        assign(nullptr);
+        voice_.cursor.clear();
+        voice_.overlapFirst.clear();
         Loop = false;
         Sync = false;
         Reverse = false;
@@ -333,27 +731,30 @@ public:
     }
 
     bool operator == (const SampleEntry & other) const {
-        return (other.soundBufferLeft_ == soundBufferLeft_) && (other.soundBufferRight_ == soundBufferRight_);
+        if (stream_ || other.stream_) {
+            return other.stream_ == stream_;
+        }
+        return (other.data_ == data_) || (other.data_ && data_ && (*other.data_ == *data_));
     }
 
     bool operator != (const SampleEntry & other) const {
-        return (other.soundBufferLeft_ != soundBufferLeft_) || (other.soundBufferRight_ != soundBufferRight_);
+        return !(*this == other);
     }
 
     SampleType left(size_t index) const {
-        return soundBufferLeft_[index];
+        return left_[index];
     }
 
     SampleType right(size_t index) const {
-        return soundBufferRight_[index];
+        return right_[index];
     }
 
     const SampleType* bufferLeft() const {
-        return soundBufferLeft_.data();
+        return left_;
     }
 
     const SampleType* bufferRight() const {
-        return soundBufferRight_.data();
+        return right_;
     }
 
     bool Loop;
@@ -363,11 +764,11 @@ public:
     ParameterType Level;
 
     SampleType getLeft(size_t index) const {
-        return soundBufferLeft_[index];
+        return left_[index];
     }
 
     SampleType getRight(size_t index) const {
-        return soundBufferRight_[index];
+        return right_[index];
     }
 
 private:
@@ -376,213 +777,266 @@ private:
     static constexpr ParameterType beatOverlapKoef = 1./2.;
     static constexpr size_t beatOverlapMultiple = 8;
     static constexpr SampleType Pi = 3.14159265358979323846264338327950288;
-
-
-    SampleType hermite(SampleType x, SampleType y0, SampleType y1, SampleType y2, SampleType y3) {
-        SampleType c0 = y1;
-        SampleType c1 = 0.5 * (y2 - y0);
-        SampleType c2 = y0 - 2.5 * y1 + 2. * y2 - 0.5 * y3;
-        SampleType c3 = 1.5 * (y1 - y2) + 0.5 * (y3 - y0);
-        return ((c3 * x + c2) * x + c1) * x + c0;
+    static constexpr SampleType streamRamp = 1. / 64.;
+
+    void layout(size_t length, size_t sampleRate, size_t acidBeats) {
+        length_ = length;
+        sampleRate_ = sampleRate;
+        acidBeats_ = acidBeats;
+
+        // the ACID chunk knows best, then the analysis, else the whole sample is defaultBeats long
+        if ((acidBeats_ == 0) && analysis_.valid() && (length_ > 0)) {
+            beatFrames_ = analysis_.beatLength;
+            beatLength_ = size_t(beatFrames_ / beatOverlapMultiple);
+            beatOffset_ = beatLength_ > 0 ? size_t(fmod(analysis_.firstBeat, ParameterType(beatLength_))) : 0;
+            slices_ = analysis_.beats * beatOverlapMultiple;
+        } else {
+            size_t beats = acidBeats_ > 0 ? acidBeats_ : size_t(defaultBeats);
+            beatFrames_ = ParameterType(length_) / ParameterType(beats);
+            beatLength_ = length_ > 0 ? (length_ - 1) / beats / beatOverlapMultiple : 0;
+            beatOffset_ = 0;
+            slices_ = beats * beatOverlapMultiple;
+        }
+        beatOverlap_ = beatLength_ * beatOverlapKoef;
     }
 
-    CuePoint calcNewCursor(ParameterType offset) {
-        CuePoint newCursor(realCursor_);
+    // index of the beat slice holding position
+    int64_t sliceOf(int64_t position) const {
+        if (beatLength_ == 0) {
+            return 0;
+        }
+        int64_t offset = position - int64_t(beatOffset_);
+        int64_t length = int64_t(beatLength_);
+        return (offset >= 0) ? offset / length : -((length - 1 - offset) / length);
+    }
 
-        ParameterType CurrentSpeed;
-        CurrentSpeed = offset;
+    template<typename Kernel>
+    void playVoices(Voice* const* voices, size_t count, SampleType* left, SampleType* right, ParameterType offset) {
+        for (size_t i = 0; i < count; i++) {
+            playStereoSample<Kernel>(*voices[i], left + i, right + i, offset, true);
+        }
+    }
 
-        if (!Loop) {
-            if ((newCursor.integerPart() == soundBufferLeft_.size() - 1) && (CurrentSpeed > 0)) {
-                return newCursor;
+    template<typename Kernel>
+    void read(Voice& voice, const Cursor& cursor, ParameterType rate, SampleType* left, SampleType* right) {
+        if (stream_) {
+            readStream<Kernel>(voice, cursor.integerPart(), SampleType(cursor.floatPart()), left, right);
+        } else if (packed_) {
+            readBlocks<Kernel>(cursor.integerPart(), SampleType(cursor.floatPart()), left, right);
+        } else if ((levels_ > 0) && (rate > 1.)) {
+            // faster than real time, read pre-filtered copies like texture mip levels
+            ParameterType detail = std::log2(rate);
+            size_t level = size_t(detail);
+            ParameterType blend = detail - ParameterType(level);
+            if (level >= levels_) {
+                level = levels_;
+                blend = 0;
             }
-            if ((newCursor.integerPart() == 0) && (CurrentSpeed < 0)) {
-                return newCursor;
+            ParameterType position = cursor.asDouble();
+            readLevel<Kernel>(level, position, left, right);
+            if (blend > 0) {
+                SampleType nextLeft;
+                SampleType nextRight;
+                readLevel<Kernel>(level + 1, position, &nextLeft, &nextRight);
+                *left += (nextLeft - *left) * blend;
+                *right += (nextRight - *right) * blend;
             }
+        } else {
+            readFrame<Kernel>(0, cursor.integerPart(), SampleType(cursor.floatPart()), left, right);
         }
-
-        newCursor += CurrentSpeed;
-        return normalizeCue(newCursor);
     }
 
-    bool analyseContainers(uint8_t *buffer, size_t bufferSize, const char *resourceName) {
-
-        size_t iFormLength = analyseWavForm(buffer);
-        if (iFormLength == 0) {
-            fprintf(stderr,
-                    "[SampeEntry] Error: Wrong format (not WAVE form in %s)",
-                    resourceName);
-            return false;
+    // missing pages fade the last good frame out and the stream back in when it arrives
+    template<typename Kernel>
+    void readStream(Voice& voice, int64_t position, SampleType fraction, SampleType* left, SampleType* right) {
+        constexpr int Taps = Kernel::Before + Kernel::After + 1;
+        SampleType pointsLeft[Taps];
+        SampleType pointsRight[Taps];
+        bool complete = true;
+        for (int k = 0; k < Taps; k++) {
+            int64_t index = position + k - Kernel::Before;
+            pointsLeft[k] = 0;
+            pointsRight[k] = 0;
+            if ((index >= 0) && (index < int64_t(length_))) {
+                complete = stream_->frame(index, pointsLeft[k], pointsRight[k]) && complete;
+            }
         }
 
-        uint16_t nCannels = 0;
-        uint32_t iSamplesPerSec = 0;
-        uint16_t iBitsPerSample = 0;
-        size_t iCursor = iFormLength + 12;
-        bool foundDataContainer = false;
-        size_t SoundBufferLength = 0;
-        if (!analysePCMCodec(buffer, nCannels, iSamplesPerSec, iBitsPerSample)) {
-            fprintf(stderr,
-                    "[SampeEntry] Error: Wrong format (not PCM wave in %s)",
-                    resourceName);
-            return false;
+        if (complete) {
+            voice.streamLeft = Kernel::interpolate(pointsLeft + Kernel::Before, fraction);
+            voice.streamRight = Kernel::interpolate(pointsRight + Kernel::Before, fraction);
+            voice.streamGain = std::min(SampleType(1), voice.streamGain + streamRamp);
+        } else {
+            voice.streamGain = std::max(SampleType(0), voice.streamGain - streamRamp);
         }
+        *left = voice.streamLeft * voice.streamGain;
+        *right = voice.streamRight * voice.streamGain;
+    }
 
-        while (iCursor < (bufferSize - 8)) {
-
-            iFormLength = containerSize(buffer + iCursor + 4);
+    // packed audio, the kernel reads a decoded block in place unless its points straddle two
+    template<typename Kernel>
+    void readBlocks(int64_t position, SampleType fraction, SampleType* left, SampleType* right) {
+        constexpr int64_t BlockFrames = int64_t(Packed::BlockFrames);
+        int64_t offset = position % BlockFrames;
+        if ((position >= 0) && (offset >= Kernel::Before) && (offset + Kernel::After < BlockFrames)) {
+            auto block = blocks_.fetch(size_t(position / BlockFrames));
+            *left = Kernel::interpolate(block.left + offset, fraction);
+            *right = Kernel::interpolate(block.right + offset, fraction);
+            return;
+        }
 
-            if (isDataContainer(buffer + iCursor)) {
-                foundDataContainer = true;
-                SoundBufferLength = iFormLength / (nCannels * iBitsPerSample / 8);
-                soundBufferLeft_.resize(SoundBufferLength + 1);
-                soundBufferRight_.resize(SoundBufferLength + 1);
+        constexpr int Taps = Kernel::Before + Kernel::After + 1;
+        SampleType pointsLeft[Taps];
+        SampleType pointsRight[Taps];
+        for (int k = 0; k < Taps; k++) {
+            int64_t index = position + k - Kernel::Before;
+            pointsLeft[k] = 0;
+            pointsRight[k] = 0;
+            if ((index >= 0) && (index < int64_t(length_))) {
+                auto block = blocks_.fetch(size_t(index / BlockFrames));
+                pointsLeft[k] = block.left[index % BlockFrames];
+                pointsRight[k] = block.right[index % BlockFrames];
+            }
+        }
+        *left = Kernel::interpolate(pointsLeft + Kernel::Before, fraction);
+        *right = Kernel::interpolate(pointsRight + Kernel::Before, fraction);
+    }
 
-                uint8_t *Data = buffer + iCursor + 8;
-                unsigned step = nCannels * iBitsPerSample / 8;
-                for (unsigned i = 0; i < iFormLength; i = i + step) {
+    template<typename Kernel>
+    void readLevel(size_t level, ParameterType position, SampleType* left, SampleType* right) {
+        ParameterType scaled = level > 0 ? ldexp(position, -int(level)) : position;
+        ParameterType whole = floor(scaled);
+        readFrame<Kernel>(level, int64_t(whole), SampleType(scaled - whole), left, right);
+    }
 
-                    for (unsigned j = 0; j < nCannels; j++) {
-                        uint32_t CannelData = getChannelData(Data + i, j, iBitsPerSample);
-                        SampleType FSample = convertToSample(CannelData, buffer[12], iBitsPerSample);
+    template<typename Kernel>
+    void readFrame(size_t level, int64_t position, SampleType fraction, SampleType* left, SampleType* right) {
+        const SampleType* bufferLeft = levelLeft_[level];
+        const SampleType* bufferRight = levelRight_[level];
+        int64_t length = int64_t(levelLength_[level]);
+
+        if ((fraction == 0) && (position >= 0) && (position < length)) {
+            // on a frame boundary (audio at host rate played at unity speed)
+            *left = bufferLeft[position];
+            *right = bufferRight[position];
+        } else if ((position >= Kernel::Before) && (position + Kernel::After < length)) {
+            *left = Kernel::interpolate(bufferLeft + position, fraction);
+            *right = Kernel::interpolate(bufferRight + position, fraction);
+        } else {
+            // near the edges, missing points read as silence
+            constexpr int Taps = Kernel::Before + Kernel::After + 1;
+            SampleType pointsLeft[Taps];
+            SampleType pointsRight[Taps];
+            for (int k = 0; k < Taps; k++) {
+                int64_t index = position + k - Kernel::Before;
+                bool inside = (index >= 0) && (index < length);
+                pointsLeft[k] = inside ? bufferLeft[index] : 0;
+                pointsRight[k] = inside ? bufferRight[index] : 0;
+            }
+            *left = Kernel::interpolate(pointsLeft + Kernel::Before, fraction);
+            *right = Kernel::interpolate(pointsRight + Kernel::Before, fraction);
+        }
+    }
 
-                        switch (j) {
-                        case 0:
-                            soundBufferLeft_[i / step] = FSample;
-                            if (nCannels >= 2) {
-                                break;
-                            }
-                        case 1:
-                            soundBufferRight_[i / step] = FSample;
-                            break;
-                        default:
-                            break;
-                        }
+    Cursor calcNewCursor(const Cursor& cursor, ParameterType offset) const {
+        Cursor newCursor(cursor);
 
-                    }
-                }
-                sampleRate_ = iSamplesPerSec;
-                beatLength_ = SoundBufferLength / defaultBeats / beatOverlapMultiple;
-                beatOverlap_ = beatLength_ * beatOverlapKoef;
+        ParameterType CurrentSpeed;
+        CurrentSpeed = offset;
 
+        if (!Loop) {
+            if ((newCursor.integerPart() == length_ - 1) && (CurrentSpeed > 0)) {
+                return newCursor;
             }
-
-            // TODO: analyze containers second time if ACID container is before Data
-            if (isAcidContainer(buffer + iCursor) && foundDataContainer) {
-                if (isLoop(buffer + iCursor)) {
-                    acidBeats_ = getAcidBeats(buffer + iCursor);
-                    beatLength_ = SoundBufferLength / acidBeats_ / beatOverlapMultiple;
-                    beatOverlap_ = beatLength_ * beatOverlapKoef;
-                    Loop = true;
-                    Sync = true;
-                } else if (isOneShoot(buffer + iCursor)) {
-                    acidBeats_ = getAcidBeats(buffer + iCursor);
-                    beatLength_ = SoundBufferLength / acidBeats_ / beatOverlapMultiple;
-                    beatOverlap_ = beatLength_ * beatOverlapKoef;
-                    Loop = false;
-                    Sync = true;
-                }
+            if ((newCursor.integerPart() == 0) && (CurrentSpeed < 0)) {
+                return newCursor;
             }
-            iCursor += iFormLength + 8;
         }
 
-        if (!foundDataContainer) {
-            fprintf(stderr,
-                    "[SampeEntry] Error: Wrong format (not found 'data' container in %s)",
-                    resourceName);
-            return false;
-        }
-        return true;
+        newCursor.step(Cursor::increment(CurrentSpeed));
+        return normalizeCursor(newCursor);
     }
 
-    bool checkOverlapEvent(CuePoint &cue, ParameterType offset) {
+    bool checkOverlapEvent(const Voice& voice, Cursor &cue, ParameterType offset) {
 
-        if (((offset > 0) && (cue < realCursor_))
-            || ((offset < 0) && (cue > realCursor_))) {
+        if (((offset > 0) && (cue < voice.cursor))
+            || ((offset < 0) && (cue > voice.cursor))) {
             return false;
         }
-        if (((realCursor_.integerPart()  + beatOverlap_) / beatLength_) != ((cue.integerPart() + beatOverlap_) / beatLength_)) {
+        if (sliceOf(voice.cursor.integerPart() + int64_t(beatOverlap_)) != sliceOf(cue.integerPart() + int64_t(beatOverlap_))) {
             return true;
         }
         return false;
     }
 
-    bool checkStratchEvent(CuePoint &cue, ParameterType speed, ParameterType speedtempo) {
-        if ((speedtempo > 0) && (cue > overlapCursorSecond_)) {
-            return (std::abs(overlapCursorSecond_.integerPart() + int64_t(soundBufferLeft_.size()) - cue.integerPart()) > int64_t(beatLength_ / 2));
-        } else if ((speedtempo < 0) && (cue < overlapCursorSecond_)) {
-            return (std::abs(overlapCursorSecond_.integerPart() - cue.integerPart() + int64_t(soundBufferLeft_.size())) > int64_t(beatLength_ / 2));
+    bool checkStratchEvent(const Voice& voice, Cursor &cue, ParameterType speed, ParameterType speedtempo) {
+        if ((speedtempo > 0) && (cue > voice.overlapSecond)) {
+            return (std::abs(voice.overlapSecond.integerPart() + int64_t(length_) - cue.integerPart()) > int64_t(beatLength_ / 2));
+        } else if ((speedtempo < 0) && (cue < voice.overlapSecond)) {
+            return (std::abs(voice.overlapSecond.integerPart() - cue.integerPart() + int64_t(length_)) > int64_t(beatLength_ / 2));
         } else {
-            return (std::abs(overlapCursorSecond_.integerPart() - cue.integerPart()) > int64_t(beatLength_ / 2));
+            return (std::abs(voice.overlapSecond.integerPart() - cue.integerPart()) > int64_t(beatLength_ / 2));
         }
         return false;
     }
 
-    void overlapStrobe(ParameterType speed, ParameterType tune) {
+    void overlapStrobe(Voice& voice, ParameterType speed, ParameterType tune) {
         if (speed < 0) {
-            overlapCursorSecond_.set(beatLength_ * normalizeStretchBeat(int64_t(realCursor_.integerPart() / beatLength_)) - beatOverlap_ * tune / speed, 0);
+            voice.overlapSecond.set(beatOffset_ + beatLength_ * normalizeStretchBeat(sliceOf(voice.cursor.integerPart())) - beatOverlap_ * tune / speed, 0);
         } else {
-            overlapCursorSecond_.set(beatLength_ * normalizeStretchBeat(int64_t(realCursor_.integerPart() / beatLength_) + 1) - beatOverlap_ * tune / speed, 0);
+            voice.overlapSecond.set(beatOffset_ + beatLength_ * normalizeStretchBeat(sliceOf(voice.cursor.integerPart()) + 1) - beatOverlap_ * tune / speed, 0);
         }
-        overlapCursorSecond_ = normalizeCue(overlapCursorSecond_);
-        realCursor_ = overlapCursorFirst_;
-        smoothOverlap_ = 1;
+        voice.overlapSecond = normalizeCursor(voice.overlapSecond);
+        voice.cursor = voice.overlapFirst;
+        voice.smoothOverlap = 1;
     }
 
-    void stratchStrobe(const CuePoint &cue) {
-        overlapCursorFirst_ = overlapCursorSecond_;
-        overlapCursorSecond_ = cue;
-        smoothOverlap_ = 1;
+    void stratchStrobe(Voice& voice, const Cursor &cue) {
+        voice.overlapFirst = voice.overlapSecond;
+        voice.overlapSecond = cue;
+        voice.smoothOverlap = 1;
     }
 
     int64_t normalizeStretchBeat(int64_t beat){
-        if (acidBeats_ > 0) {
+        int64_t slices = int64_t(slices_);
+        if (slices > 0) {
             if (Loop) {
-                return (beat >= int64_t(acidBeats_ * beatOverlapMultiple)) ? (beat % (acidBeats_ * beatOverlapMultiple)) : ((beat < 0) ? ((acidBeats_ * beatOverlapMultiple) + (beat % (acidBeats_ * beatOverlapMultiple))) : beat);
+                return (beat >= slices) ? (beat % slices) : ((beat < 0) ? (slices + (beat % slices)) % slices : beat);
             } else {
-                return (beat >= int64_t(acidBeats_ * beatOverlapMultiple)) ? int64_t(acidBeats_ * beatOverlapMultiple) - 1 : 0;
-            }
-        }
-        if constexpr (defaultBeats > 0) {
-            if (Loop) {
-                return (beat >= int64_t(defaultBeats * beatOverlapMultiple)) ? (beat % int64_t(defaultBeats * beatOverlapMultiple)) : ((beat < 0) ? (defaultBeats * beatOverlapMultiple + (beat % int64_t(defaultBeats * beatOverlapMultiple))) : beat);
-            } else {
-                return (beat >= int64_t(defaultBeats * beatOverlapMultiple)) ? defaultBeats * beatOverlapMultiple - 1 : 0;
+                return (beat >= slices) ? slices - 1 : 0;
             }
         }
         return 0;
     }
 
-    SampleEntry::CuePoint normalizeCue(const CuePoint& cue) {
-        CuePoint ret(cue);
-        if (Loop || ((ret.integerPart() >= 0) && (ret.integerPart() < int64_t(soundBufferLeft_.size())))) {
-
-            if ((ret.integerPart() >= int64_t(soundBufferLeft_.size()))) {
-
-                ret.set(ret.integerPart() % int64_t(soundBufferLeft_.size()), ret.floatPart());
-
-            }
-            if (ret.integerPart() < 0) {
-                ret.set(soundBufferLeft_.size() + ret.integerPart() % int64_t(soundBufferLeft_.size()), ret.floatPart());
-
-            }
-
-        } else {
-            if (ret.integerPart() >= int64_t(soundBufferLeft_.size())) {
-
-                ret.set(int64_t(soundBufferLeft_.size()) - 1, 0);
-
-            }
-            if (ret.integerPart() < 0) {
-                ret.set(0, 0);
-
-            }
+    Cursor normalizeCursor(const Cursor& cursor) const {
+        Cursor ret(cursor);
+        if (length_ == 0) {
+            // still loading or failed to load, nothing to wrap around
+            ret.clear();
+        } else if (Loop) {
+            ret.wrap(Cursor::span(length_));
+        } else if (ret.integerPart() >= int64_t(length_)) {
+            ret.set(int64_t(length_) - 1, 0);
+        } else if (ret.integerPart() < 0) {
+            ret.set(0, 0);
         }
         return ret;
     }
 
-    std::vector<SampleType> soundBufferLeft_;
-    std::vector<SampleType> soundBufferRight_;
+    DataPtr data_;
+    DataPtr overview_;
+    std::shared_ptr<Stream> stream_;
+    const Packed* packed_;
+    BlockCache<SampleType> blocks_;
+    const SampleType* levelLeft_[Data::PyramidLevels + 1];
+    const SampleType* levelRight_[Data::PyramidLevels + 1];
+    size_t levelLength_[Data::PyramidLevels + 1];
+    size_t levels_;
+
+    const SampleType* left_;
+    const SampleType* right_;
+    size_t length_;
 
     std::string sampleName_;
     std::string sampleFile_;
@@ -591,123 +1045,26 @@ private:
     size_t acidBeats_;
     size_t beatLength_;
     size_t beatOverlap_;
+    size_t beatOffset_;
+    size_t slices_;
+    ParameterType beatFrames_;
+    SampleAnalysis analysis_;
     size_t sampleRate_;
-    size_t currentBeat_;
-
-    CuePoint realCursor_;
-    CuePoint overlapCursorFirst_;
-    CuePoint overlapCursorSecond_;
-
-    ParameterType smoothOverlap_;
-
-
-    size_t analyseWavHeader(uint8_t *header) {
-        if ((header[0] == 'R') && (header[1] == 'I') && (header[2] == 'F') && (header[3] == 'F')) {
-            return containerSize(header + 4);
-        }
-        return 0;
-    }
-
-    size_t analyseWavForm(uint8_t *form) {
-        if ((form[0] == 'W') && (form[1] == 'A') && (form[2] == 'V') &&
-            (form[3] == 'E') && (form[4] == 'f') && (form[5] == 'm') &&
-            (form[6] == 't') && (form[7] == ' ')) {
-            return containerSize(form + 8);
-        }
-        return 0;
-    }
-
-    bool analysePCMCodec(uint8_t *form, uint16_t &nCannels, uint32_t &iSamplesPerSec, uint16_t &iBitsPerSample) {
-        if ((((form[12] == 3)) || (form[12] == 1)) && (form[13] == 0)) {
-            nCannels = (form[14] & 0xff) + ((form[15] & 0xff) << 8);
-            iSamplesPerSec = (form[16] & 0xff) + ((form[17] & 0xff) << 8) +
-                             ((form[18] & 0xff) << 16) + ((form[19] & 0xff) << 24);
-            iBitsPerSample = (form[26] & 0xff) + ((form[27] & 0xff) << 8);
-            return true;
-        }
-        return false;
-    }
-
-    size_t containerSize(uint8_t *container) {
-        size_t length = container[3] & 0xff;
-        length = (length << 8) + (container[2] & 0xff);
-        length = (length << 8) + (container[1] & 0xff);
-        length = (length << 8) + (container[0] & 0xff);
-        return length;
-    }
-
-    bool isDataContainer(uint8_t *container) {
-        if ((container[0] == 'd') && (container[1] == 'a') &&
-            (container[2] == 't') && (container[3] == 'a')) {
-            return true;
-        }
-        return false;
-    }
-
-    bool isAcidContainer(uint8_t *container) {
-        if ((container[0] == 'a') && (container[1] == 'c') &&
-            (container[2] == 'i') && (container[3] == 'd')) {
-            return true;
-        }
-        return false;
-    }
 
-    bool isLoop(uint8_t *container) {
-        if ((container[8] == 0) || (container[8] == 2)) {
-            return true;
-        }
-        return false;
-    }
+    Voice voice_;
 
-    bool isOneShoot(uint8_t *container) {
-        if ((container[8] == 1) || (container[8] == 3)) {
-            return true;
-        }
-        return false;
-    }
-
-    uint8_t getAcidBeats(uint8_t *container) {
-        return container[20];
-    }
-
-    uint32_t getChannelData(uint8_t *Buffer, uint8_t channel, uint8_t BitsPerSample) {
-        uint32_t cannelData = (Buffer[BitsPerSample / 8 - 1 + channel * BitsPerSample / 8] >= 0) ? 0. : 0xffffffff;
-        for (int k = BitsPerSample / 8 - 1; k >= 0; k--) {
-            cannelData = (cannelData << 8) + (Buffer[k + channel * BitsPerSample / 8] & 0xff);
-        }
-        return cannelData;
-    }
+    bool loading_;
+    bool evicted_;
+    InterpolationQuality interpolation_;
 
     inline int sign(ParameterType val) {
         return (val > 0) ? 1 : (val < 0) ? -1 : 0;
     }
 
-    SampleType convertToSample(uint32_t cannelData, uint8_t sampleType, uint8_t bitsPerSample) {
-        /**
-         *  Supported bitrates 8/16/24/32(IEEE Float)
-         **/
-        if (sampleType == 1) {
-            if (bitsPerSample == 8) {
-                return int8_t(cannelData) / 127.0;
-            }
-            if (bitsPerSample == 16) {
-                return int16_t(cannelData) / 32767.0;
-            }
-            if (bitsPerSample == 24) {
-                return int32_t(cannelData) / 8388607.0;
-            }
-        } else if (bitsPerSample == 32) { // 32bit IEEE Float
-            return *reinterpret_cast<float *>(&cannelData);
-        }
-        return 0.;
-    }
-
     ParameterType calcTempoSpeed(ParameterType speed, ParameterType tempo, ParameterType sampleRate) {
         ParameterType dir = Reverse? -sign(speed) : sign(speed);
-        if ((acidBeats_ > 0) && (sampleRate > 0)) {
-            return dir * soundBufferLeft_.size() * tempo / 60. / sampleRate / acidBeats_;
-        } else if (sampleRate > 0) {
-            return dir * soundBufferLeft_.size() * tempo / 60. / sampleRate / defaultBeats;
+        if (sampleRate > 0) {
+            return dir * beatFrames_ * tempo / 60. / sampleRate;
         }
         return calcRealSpeed(speed, sampleRate);
     }
@@ -716,14 +1073,6 @@ private:
         ParameterType dir = Reverse ? -1 : 1;
         return (sampleRate > 0) ? speed * Tune * (ParameterType(sampleRate_) / ParameterType(sampleRate)) * dir : 0;
     }
-
-    SampleType avgSample(size_t position) {
-        if (position < soundBufferLeft_.size()) {
-            return (soundBufferLeft_[position] +
-                    soundBufferRight_[position]) / 2.0;
-        }
-        return 0;
-    }
 };
 
 }
@@ -0,0 +1,450 @@
+#pragma once
+
+#include "sampleentry.h"
+#include "lockfreequeue.h"
+#include "beatanalysis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Decodes sample files on a pool of background threads.
+ *  Finished entries are handed to the audio thread through a lock-free queue,
+ *  entries it drops are sent back the same way so nothing is freed inside process().
+ *  One more thread keeps the page windows of streamed entries filled.
+ *  Once nothing is left to load the workers analyse what they loaded
+ *  (tempo, beat grid, loudness), the results follow through another queue.
+ **/
+template<typename SampleType>
+class SampleLoader {
+public:
+    using Entry = SampleEntry<SampleType>;
+    using DataPtr = typename Entry::DataPtr;
+
+    enum Priority {
+        Background = 0,
+        Scene,
+        Current
+    };
+
+    // per slot values restored from a saved state, they override the file defaults
+    struct Settings {
+        bool Loop;
+        bool Sync;
+        bool Reverse;
+        double Tune;
+        double Level;
+    };
+
+    // which slot a load is for: the id stays with the slot when others are removed,
+    // the generation tells apart the loads asked for one slot, later ones win
+    struct Ticket {
+        size_t index {0};          // where the slot was when the load was asked for
+        uint64_t slot {0};
+        uint64_t generation {0};
+    };
+
+    struct Loaded {
+        Ticket ticket;
+        std::unique_ptr<Entry> entry;
+    };
+
+    struct Analyzed {
+        Ticket ticket;                   // load the analysis was made for
+        const void* source {nullptr};    // and the audio it had then
+        SampleAnalysis analysis;
+    };
+
+    SampleLoader()
+        : knownClock_(0)
+        , running_(false)
+        , targetRate_(0)
+        , streamingFrames_(0)
+        , compressFrames_(0)
+        , batch_(0)
+        , batchStart_(0)
+        , batchPending_(0)
+        , batchElapsed_(0)
+    {}
+
+    ~SampleLoader() {
+        stop();
+    }
+
+    void start(size_t threads = 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            running_ = true;
+            for (size_t i = 0; i < threads; i++) {
+                workers_.emplace_back([this]() { run(); });
+            }
+            streamer_ = std::thread([this]() { stream(); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            running_ = false;
+            jobs_.clear();
+            studies_.clear();
+        }
+        wakeup_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+        streamer_.join();
+        {
+            std::lock_guard<std::mutex> lock(streamsMutex_);
+            streams_.clear();
+        }
+
+        Loaded loaded;
+        while (ready_.pop(loaded)) {
+            loaded.entry.reset();
+        }
+        Analyzed analyzed;
+        while (analyzed_.pop(analyzed)) {
+        }
+        collectRetired();
+    }
+
+    size_t threads() const {
+        return workers_.size();
+    }
+
+    // rate the following loads are converted to, 0 - keep the file's own rate
+    void targetRate(size_t rate) {
+        targetRate_ = rate;
+    }
+
+    size_t targetRate() const {
+        return targetRate_;
+    }
+
+    // files longer than this are streamed from disk, 0 - never
+    void streamingFrames(size_t frames) {
+        streamingFrames_ = frames;
+    }
+
+    // files longer than this are kept losslessly packed in memory, 0 - never
+    void compressFrames(size_t frames) {
+        compressFrames_ = frames;
+    }
+
+    // message thread, batch - the load is one of the batch begun last
+    void load(const Ticket& ticket,
+              const char* name,
+              const char* fileName,
+              Priority priority = Current,
+              std::optional<Settings> settings = std::nullopt,
+              bool batch = false) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto position = std::find_if(jobs_.begin(), jobs_.end(), [priority](const Job& job) { return job.priority < priority; });
+            jobs_.insert(position, Job{ticket, name ? name : "", fileName ? fileName : "", priority, settings, batch ? batch_.load() : 0});
+        }
+        wakeup_.notify_one();
+    }
+
+    // message thread, the following count batch loads (a restored state) are timed together
+    void beginBatch(size_t count) {
+        batchElapsed_ = 0;
+        batchStart_ = std::chrono::steady_clock::now().time_since_epoch().count();
+        batchPending_ = count;
+        batch_++;
+    }
+
+    // how long the batch begun last took until its last entry was handed over, 0 - still loading
+    std::chrono::steady_clock::duration batchTime() const {
+        return std::chrono::steady_clock::duration(batchElapsed_.load());
+    }
+
+    // audio thread
+    bool fetch(Loaded& loaded) {
+        if (retired_.full()) {
+            return false;
+        }
+        return ready_.pop(loaded);
+    }
+
+    // audio thread
+    bool fetch(Analyzed& analyzed) {
+        return analyzed_.pop(analyzed);
+    }
+
+    // audio thread, whether count more entries can be retired. Nothing retired may be
+    // freed on the audio thread, so callers hold their work back until there is room
+    bool canRetire(size_t count = 1) const {
+        return retired_.size() + count <= queueSize;
+    }
+
+    bool canRetireData(size_t count = 1) const {
+        return retiredData_.size() + count <= queueSize;
+    }
+
+    // audio thread, only after canRetire(); false leaves the entry with the caller
+    bool retire(std::unique_ptr<Entry>&& entry) {
+        return !entry || retired_.push(std::move(entry));
+    }
+
+    // audio thread, audio dropped from an entry that stays, only after canRetireData()
+    bool retire(DataPtr&& data) {
+        return !data || retiredData_.push(std::move(data));
+    }
+
+private:
+
+    static constexpr size_t queueSize = 256;
+    static constexpr size_t knownSize = 256;   // analyses kept for reloads
+    static constexpr auto idlePeriod = std::chrono::milliseconds(50);
+    static constexpr auto streamPeriod = std::chrono::milliseconds(2);
+
+    struct Job {
+        Ticket ticket;
+        std::string name;
+        std::string fileName;
+        Priority priority;
+        std::optional<Settings> settings;
+        uint64_t batch;          // 0 - not part of a batch
+    };
+
+    struct Study {
+        Ticket ticket;
+        const void* source;
+        DataPtr data;            // decoded or packed audio, empty for streamed entries
+        std::string fileName;
+        std::string fileKey;     // path, size and mtime of the source, empty - not kept
+        size_t sampleRate;
+    };
+
+    struct Known {
+        size_t sampleRate;
+        SampleAnalysis analysis;
+        uint64_t used;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_) {
+            wakeup_.wait_for(lock, idlePeriod, [this]() { return !running_ || !jobs_.empty() || !studies_.empty(); });
+            collectRetired();
+            if (!running_) {
+                continue;
+            }
+
+            if (!jobs_.empty()) {
+                Job job = std::move(jobs_.front());
+                jobs_.pop_front();
+                lock.unlock();
+                std::optional<Study> study = perform(job);
+                lock.lock();
+                if (study) {
+                    studies_.push_back(std::move(*study));
+                    wakeup_.notify_one();
+                }
+            } else if (!studies_.empty()) {
+                Study study = std::move(studies_.front());
+                studies_.pop_front();
+                auto known = analyses_.find(study.fileKey);
+                if ((known == analyses_.end()) || (known->second.sampleRate == 0)) {
+                    lock.unlock();
+                    SampleAnalysis analysis = analyze(study);
+                    lock.lock();
+                    known = remember(study.fileKey, Known{study.sampleRate, analysis, 0});
+                }
+                known->second.used = ++knownClock_;
+                // also what was seen before at another rate, reloads after eviction or conversion
+                double ratio = double(study.sampleRate) / double(known->second.sampleRate);
+                SampleAnalysis analysis = known->second.analysis.scaled(ratio);
+                if (study.fileKey.empty()) {
+                    analyses_.erase(known);
+                }
+                if (!analyzed_.push(Analyzed{study.ticket, study.source, analysis})) {
+                    // the audio thread is not collecting, the result is kept for later
+                    study.data.reset();
+                    studies_.push_back(std::move(study));
+                    wakeup_.wait_for(lock, idlePeriod);
+                }
+            }
+        }
+    }
+
+    std::optional<Study> perform(const Job& job) {
+        Loaded loaded;
+        loaded.ticket = job.ticket;
+        loaded.entry = std::make_unique<Entry>(job.name.c_str());
+        typename Entry::Stream::Format format;
+        bool probed = ((streamingFrames_ > 0) || (compressFrames_ > 0))
+                      && Entry::Stream::probe(job.fileName.c_str(), format);
+        if (probed && (streamingFrames_ > 0) && (format.frames > streamingFrames_)) {
+            if (loaded.entry->openStream(job.fileName.c_str())) {
+                std::lock_guard<std::mutex> lock(streamsMutex_);
+                streams_.push_back(loaded.entry->stream());
+            }
+        } else {
+            bool compress = probed && (compressFrames_ > 0) && (format.frames > compressFrames_);
+            loaded.entry->loadFromFile(job.fileName.c_str(), targetRate_, compress);
+        }
+        if (job.settings) {
+            loaded.entry->Loop = job.settings->Loop;
+            loaded.entry->Sync = job.settings->Sync;
+            loaded.entry->Reverse = job.settings->Reverse;
+            loaded.entry->Tune = job.settings->Tune;
+            loaded.entry->Level = job.settings->Level;
+        }
+
+        std::optional<Study> study;
+        if (loaded.entry->source() && (loaded.entry->sampleRate() > 0)) {
+            // the analysis is made at the file's rate and scaled to others, so the rate is not part of the key
+            study = Study{job.ticket, loaded.entry->source(), loaded.entry->data(), job.fileName,
+                          sampleFileKey(job.fileName.c_str(), sizeof(SampleType)), loaded.entry->sampleRate()};
+        }
+        publish(std::move(loaded));
+        finishBatchJob(job.batch);
+        return study;
+    }
+
+    // reads the audio once more front to back, packed blocks decoded and streamed files from disk
+    // under mutex_, the least recently used analysis goes when the map is full
+    typename std::map<std::string, Known>::iterator remember(const std::string& fileKey, Known&& known) {
+        if ((analyses_.size() >= knownSize) && (analyses_.find(fileKey) == analyses_.end())) {
+            auto oldest = std::min_element(analyses_.begin(), analyses_.end(), [](const auto& a, const auto& b) {
+                return a.second.used < b.second.used;
+            });
+            analyses_.erase(oldest);
+        }
+        return analyses_.insert_or_assign(fileKey, std::move(known)).first;
+    }
+
+    static SampleAnalysis analyze(const Study& study) {
+        BeatAnalyzer<SampleType> analyzer(study.sampleRate);
+        if (!study.data) {
+            Entry::Stream::scan(study.fileName.c_str(), [&analyzer](const SampleType* left, const SampleType* right, size_t count) {
+                analyzer.add(left, right, count);
+            });
+        } else if (study.data->compressed()) {
+            const auto& packed = study.data->packed();
+            constexpr size_t BlockFrames = Entry::Packed::BlockFrames;
+            std::vector<SampleType> left(BlockFrames);
+            std::vector<SampleType> right(BlockFrames);
+            for (size_t block = 0; block < packed.blocks(); block++) {
+                packed.decode(block, left.data(), right.data());
+                analyzer.add(left.data(), right.data(), std::min(BlockFrames, packed.frames() - block * BlockFrames));
+            }
+        } else {
+            analyzer.add(study.data->left(), study.data->right(), study.data->size());
+        }
+        return analyzer.finish();
+    }
+
+    void stream() {
+        std::vector<std::shared_ptr<typename Entry::Stream>> active;
+        while (running_) {
+            {
+                std::lock_guard<std::mutex> lock(streamsMutex_);
+                streams_.erase(std::remove_if(streams_.begin(), streams_.end(), [](const auto& weak) { return weak.expired(); }), streams_.end());
+                for (auto& weak : streams_) {
+                    if (auto stream = weak.lock()) {
+                        active.push_back(std::move(stream));
+                    }
+                }
+            }
+            bool busy = false;
+            for (auto& stream : active) {
+                busy = stream->service() || busy;
+            }
+            active.clear();
+            if (!busy) {
+                std::this_thread::sleep_for(streamPeriod);
+            }
+        }
+    }
+
+    void publish(Loaded&& loaded) {
+        std::lock_guard<std::mutex> lock(readyMutex_);
+        while (!ready_.push(std::move(loaded)) && running_) {
+            collectRetired();
+            std::this_thread::sleep_for(idlePeriod);
+        }
+    }
+
+    // loads of an earlier batch, conversions and reloads leave the count alone
+    void finishBatchJob(uint64_t batch) {
+        if ((batch == 0) || (batch != batch_.load())) {
+            return;
+        }
+        size_t pending = batchPending_.load();
+        while (pending > 0 && !batchPending_.compare_exchange_weak(pending, pending - 1)) {
+        }
+        if (pending == 1) {
+            batchElapsed_ = std::chrono::steady_clock::now().time_since_epoch().count() - batchStart_.load();
+        }
+    }
+
+    void collectRetired() {
+        std::unique_lock<std::mutex> lock(retiredMutex_, std::try_to_lock);
+        if (lock) {
+            std::unique_ptr<Entry> entry;
+            while (retired_.pop(entry)) {
+                entry.reset();
+            }
+            DataPtr data;
+            while (retiredData_.pop(data)) {
+                data.reset();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<Job> jobs_;
+    std::deque<Study> studies_;
+    std::map<std::string, Known> analyses_;   // by sampleFileKey, kept for reloads
+    uint64_t knownClock_;
+    std::atomic<bool> running_;
+    std::atomic<size_t> targetRate_;
+    std::atomic<size_t> streamingFrames_;
+    std::atomic<size_t> compressFrames_;
+
+    std::thread streamer_;
+    std::mutex streamsMutex_;
+    std::vector<std::weak_ptr<typename Entry::Stream>> streams_;
+
+    // written by the message thread and read by the workers, times in steady clock ticks
+    std::atomic<uint64_t> batch_;
+    std::atomic<std::chrono::steady_clock::rep> batchStart_;
+    std::atomic<size_t> batchPending_;
+    std::atomic<std::chrono::steady_clock::rep> batchElapsed_;
+
+    // loader threads serialise among themselves, the audio side stays lock-free
+    std::mutex readyMutex_;
+    std::mutex retiredMutex_;
+    LockFreeQueue<Loaded, queueSize> ready_;
+    LockFreeQueue<std::unique_ptr<Entry>, queueSize> retired_;
+    LockFreeQueue<DataPtr, queueSize> retiredData_;
+    LockFreeQueue<Analyzed, queueSize> analyzed_;   // pushed under mutex_
+};
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "sampledata.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Steinberg {
+namespace Vst {
+
+/**
+ *  Process wide registry of decoded audio.
+ *  Identical content is kept once and shared by reference count between all slots
+ *  and plugin instances, the pool itself only holds weak references.
+ **/
+template<typename SampleType>
+class SamplePool {
+public:
+    using Data = SampleData<SampleType>;
+    using DataPtr = std::shared_ptr<const Data>;
+
+    static SamplePool& instance() {
+        static SamplePool pool;
+        return pool;
+    }
+
+    // targetRate 0 keeps the file's own rate, otherwise the audio is converted once
+    // and the converted copy is pooled and cached on disk on its own key.
+    // compress packs integer PCM losslessly; the codec holds the file's own quantisation
+    // only, so packed audio keeps the file rate and is converted while playing
+    DataPtr load(const char* fileName, size_t targetRate = 0, bool compress = false) {
+        std::string fileKey = sampleFileKey(fileName, sizeof(SampleType), compress ? 0 : targetRate);
+        if (!fileKey.empty() && compress) {
+            fileKey += packedKeySuffix;
+        }
+        if (!fileKey.empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = byFile_.find(fileKey);
+            if (found != byFile_.end()) {
+                if (auto data = found->second.lock()) {
+                    return data;
+                }
+            }
+        }
+
+        auto data = std::make_shared<Data>();
+        if (compress) {
+            if (!data->loadPacked(fileName)) {
+                // float files, the plain decode is on disk by now
+                return load(fileName, targetRate);
+            }
+        } else if (targetRate == 0) {
+            if (!data->loadFromFile(fileName)) {
+                return nullptr;
+            }
+        } else {
+            std::string cachePath = sampleCachePath(fileName, sizeof(SampleType), targetRate);
+            if (cachePath.empty() || !data->loadFromCache(cachePath)) {
+                auto source = load(fileName);
+                if (!source) {
+                    return nullptr;
+                }
+                if ((source->sampleRate() == targetRate) || (source->sampleRate() == 0)) {
+                    return source;
+                }
+                data = std::make_shared<Data>(*source, targetRate);
+                if (!cachePath.empty()) {
+                    data->buildPyramid();
+                    data->storeToCache(cachePath);
+                }
+            }
+        }
+
+        if (data->levels() == 0) {
+            data->buildPyramid();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto shared = insert(std::move(data));
+        if (!fileKey.empty()) {
+            byFile_[fileKey] = shared;
+        }
+        return shared;
+    }
+
+    DataPtr share(const SampleType* left, const SampleType* right, size_t size) {
+        auto data = std::make_shared<Data>(left, right, size);
+        std::lock_guard<std::mutex> lock(mutex_);
+        return insert(std::move(data));
+    }
+
+    size_t memorySize() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t total = 0;
+        for (auto& [_, weak] : byContent_) {
+            if (auto data = weak.lock()) {
+                total += data->memorySize();
+            }
+        }
+        return total;
+    }
+
+private:
+
+    static constexpr const char* packedKeySuffix = "|packed";
+
+    SamplePool() = default;
+
+    DataPtr insert(std::shared_ptr<Data>&& data) {
+        auto range = byContent_.equal_range(data->hash());
+        for (auto it = range.first; it != range.second; ++it) {
+            auto existing = it->second.lock();
+            if (existing && (*existing == *data)) {
+                return existing;
+            }
+        }
+        if (byContent_.size() >= sweepThreshold_) {
+            sweep();
+        }
+        DataPtr shared(std::move(data));
+        byContent_.emplace(shared->hash(), shared);
+        return shared;
+    }
+
+    void sweep() {
+        for (auto it = byContent_.begin(); it != byContent_.end();) {
+            it = it->second.expired() ? byContent_.erase(it) : std::next(it);
+        }
+        for (auto it = byFile_.begin(); it != byFile_.end();) {
+            it = it->second.expired() ? byFile_.erase(it) : std::next(it);
+        }
+        sweepThreshold_ = std::max<size_t>(64, byContent_.size() * 2);
+    }
+
+    std::mutex mutex_;
+    std::unordered_multimap<uint64_t, std::weak_ptr<const Data>> byContent_;
+    std::unordered_map<std::string, std::weak_ptr<const Data>> byFile_;
+    size_t sweepThreshold_ {64};
+};
+
+}
+}
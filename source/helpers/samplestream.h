@@ -0,0 +1,352 @@
+#pragma once
+
+#include "sampledata.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+/**
+ *  Plays long PCM files straight from disk.
+ *  A ring of pages around the cursor is kept decoded, a background reader
+ *  refills it ahead in the direction of play. The audio side never waits:
+ *  a page that is not there yet is reported as a miss.
+ **/
+template<typename SampleType>
+class SampleStream {
+public:
+    using Data = SampleData<SampleType>;
+
+    static constexpr size_t PageFrames = 16384;
+    static constexpr size_t Pages = 32;
+
+    struct Format {
+        uint16_t formatTag {0};
+        uint16_t channels {0};
+        uint16_t bitsPerSample {0};
+        uint32_t sampleRate {0};
+        int64_t dataOffset {0};
+        size_t frames {0};
+        size_t acidBeats {0};
+        SampleCacheHeader::AcidMode acidMode {SampleCacheHeader::NoAcid};
+    };
+
+    SampleStream()
+        : file_(nullptr)
+        , position_(0)
+        , speed_(1.)
+        , loop_(false)
+        , hint_(0)
+    {}
+
+    ~SampleStream() {
+        if (file_) {
+            fclose(file_);
+        }
+    }
+
+    SampleStream(const SampleStream&) = delete;
+    SampleStream& operator=(const SampleStream&) = delete;
+
+    // walks the RIFF chunks without reading the audio
+    static bool probe(const char* fileName, Format& format) {
+        FILE* fileHandle = fileName ? fopen(fileName, "rb") : nullptr;
+        if (!fileHandle) {
+            return false;
+        }
+        bool found = probe(fileHandle, format);
+        fclose(fileHandle);
+        return found;
+    }
+
+    // loader thread
+    bool open(const char* fileName, size_t overviewFrames) {
+        file_ = fopen(fileName, "rb");
+        if (!file_ || !probe(file_, format_)) {
+            fprintf(stderr, "[SampleStream] Error: Can not stream (%s)", fileName);
+            return false;
+        }
+
+        for (auto& slot : slots_) {
+            slot.left.resize(PageFrames);
+            slot.right.resize(PageFrames);
+        }
+
+        // one sequential pass for the display copy
+        OverviewBuilder<SampleType> builder(format_.frames, overviewFrames);
+        readAll([&builder](const SampleType* left, const SampleType* right, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                builder.add(left[i], right[i]);
+            }
+        });
+        overview_ = std::make_shared<Data>(builder.left().data(), builder.right().data(), builder.left().size());
+        return true;
+    }
+
+    // any thread but the reader's, a separate pass over the whole file a page at a time
+    template<typename Visit>
+    static bool scan(const char* fileName, Visit&& visit) {
+        SampleStream reader;
+        reader.file_ = fileName ? fopen(fileName, "rb") : nullptr;
+        if (!reader.file_ || !probe(reader.file_, reader.format_)) {
+            return false;
+        }
+        reader.readAll(std::forward<Visit>(visit));
+        return true;
+    }
+
+    size_t frames() const {
+        return format_.frames;
+    }
+
+    size_t sampleRate() const {
+        return format_.sampleRate;
+    }
+
+    size_t acidBeats() const {
+        return format_.acidBeats;
+    }
+
+    SampleCacheHeader::AcidMode acidMode() const {
+        return format_.acidMode;
+    }
+
+    const std::shared_ptr<const Data>& overview() const {
+        return overview_;
+    }
+
+    size_t memorySize() const {
+        return Pages * PageFrames * 2 * sizeof(SampleType);
+    }
+
+    // audio thread, false when the page is not resident
+    bool frame(int64_t index, SampleType& left, SampleType& right) const {
+        int64_t page = index / int64_t(PageFrames);
+        size_t offset = size_t(index % int64_t(PageFrames));
+        size_t slot = hint_;
+        if (slots_[slot].page.load(std::memory_order_acquire) != page) {
+            slot = 0;
+            while ((slot < Pages) && (slots_[slot].page.load(std::memory_order_acquire) != page)) {
+                slot++;
+            }
+            if (slot == Pages) {
+                return false;
+            }
+            hint_ = slot;
+        }
+        left = slots_[slot].left[offset];
+        right = slots_[slot].right[offset];
+        // the reader may have recycled the page meanwhile
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slots_[slot].page.load(std::memory_order_relaxed) == page;
+    }
+
+    // audio thread, where the reader should look ahead from
+    void follow(int64_t position, double speed, bool loop) {
+        position_.store(position, std::memory_order_relaxed);
+        speed_.store(speed, std::memory_order_relaxed);
+        loop_.store(loop, std::memory_order_relaxed);
+    }
+
+    // reader thread, loads a few missing pages, false when the window is complete
+    bool service() {
+        int64_t total = int64_t((format_.frames + PageFrames - 1) / PageFrames);
+        if (total == 0) {
+            return false;
+        }
+        int64_t current = position_.load(std::memory_order_relaxed) / int64_t(PageFrames);
+        int64_t direction = speed_.load(std::memory_order_relaxed) < 0 ? -1 : 1;
+        bool loop = loop_.load(std::memory_order_relaxed);
+
+        // nearest first along the direction of play, a quarter kept behind for reversals
+        int64_t wanted[Pages];
+        size_t count = 0;
+        const int64_t ahead = int64_t(Pages) * 3 / 4;
+        auto want = [&](int64_t page) {
+            if (loop) {
+                page = ((page % total) + total) % total;
+            } else if ((page < 0) || (page >= total)) {
+                return;
+            }
+            if (std::find(wanted, wanted + count, page) == wanted + count) {
+                wanted[count++] = page;
+            }
+        };
+        for (int64_t step = 0; (step < ahead) && (count < Pages); step++) {
+            want(current + direction * step);
+        }
+        for (int64_t step = 1; count < Pages && step <= int64_t(Pages) - ahead; step++) {
+            want(current - direction * step);
+        }
+
+        size_t loaded = 0;
+        for (size_t i = 0; (i < count) && (loaded < pagesPerService); i++) {
+            if (resident(wanted[i])) {
+                continue;
+            }
+            Slot* victim = nullptr;
+            for (auto& slot : slots_) {
+                int64_t page = slot.page.load(std::memory_order_relaxed);
+                if ((page < 0) || (std::find(wanted, wanted + count, page) == wanted + count)) {
+                    victim = &slot;
+                    break;
+                }
+            }
+            if (!victim) {
+                break;
+            }
+            victim->page.store(-1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            readPage(wanted[i], victim->left.data(), victim->right.data());
+            victim->page.store(wanted[i], std::memory_order_release);
+            loaded++;
+        }
+        return loaded > 0;
+    }
+
+private:
+
+    static constexpr size_t pagesPerService = 4;
+
+    struct Slot {
+        std::atomic<int64_t> page {-1};
+        std::vector<SampleType> left;
+        std::vector<SampleType> right;
+    };
+
+    // long files go past what fseek/ftell can address on some platforms
+    static bool seek(FILE* fileHandle, int64_t offset) {
+#if WINDOWS
+        return _fseeki64(fileHandle, offset, SEEK_SET) == 0;
+#else
+        return fseeko(fileHandle, off_t(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    static int64_t tell(FILE* fileHandle) {
+#if WINDOWS
+        return _ftelli64(fileHandle);
+#else
+        return int64_t(ftello(fileHandle));
+#endif
+    }
+
+    static uint32_t readLittle(const uint8_t* bytes, size_t size) {
+        uint32_t value = 0;
+        for (size_t i = size; i > 0; i--) {
+            value = (value << 8) | bytes[i - 1];
+        }
+        return value;
+    }
+
+    static bool probe(FILE* fileHandle, Format& format) {
+        uint8_t header[12];
+        if ((fread(header, 1, sizeof(header), fileHandle) != sizeof(header))
+            || (memcmp(header, "RIFF", 4) != 0)
+            || (memcmp(header + 8, "WAVE", 4) != 0)) {
+            return false;
+        }
+
+        bool foundFormat = false;
+        bool foundData = false;
+        uint8_t chunk[8];
+        while (fread(chunk, 1, sizeof(chunk), fileHandle) == sizeof(chunk)) {
+            uint32_t size = readLittle(chunk + 4, 4);
+            int64_t start = tell(fileHandle);
+            if (memcmp(chunk, "fmt ", 4) == 0) {
+                uint8_t fmt[16];
+                if ((size < sizeof(fmt)) || (fread(fmt, 1, sizeof(fmt), fileHandle) != sizeof(fmt))) {
+                    return false;
+                }
+                format.formatTag = uint16_t(readLittle(fmt, 2));
+                format.channels = uint16_t(readLittle(fmt + 2, 2));
+                format.sampleRate = readLittle(fmt + 4, 4);
+                format.bitsPerSample = uint16_t(readLittle(fmt + 14, 2));
+                foundFormat = ((format.formatTag == 1) || (format.formatTag == 3)) && (format.channels > 0) && (format.bitsPerSample >= 8);
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                format.dataOffset = start;
+                foundData = true;
+                if (foundFormat) {
+                    format.frames = size / (format.channels * format.bitsPerSample / 8);
+                }
+            } else if (memcmp(chunk, "acid", 4) == 0) {
+                uint8_t acid[24];
+                if ((size >= sizeof(acid)) && (fread(acid, 1, sizeof(acid), fileHandle) == sizeof(acid))) {
+                    // same fields SampleData reads: type flags at 0, beats at 12
+                    if ((acid[0] == 0) || (acid[0] == 2)) {
+                        format.acidBeats = acid[12];
+                        format.acidMode = SampleCacheHeader::AcidLoop;
+                    } else if ((acid[0] == 1) || (acid[0] == 3)) {
+                        format.acidBeats = acid[12];
+                        format.acidMode = SampleCacheHeader::AcidOneShoot;
+                    }
+                }
+            }
+            if (!seek(fileHandle, start + int64_t(size) + int64_t(size & 1))) {
+                break;
+            }
+        }
+        return foundFormat && foundData && (format.frames > 0);
+    }
+
+    bool resident(int64_t page) const {
+        for (auto& slot : slots_) {
+            if (slot.page.load(std::memory_order_relaxed) == page) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename Visit>
+    void readAll(Visit&& visit) {
+        std::vector<SampleType> left(PageFrames);
+        std::vector<SampleType> right(PageFrames);
+        size_t pages = (format_.frames + PageFrames - 1) / PageFrames;
+        for (size_t page = 0; page < pages; page++) {
+            size_t count = readPage(int64_t(page), left.data(), right.data());
+            visit(left.data(), right.data(), count);
+        }
+    }
+
+    // reader side, converts one page, missing frames past the end read as silence
+    size_t readPage(int64_t page, SampleType* left, SampleType* right) {
+        size_t first = size_t(page) * PageFrames;
+        size_t count = first < format_.frames ? std::min(PageFrames, format_.frames - first) : 0;
+        size_t step = format_.channels * format_.bitsPerSample / 8;
+        scratch_.resize(PageFrames * step);
+
+        size_t decoded = 0;
+        if ((count > 0) && seek(file_, format_.dataOffset + int64_t(first * step))) {
+            decoded = fread(scratch_.data(), step, count, file_);
+        }
+        for (size_t i = 0; i < decoded; i++) {
+            uint8_t* frame = scratch_.data() + i * step;
+            left[i] = Data::convertToSample(Data::getChannelData(frame, 0, uint8_t(format_.bitsPerSample)), uint8_t(format_.formatTag), uint8_t(format_.bitsPerSample));
+            right[i] = format_.channels >= 2
+                       ? Data::convertToSample(Data::getChannelData(frame, 1, uint8_t(format_.bitsPerSample)), uint8_t(format_.formatTag), uint8_t(format_.bitsPerSample))
+                       : left[i];
+        }
+        std::fill(left + decoded, left + PageFrames, SampleType(0));
+        std::fill(right + decoded, right + PageFrames, SampleType(0));
+        return decoded;
+    }
+
+    FILE* file_;
+    Format format_;
+    std::shared_ptr<const Data> overview_;
+    std::vector<uint8_t> scratch_;
+    Slot slots_[Pages];
+
+    std::atomic<int64_t> position_;
+    std::atomic<double> speed_;
+    std::atomic<bool> loop_;
+    mutable size_t hint_;   // audio thread only
+};
+
+}
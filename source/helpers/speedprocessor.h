@@ -1,11 +1,11 @@
 #pragma once
 
 #include <array>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 
-#include "filtred.h"
-#include "ringbuffer.h"
+#include "blockdsp.h"
 #include "fft.h"
 
 namespace Steinberg::Vst {
@@ -15,9 +15,13 @@ class SpeedProcessor {
 public:
 
     SpeedProcessor()
-        : speedFrameIndex_(0)
+        : originalBuffer_{}
+        , fftBuffer_{}
+        , lastHiLeft_(0)
+        , lastHiRight_(0)
         , oldSignalLeft_(0)
         , oldSignalRight_(0)
+        , speedFrameIndex_(0)
         , directionBits_(0)
         , direction_(1.)
         , speedCounter_(0)
@@ -28,7 +32,12 @@ public:
         , timecode_(ETimeCodeCoeff)
         , realSpeed_(0)
         , timecodeLearnCounter_(0)
-    {}
+    {
+        // the analysis window, looked up rather than four sines a frame
+        for (size_t i = 0; i < SpectrumFame; i++) {
+            window_[i] = sin(Pi * SampleType(i) / SampleType(SpectrumFame));
+        }
+    }
 
     SampleType volume() const noexcept {
         return volume_;
@@ -62,23 +71,71 @@ public:
         timecode_ = tc;
     }
 
+    /**
+     *  Runs count frames of the timecode, speed and volume get the detected speed and deck volume
+     *  after each frame. The prefilter goes over the input in runs, only the detection itself
+     *  is frame by frame.
+     **/
 #ifdef DEVELOPMENT
     template<typename DebugInput, typename DebugOutput>
-    void process(SampleType inL,
-                 SampleType inR,
+    void process(const SampleType* inL,
+                 const SampleType* inR,
+                 SampleType* speed,
+                 SampleType* volume,
+                 size_t count,
                  const DebugInput& debugInput,
                  const DebugOutput& debugOutput)
 #else
-    void process(SampleType inL, SampleType inR)
+    void process(const SampleType* inL, const SampleType* inR, SampleType* speed, SampleType* volume, size_t count)
 #endif // DEBUG
     {
+        SampleType hiLeft[SpeedFrame];
+        SampleType hiRight[SpeedFrame];
+        SampleType loLeft[SpeedFrame];
+        SampleType loRight[SpeedFrame];
+
+        for (size_t done = 0; done < count; done += SpeedFrame) {
+            size_t frames = std::min(SpeedFrame, count - done);
+            filtredHiLeft_.process(inL + done, hiLeft, frames);
+            filtredHiRight_.process(inR + done, hiRight, frames);
+            filtredLoLeft_.process(inL + done, loLeft, frames);
+            filtredLoRight_.process(inR + done, loRight, frames);
+
+            for (size_t i = 0; i < frames; i++) {
+                // the band is the fast smoothing a frame late less the slow one; the ring buffer this
+                // came from always read one behind where it wrote, the detection is tuned to that
+                SampleType newSignalLeft = lastHiLeft_ - loLeft[i];
+                SampleType newSignalRight = lastHiRight_ - loRight[i];
+                lastHiLeft_ = hiLeft[i];
+                lastHiRight_ = hiRight[i];
+
+#ifdef DEVELOPMENT
+                analyse(newSignalLeft, newSignalRight, debugInput, debugOutput);
+#else
+                analyse(newSignalLeft, newSignalRight);
+#endif // DEBUG
+                speed[done + i] = realSpeed_;
+                volume[done + i] = volume_;
+            }
+        }
+    }
 
-        filterBufferLeft_.writeHead(filtredHiLeft_.append(inL));
-        filterBufferRight_.writeHead(filtredHiRight_.append(inR));
+private:
 
-        SampleType newSignalLeft = filterBufferLeft_.readTail() - filtredLoLeft_.append(inL);
-        SampleType newSignalRight = filterBufferRight_.readTail() - filtredLoRight_.append(inR);
+    static constexpr SampleType ETimeCodeMinAmplytude = 0.009;
+    static constexpr SampleType ETimeCodeCoeff = 22.9;
+    static constexpr size_t ETimecodeLearnCount = 1024;
 
+#ifdef DEVELOPMENT
+    template<typename DebugInput, typename DebugOutput>
+    void analyse(SampleType newSignalLeft,
+                 SampleType newSignalRight,
+                 const DebugInput& debugInput,
+                 const DebugOutput& debugOutput)
+#else
+    void analyse(SampleType newSignalLeft, SampleType newSignalRight)
+#endif // DEBUG
+    {
         deltaLeft_.append(newSignalLeft - oldSignalLeft_);
         deltaRight_.append(newSignalRight - oldSignalRight_);
 
@@ -87,7 +144,7 @@ public:
         oldSignalLeft_ = newSignalLeft;
         oldSignalRight_ = newSignalRight;
 
-        SampleType smoothWindow = sin(Pi * SampleType(speedFrameIndex_ + SpectrumFame - SpeedFrame) / SampleType(SpectrumFame));
+        SampleType smoothWindow = window_[speedFrameIndex_ + SpectrumFame - SpeedFrame];
         originalBuffer_[speedFrameIndex_ + SpectrumFame - SpeedFrame] = oldSignalLeft_ - oldSignalRight_;
         fftBuffer_[speedFrameIndex_ + SpectrumFame - SpeedFrame] = (smoothWindow * originalBuffer_[speedFrameIndex_ + SpectrumFame - SpeedFrame]);
 
@@ -125,7 +182,7 @@ public:
             }
 
             for (size_t i = 0; i < SpectrumFame - SpeedFrame; i++) {
-                SampleType smoothWindow = sin(Pi * SampleType(i) / SampleType(SpectrumFame));
+                SampleType smoothWindow = window_[i];
                 originalBuffer_[i] = originalBuffer_[SpeedFrame + i];
                 fftBuffer_[i] = (smoothWindow * originalBuffer_[SpeedFrame + i]);
             }
@@ -144,12 +201,6 @@ public:
         }
     }
 
-private:
-
-    static constexpr SampleType ETimeCodeMinAmplytude = 0.009;
-    static constexpr SampleType ETimeCodeCoeff = 22.9;
-    static constexpr size_t ETimecodeLearnCount = 1024;
-
     void calcAbsSpeed()
     {
         size_t maxX = 0;
@@ -263,22 +314,22 @@ private:
 
     static constexpr SampleType Pi = 3.14159265358979323846264338327950288;
 
-    RingBuffer<SampleType, PreFilterFrame> filterBufferLeft_;
-    RingBuffer<SampleType, PreFilterFrame> filterBufferRight_;
-
-    Filtred<SampleType> filtredHiLeft_;
-    Filtred<SampleType> filtredHiRight_;
-    Filtred<SampleType, PreFilterFrame> filtredLoLeft_;
-    Filtred<SampleType, PreFilterFrame> filtredLoRight_;
+    Smoother<SampleType> filtredHiLeft_;
+    Smoother<SampleType> filtredHiRight_;
+    Smoother<SampleType, PreFilterFrame> filtredLoLeft_;
+    Smoother<SampleType, PreFilterFrame> filtredLoRight_;
 
-    Filtred<SampleType> deltaLeft_;
-    Filtred<SampleType> deltaRight_;
+    Smoother<SampleType> deltaLeft_;
+    Smoother<SampleType> deltaRight_;
 
-    Filtred<SampleType, 64> timeCodeAmplytude_;
+    Smoother<SampleType, 64> timeCodeAmplytude_;
 
     std::array<SampleType, SpectrumFame> originalBuffer_;
     std::array<SampleType, SpectrumFame> fftBuffer_;
+    std::array<SampleType, SpectrumFame> window_;
 
+    SampleType lastHiLeft_;
+    SampleType lastHiRight_;
     SampleType oldSignalLeft_;
     SampleType oldSignalRight_;
 
@@ -293,11 +344,11 @@ private:
     uint8_t prevStateRight_;
     uint8_t prevStateLeft_;
 
-    Filtred<SampleType, 16> volume_;
-    Filtred<SampleType, 256> timecode_;
+    Smoother<SampleType, 16> volume_;
+    Smoother<SampleType, 256> timecode_;
 
     SampleType realSpeed_;
-    Filtred<SampleType, 10> absAvgSpeed_;
+    Smoother<SampleType, 10> absAvgSpeed_;
 
     size_t timecodeLearnCounter_;
 
@@ -0,0 +1,373 @@
+#pragma once
+
+#include "fft.h"
+#include "fastmath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+enum class StretchMode {
+    Wsola = 0,      // grains placed where they continue the previous one, tight on drums
+    PhaseVocoder    // every bin keeps its phase running, smooth on pads and vocals
+};
+
+/**
+ *  Key lock: the sample plays at one pitch while its position moves at another speed.
+ *  Grains are read from the source at the pitch step and overlap-added a hop apart,
+ *  the position only decides where each grain is taken from.
+ *  Output is made a hop at a time and handed out per sample. Every buffer is sized
+ *  for the highest rate up front, nothing allocates while playing.
+ *
+ *  Source needs render(voice, position, step, count, left, right) and normalizePosition(position),
+ *  the voice is the caller's and carries whatever state the reads keep between calls.
+ **/
+template<typename SampleType>
+class TimeStretch {
+public:
+    static constexpr size_t MaximumFrame = 4096;
+
+    explicit TimeStretch(double sampleRate = 44100., StretchMode mode = StretchMode::Wsola)
+        : frame_(0)
+        , hop_(0)
+        , tolerance_(0)
+        , index_(0)
+        , position_(0)
+        , primed_(false)
+        , filled_(0)
+        , mode_(mode)
+        , plan_(2 * MaximumFrame)
+    {
+        window_.resize(MaximumFrame);
+        spectralWindow_.resize(2 * MaximumFrame);
+        regionLeft_.resize(3 * MaximumFrame);
+        regionRight_.resize(3 * MaximumFrame);
+        mono_.resize(3 * MaximumFrame);
+        coarse_.resize(3 * MaximumFrame / Coarse);
+        template_.resize(MaximumFrame / 2);
+        coarseTemplate_.resize(MaximumFrame / 2 / Coarse);
+        overlapLeft_.resize(2 * MaximumFrame);
+        overlapRight_.resize(2 * MaximumFrame);
+        outLeft_.resize(MaximumFrame / 2);
+        outRight_.resize(MaximumFrame / 2);
+        current_.resize(2 * MaximumFrame);
+        previous_.resize(2 * MaximumFrame);
+        phaseLeft_.resize(MaximumFrame + 1);
+        phaseRight_.resize(MaximumFrame + 1);
+        primeLeft_.resize(2 * MaximumFrame);
+        primeRight_.resize(2 * MaximumFrame);
+        setup(sampleRate);
+    }
+
+    // grains of about 21 ms whatever the rate, recomputes the windows only
+    void setup(double sampleRate) {
+        size_t frame = 1024;
+        while ((frame < MaximumFrame) && (double(frame) * 48000. < sampleRate * 1024.)) {
+            frame <<= 1;
+        }
+        if (frame == frame_) {
+            return;
+        }
+        frame_ = frame;
+        hop_ = frame / 2;
+        tolerance_ = frame / 4;
+
+        // periodic Hann: a grain every half frame sums to one,
+        // squared every quarter frame to one and a half
+        for (size_t i = 0; i < frame_; i++) {
+            window_[i] = SampleType(0.5 - 0.5 * cos(2. * Pi * double(i) / double(frame_)));
+        }
+        const size_t spectral = 2 * frame_;
+        for (size_t i = 0; i < spectral; i++) {
+            spectralWindow_[i] = SampleType(0.5 - 0.5 * cos(2. * Pi * double(i) / double(spectral)));
+        }
+        reset(position_);
+    }
+
+    void mode(StretchMode mode) {
+        if (mode != mode_) {
+            mode_ = mode;
+            reset(position_);
+        }
+    }
+
+    StretchMode mode() const {
+        return mode_;
+    }
+
+    // the next grain starts from position, the overlap restarts from there
+    void reset(double position) {
+        position_ = position;
+        index_ = hop_;
+        primed_ = false;
+    }
+
+    // where the source is at, in source frames
+    double position() const {
+        return position_;
+    }
+
+    // output is made this many samples at a time
+    size_t hop() const {
+        return hop_;
+    }
+
+    /**
+     *  step - source frames the position moves per output sample,
+     *  pitch - source frames between the output samples of a grain.
+     **/
+    template<typename Source, typename Voice>
+    void process(Source& source, Voice& voice, double step, double pitch, SampleType& left, SampleType& right) {
+        if (index_ >= hop_) {
+            synthesize(source, voice, step, pitch);
+            index_ = 0;
+        }
+        left = outLeft_[index_];
+        right = outRight_[index_];
+        index_++;
+        position_ = source.normalizePosition(position_ + step);
+    }
+
+private:
+    static constexpr double Pi = 3.14159265358979323846264338327950288;
+    static constexpr size_t Coarse = 4;   // the search first looks at every fourth lag of a decimated copy
+    static constexpr SampleType SpectralGain = SampleType(2. / 3.);
+
+    template<typename Source, typename Voice>
+    void synthesize(Source& source, Voice& voice, double step, double pitch) {
+        if (!primed_) {
+            std::fill(overlapLeft_.begin(), overlapLeft_.end(), SampleType(0));
+            std::fill(overlapRight_.begin(), overlapRight_.end(), SampleType(0));
+            filled_ = 0;
+            // a grain ahead so the first hop already overlaps, it is cheap; the spectral frames
+            // span four hops and fill in one a hop instead, see spectralHop
+            if (mode_ == StretchMode::Wsola) {
+                hop(source, voice, position_ - double(hop_) * step, pitch);
+                primed_ = true;
+            }
+        }
+        hop(source, voice, position_, pitch);
+        primed_ = true;
+    }
+
+    template<typename Source, typename Voice>
+    void hop(Source& source, Voice& voice, double position, double pitch) {
+        if (mode_ == StretchMode::PhaseVocoder) {
+            spectralHop(source, voice, position, pitch);
+        } else {
+            grainHop(source, voice, position, pitch);
+        }
+    }
+
+    /**
+     *  WSOLA: the grain is taken from within tolerance of the nominal position,
+     *  where it correlates best with the natural continuation of the previous grain.
+     **/
+    template<typename Source, typename Voice>
+    void grainHop(Source& source, Voice& voice, double position, double pitch) {
+        const size_t span = frame_ + 2 * tolerance_;
+        source.render(voice, source.normalizePosition(position - double(tolerance_) * pitch), pitch, span, regionLeft_.data(), regionRight_.data());
+
+        size_t lag = tolerance_;
+        if (primed_) {
+            for (size_t i = 0; i < 2 * tolerance_ + hop_; i++) {
+                mono_[i] = regionLeft_[i] + regionRight_[i];
+            }
+            lag = search();
+        }
+
+        const SampleType* grainLeft = regionLeft_.data() + lag;
+        const SampleType* grainRight = regionRight_.data() + lag;
+        for (size_t i = 0; i < hop_; i++) {
+            outLeft_[i] = overlapLeft_[i] + window_[i] * grainLeft[i];
+            outRight_[i] = overlapRight_[i] + window_[i] * grainRight[i];
+            overlapLeft_[i] = window_[hop_ + i] * grainLeft[hop_ + i];
+            overlapRight_[i] = window_[hop_ + i] * grainRight[hop_ + i];
+            template_[i] = grainLeft[hop_ + i] + grainRight[hop_ + i];
+        }
+    }
+
+    // normalised cross correlation, coarse on a decimated copy then refined around the winner
+    size_t search() {
+        const size_t lags = 2 * tolerance_;
+        const size_t length = hop_ / Coarse;
+        decimate(template_.data(), hop_, coarseTemplate_.data());
+        decimate(mono_.data(), lags + hop_, coarse_.data());
+
+        size_t best = tolerance_;
+        SampleType bestScore = std::numeric_limits<SampleType>::lowest();
+        for (size_t lag = 0; lag <= lags / Coarse; lag++) {
+            SampleType score = correlation(coarseTemplate_.data(), coarse_.data() + lag, length);
+            if (score > bestScore) {
+                bestScore = score;
+                best = lag * Coarse;
+            }
+        }
+
+        size_t from = best >= Coarse ? best - Coarse + 1 : 0;
+        size_t to = std::min(best + Coarse - 1, lags);
+        bestScore = std::numeric_limits<SampleType>::lowest();
+        for (size_t lag = from; lag <= to; lag++) {
+            SampleType score = correlation(template_.data(), mono_.data() + lag, hop_);
+            if (score > bestScore) {
+                bestScore = score;
+                best = lag;
+            }
+        }
+        return best;
+    }
+
+    static void decimate(const SampleType* input, size_t count, SampleType* output) {
+        for (size_t i = 0; i + Coarse <= count; i += Coarse) {
+            output[i / Coarse] = input[i] + input[i + 1] + input[i + 2] + input[i + 3];
+        }
+    }
+
+    // four independent sums per term keep the loop free to vectorise
+    static SampleType correlation(const SampleType* target, const SampleType* candidate, size_t count) {
+        SampleType dot[4] = {0, 0, 0, 0};
+        SampleType energy[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            for (size_t k = 0; k < 4; k++) {
+                dot[k] += target[i + k] * candidate[i + k];
+                energy[k] += candidate[i + k] * candidate[i + k];
+            }
+        }
+        for (; i < count; i++) {
+            dot[0] += target[i] * candidate[i];
+            energy[0] += candidate[i] * candidate[i];
+        }
+        SampleType totalEnergy = energy[0] + energy[1] + energy[2] + energy[3];
+        return (dot[0] + dot[1] + dot[2] + dot[3]) / std::sqrt(totalEnergy + SampleType(1e-12));
+    }
+
+    /**
+     *  Phase vocoder: two analysis frames one hop apart at the pitch step give every
+     *  bin its true frequency, its phase is advanced by that over the output hop.
+     *  Left and right share one complex transform as its real and imaginary parts.
+     **/
+    template<typename Source, typename Voice>
+    void spectralHop(Source& source, Voice& voice, double position, double pitch) {
+        const size_t size = 2 * frame_;
+        source.render(voice, source.normalizePosition(position - double(hop_) * pitch), pitch, size + hop_, regionLeft_.data(), regionRight_.data());
+
+        for (size_t i = 0; i < size; i++) {
+            const SampleType w = spectralWindow_[i];
+            previous_[i] = {w * regionLeft_[i], w * regionRight_[i]};
+            current_[i] = {w * regionLeft_[hop_ + i], w * regionRight_[hop_ + i]};
+        }
+        plan_.forward(previous_.data(), size);
+        plan_.forward(current_.data(), size);
+
+        const size_t bins = size / 2;
+        for (size_t k = 0; k <= bins; k++) {
+            const size_t mirror = (size - k) & (size - 1);
+            const Complex<SampleType> a = current_[k];
+            const Complex<SampleType> b = current_[mirror];
+            const Complex<SampleType> c = previous_[k];
+            const Complex<SampleType> d = previous_[mirror];
+
+            Complex<SampleType> left {(a.real + b.real) / 2, (a.imaginary - b.imaginary) / 2};
+            Complex<SampleType> right {(a.imaginary + b.imaginary) / 2, (b.real - a.real) / 2};
+            if ((k > 0) && (k < bins)) {
+                // DC and Nyquist stay real, the rest turn at their measured frequency
+                const double expected = 2. * Pi * double(k) * double(hop_) / double(size);
+                left = advance(phaseLeft_[k], left, {(c.real + d.real) / 2, (c.imaginary - d.imaginary) / 2}, expected);
+                right = advance(phaseRight_[k], right, {(c.imaginary + d.imaginary) / 2, (d.real - c.real) / 2}, expected);
+            }
+
+            current_[k] = {left.real - right.imaginary, left.imaginary + right.real};
+            if ((k > 0) && (k < bins)) {
+                current_[mirror] = {left.real + right.imaginary, right.real - left.imaginary};
+            }
+        }
+        plan_.inverse(current_.data(), size);
+
+        for (size_t i = 0; i < size; i++) {
+            const SampleType w = spectralWindow_[i] * SpectralGain;
+            overlapLeft_[i] += w * current_[i].real;
+            overlapRight_[i] += w * current_[i].imaginary;
+        }
+        std::copy(overlapLeft_.begin(), overlapLeft_.begin() + hop_, outLeft_.begin());
+        std::copy(overlapRight_.begin(), overlapRight_.begin() + hop_, outRight_.begin());
+
+        // the first hops after a reset overlap fewer frames than the window sum needs; what they
+        // lack comes from the source under the first frame, which the bins continue in phase
+        if (filled_ + 1 < size / hop_) {
+            if (filled_ == 0) {
+                std::copy(regionLeft_.begin() + hop_, regionLeft_.begin() + size, primeLeft_.begin());
+                std::copy(regionRight_.begin() + hop_, regionRight_.begin() + size, primeRight_.begin());
+            }
+            const SampleType* primeLeft = primeLeft_.data() + filled_ * hop_;
+            const SampleType* primeRight = primeRight_.data() + filled_ * hop_;
+            filled_++;
+            for (size_t i = 0; i < hop_; i++) {
+                SampleType weight = 0;
+                for (size_t frame = 0; frame < filled_; frame++) {
+                    const SampleType w = spectralWindow_[frame * hop_ + i];
+                    weight += w * w;
+                }
+                const SampleType missing = SampleType(1) - weight * SpectralGain;
+                outLeft_[i] += missing * primeLeft[i];
+                outRight_[i] += missing * primeRight[i];
+            }
+        }
+        std::memmove(overlapLeft_.data(), overlapLeft_.data() + hop_, (size - hop_) * sizeof(SampleType));
+        std::memmove(overlapRight_.data(), overlapRight_.data() + hop_, (size - hop_) * sizeof(SampleType));
+        std::fill(overlapLeft_.begin() + (size - hop_), overlapLeft_.begin() + size, SampleType(0));
+        std::fill(overlapRight_.begin() + (size - hop_), overlapRight_.begin() + size, SampleType(0));
+    }
+
+    Complex<SampleType> advance(double& phase, const Complex<SampleType>& current, const Complex<SampleType>& previous, double expected) {
+        const double now = atan2(double(current.imaginary), double(current.real));
+        if (primed_) {
+            double deviation = now - atan2(double(previous.imaginary), double(previous.real)) - expected;
+            deviation -= 2. * Pi * std::round(deviation / (2. * Pi));
+            phase = std::remainder(phase + expected + deviation, 2. * Pi);
+        } else {
+            phase = now;
+        }
+        const double magnitude = std::hypot(double(current.real), double(current.imaginary));
+        return {SampleType(magnitude * fastmath::cos(phase)), SampleType(magnitude * fastmath::sin(phase))};
+    }
+
+    size_t frame_;
+    size_t hop_;
+    size_t tolerance_;
+    size_t index_;
+    double position_;
+    bool primed_;
+    size_t filled_;     // spectral frames overlapping since the reset, up to one short of full
+    StretchMode mode_;
+
+    FftPlan<SampleType> plan_;
+    std::vector<SampleType> window_;
+    std::vector<SampleType> spectralWindow_;
+
+    std::vector<SampleType> regionLeft_;
+    std::vector<SampleType> regionRight_;
+    std::vector<SampleType> mono_;
+    std::vector<SampleType> coarse_;
+    std::vector<SampleType> template_;
+    std::vector<SampleType> coarseTemplate_;
+
+    std::vector<SampleType> overlapLeft_;
+    std::vector<SampleType> overlapRight_;
+    std::vector<SampleType> outLeft_;
+    std::vector<SampleType> outRight_;
+
+    std::vector<Complex<SampleType>> current_;
+    std::vector<Complex<SampleType>> previous_;
+    std::vector<double> phaseLeft_;
+    std::vector<double> phaseRight_;
+    std::vector<SampleType> primeLeft_;
+    std::vector<SampleType> primeRight_;
+};
+
+}
@@ -9,12 +9,24 @@
 #define EMaximumScenes 10
 #define ENumberOfPads 16
 #define EEmptyBaseTitle "Empty"
+#define ELoadingTitleSuffix " (loading...)"
 #define ETimecodeLearnCount 1024
 #define EDefaultTempo 120
 #define EDefaultSampleRate 44100
 #define ERollNote 1.0/32.0
 #define ERollCount 8
 #define ESoftEffectSamples 24
+#define ELoaderThreads 0 // 0 - one per core
+#define EMessagePeriod 40 // ms, how often the message thread forwards loaded slots to the editor
+#define EResampleOnLoad 1 // 1 - convert samples to the host rate when loaded
+#define EStreamingFrames (20 * 60 * 48000) // longer files play from disk, 0 - never stream
+#define EMemoryBudget (size_t(1) << 30) // bytes of audio one instance keeps decoded, 0 - unbounded
+#define ECacheLimit (uint64_t(2) << 30) // bytes the decoded sample cache may hold on disk, 0 - unbounded
+#define ECompressFrames (2 * 60 * 48000) // longer files are kept losslessly packed in memory, 0 - never
+#define ELockPhaseVocoder 0 // 1 - key lock through the phase vocoder (pads, vocals), 0 - WSOLA grains (drums)
+#define EVintageSampled 0 // 1 - vintage plays vintage.wav, 0 - the noise is generated
+#define EProcessFrames 128 // longest stretch rendered as one block between parameter and event changes
+#define EInternalDouble 1 // 1 - the detector, the deck and the effects run in double, 0 - in float and 32 bit hosts are read and written in place
 
 //////initial MIDIControls config
 #define gGain 0x07
@@ -1,6 +1,7 @@
 #include "vinylcontroller.h"
 #include "vinylparamids.h"
 #include "vinyleditor.h"
+#include "helpers/interpolation.h"
 
 #include "pluginterfaces/base/ibstream.h"
 #include "pluginterfaces/base/ustring.h"
@@ -173,6 +174,21 @@ tresult PLUGIN_API AVinylController::initialize(FUnknown* context)
     auto tuneParam = make_shared<RangeParameter>(STR16("Tune"), kTuneId, STR16("<>"), 0, 1, 0.5, 511, ParameterInfo::kIsWrapAround, kRootUnitId);
     parameters.addParameter(tuneParam);
 
+    auto interpolationParam = make_shared<StringListParameter>(STR16("Interpolation"), kInterpolationId, nullptr, ParameterInfo::kCanAutomate | ParameterInfo::kIsList, kRootUnitId);
+    interpolationParam->appendString(STR16("Linear"));
+    interpolationParam->appendString(STR16("Hermite"));
+    interpolationParam->appendString(STR16("6-point"));
+    interpolationParam->appendString(STR16("Sinc"));
+    interpolationParam->getInfo().defaultNormalizedValue = interpolationParam->toNormalized(int(InterpolationQuality::Hermite));
+    interpolationParam->setNormalized(interpolationParam->getInfo().defaultNormalizedValue);
+    parameters.addParameter(interpolationParam);
+
+    auto oversamplingParam = make_shared<StringListParameter>(STR16("Oversampling"), kOversamplingId, nullptr, ParameterInfo::kCanAutomate | ParameterInfo::kIsList, kRootUnitId);
+    oversamplingParam->appendString(STR16("1x"));
+    oversamplingParam->appendString(STR16("2x"));
+    oversamplingParam->appendString(STR16("4x"));
+    parameters.addParameter(oversamplingParam);
+
     return result;
 }
 
@@ -486,7 +502,7 @@ tresult PLUGIN_API AVinylController::notify(IMessage* message)
         TChar file[256];
 
         message->getAttributes()->getBinary("EntryBufferLeft", bufferLeft, bufferLen);
-        message->getAttributes()->getBinary("EntryBufferLeft", bufferRight, bufferLen);
+        message->getAttributes()->getBinary("EntryBufferRight", bufferRight, bufferLen);
         message->getAttributes()->getString("EntryName", name, sizeof(name));
         message->getAttributes()->getString("EntryFile", file, sizeof(file));
 
@@ -521,6 +537,24 @@ tresult PLUGIN_API AVinylController::notify(IMessage* message)
             message->getAttributes()->getInt("EntryBeats", intVal);
             newEntry.acidBeats(size_t(intVal));
         }
+        {
+            int64_t intVal {0};
+            SampleAnalysis analysis;
+            message->getAttributes()->getInt("EntryGridBeats", intVal);
+            message->getAttributes()->getFloat("EntryFirstBeat", analysis.firstBeat);
+            message->getAttributes()->getFloat("EntryBeatLength", analysis.beatLength);
+            message->getAttributes()->getFloat("EntryTempo", analysis.tempo);
+            message->getAttributes()->getFloat("EntryLoudness", analysis.loudness);
+            analysis.beats = size_t(intVal);
+            analysis.firstBeat *= double(newEntry.bufferLength());
+            analysis.beatLength *= double(newEntry.bufferLength());
+            newEntry.analysis(analysis);
+        }
+        {
+            int64_t intVal {0};
+            message->getAttributes()->getInt("EntryLoading", intVal);
+            newEntry.loading(intVal > 0);
+        }
         message->getAttributes()->getFloat("EntryLoop", newEntry.Tune);
         message->getAttributes()->getFloat("EntryLoop", newEntry.Level);
 
@@ -578,6 +612,19 @@ tresult PLUGIN_API AVinylController::notify(IMessage* message)
         }
 		return kResultTrue;
 	}
+    if (strcmp(message->getMessageID(), "latencyChanged") == 0) {
+        // the oversampling factor moved, the host asks the processor again
+        if (componentHandler) {
+            componentHandler->restartComponent(kLatencyChanged);
+        }
+        return kResultTrue;
+    }
+    if (strcmp(message->getMessageID(), "updateMemory") == 0) {
+        message->getAttributes()->getInt("ResidentBytes", memoryUsage_.resident);
+        message->getAttributes()->getInt("EvictedBytes", memoryUsage_.evicted);
+        message->getAttributes()->getInt("PendingBytes", memoryUsage_.pending);
+        return kResultTrue;
+    }
     if (strcmp(message->getMessageID(), "updatePosition") == 0) {
 		double newPosition;
         message->getAttributes()->getFloat("Position", newPosition);
@@ -52,8 +52,20 @@ public:
 	DELEGATE_REFCOUNT (EditController)
     tresult PLUGIN_API queryInterface (const char* iid, void** obj) override;
 
+    // sample memory of the processor in bytes, as last reported
+    struct MemoryUsage {
+        int64 resident {0};
+        int64 evicted {0};
+        int64 pending {0};
+    };
+
+    const MemoryUsage& memoryUsage() const {
+        return memoryUsage_;
+    }
+
 private:
     std::vector<SharedPointer<EditorView>> viewsArray_;
+    MemoryUsage memoryUsage_;
     int midiGain_;
     int midiScene_;
     int midiMix_;
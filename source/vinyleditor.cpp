@@ -1404,9 +1404,13 @@ AVinylEditorView::SharedPointer<VSTGUI::CBitmap> AVinylEditorView::generateWavef
     SampleEntry<Sample64>::Type peak = sample.peakSample(0, sample.bufferLength());
     SampleEntry<Sample64>::Type norm = (normolize && peak > 1.) ? 1. / peak : 1.;
 
-    bool drawBeats =  sample.acidBeats() > 0;
-
-    double beatPeriodic = drawBeats ? double(bitmapWidth) / (2. * sample.acidBeats()) : 0;
+    // beats from the ACID chunk or the analysis, in columns of two pixels
+    bool drawBeats = (sample.beats() > 0) && (sample.beatFrames() > 0);
+    double beatPeriodic = drawBeats ? sample.beatFrames() * double(halfWidth) / double(sample.bufferLength()) : 0;
+    double beatStart = drawBeats ? sample.firstBeat() * double(halfWidth) / double(sample.bufferLength()) : 0;
+    auto beatAt = [&](double column) {
+        return int64_t(floor((column - beatStart) / beatPeriodic));
+    };
     auto digits = make_shared<VSTGUI::CBitmap>(VSTGUI::CResourceDescription("digits.png"));
     auto waveForm = make_shared<VSTGUI::CBitmap>(bitmapWidth, 83);
     if (!waveForm || !digits || sample.bufferLength() == 0) {
@@ -1434,11 +1438,11 @@ AVinylEditorView::SharedPointer<VSTGUI::CBitmap> AVinylEditorView::generateWavef
     }
 
     for (uint32_t i = 1; i < (drawBeats ? halfWidth : 0U); i++) {
-        if (((i == 1) || ((uint32_t((i - 2) / beatPeriodic)) != (uint32_t((i - 1) / beatPeriodic))))) {
+        if ((i == 1) ? (beatStart < 1.) : (beatAt(i - 2) != beatAt(i - 1))) {
             for (uint32_t j = 0; j <= 5; j++) {
                 for(uint32_t k = 0; k <= 5; k++) {
                     pixelMap->setPosition((i - 1) * 2 + j + 2, 76 + k);
-                    pixelDigits->setPosition((((i - 1) / uint32_t(beatPeriodic)) % 10) * 5 + j, k);
+                    pixelDigits->setPosition(uint32_t(std::max<int64_t>(0, beatAt(i - 1)) % 10) * 5 + j, k);
                     VSTGUI::CColor digPixel;
                     pixelDigits->getColor(digPixel);
                     pixelMap->setColor(digPixel);
@@ -1507,20 +1511,27 @@ void AVinylEditorView::initEntry(SampleEntry<Sample64> &newEntry)
 {
 
     auto waveForm = generateWaveform(newEntry);
-    if (!waveForm) {
+    if (!waveForm && !newEntry.loading()) {
         // not readable format
         return;
     }
 
+    std::string title(newEntry.name());
+    if (newEntry.loading()) {
+        title += ELoadingTitleSuffix;
+    }
+
     size_t index = newEntry.index() - 1;
     if (index < sampleBitmaps_.size()) {
-        sampleBitmaps_[index] = std::move(waveForm);
+        if (waveForm || !newEntry.loading()) {
+            sampleBitmaps_[index] = std::move(waveForm);
+        }
 
         if (sampleBase_) {
-            sampleBase_->getEntry(int32_t(index))->setTitle(VSTGUI::UTF8String(newEntry.name()));
+            sampleBase_->getEntry(int32_t(index))->setTitle(VSTGUI::UTF8String(title));
         }
         if (padBase_) {
-            padBase_->getEntry(int32_t(index))->setTitle(VSTGUI::UTF8String(newEntry.name()));
+            padBase_->getEntry(int32_t(index))->setTitle(VSTGUI::UTF8String(title));
         }
     } else {
 
@@ -1539,9 +1550,9 @@ void AVinylEditorView::initEntry(SampleEntry<Sample64> &newEntry)
                     }
                 }
             }
-            sampleBase_->addEntry(VSTGUI::UTF8String(newEntry.name()), sampleBase_->getNbEntries(), VSTGUI::CMenuItem::kChecked);
+            sampleBase_->addEntry(VSTGUI::UTF8String(title), sampleBase_->getNbEntries(), VSTGUI::CMenuItem::kChecked);
             if (padBase_) {
-                padBase_->addEntry(VSTGUI::UTF8String(newEntry.name()), sampleBase_->getNbEntries(), 0);
+                padBase_->addEntry(VSTGUI::UTF8String(title), sampleBase_->getNbEntries(), 0);
             }
         }
     }
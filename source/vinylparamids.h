@@ -29,5 +29,9 @@ enum
 	kVintageId,
 	kLockToneId,
 	kAmpId,
-	kTuneId
+	kTuneId,
+	kInterpolationId,	///< playback interpolation quality
+	kOversamplingId,	///< distortion oversampling, 1x 2x 4x
+
+	kParamCount		///< number of parameter IDs, not a parameter
 };
@@ -2,6 +2,8 @@
 #include "vinylparamids.h"
 #include "vinylcids.h"	// for class ids
 #include "helpers/parameterwriter.h"
+#include "helpers/blockdsp.h"
+#include "helpers/halfband.h"
 
 #include "effects/lock.h"
 #include "effects/hold.h"
@@ -17,17 +19,11 @@
 
 #include <stdio.h>
 #include <cmath>
+#include <algorithm>
+#include <type_traits>
 
 namespace {
 
-template<typename T>
-inline T aproxParamValue(int32_t currentSampleIndex, T currentValue, int32_t nextSampleIndex, T nextValue)
-{
-    T slope = (nextValue - currentValue) / T(nextSampleIndex - currentSampleIndex + 1);
-    T offset = currentValue - (slope * T(currentSampleIndex - 1));
-    return (slope * T(currentSampleIndex)) + offset; // bufferTime is any position in buffer
-}
-
 template<typename T>
 inline T calcRealPitch(T normalPitch, T normalKoeff)
 {
@@ -67,89 +63,134 @@ inline size_t noteLengthInSamples(T note, T tempo, T sampleRate)
     return 0;
 }
 
+// the host's channel buffers in the precision the block comes in
+template<typename SampleType>
+SampleType** channelBuffers(Steinberg::Vst::AudioBusBuffers& bus);
+
+template<>
+Steinberg::Vst::Sample32** channelBuffers(Steinberg::Vst::AudioBusBuffers& bus)
+{
+    return bus.channelBuffers32;
+}
+
+template<>
+Steinberg::Vst::Sample64** channelBuffers(Steinberg::Vst::AudioBusBuffers& bus)
+{
+    return bus.channelBuffers64;
+}
+
+// long and streamed entries send their reduced display copy, which also keeps
+// the byte count well inside the 32 bit size of a binary attribute.
+// The editor takes doubles, a float deck widens its copy first
+template<typename SampleType>
+void setWaveformAttributes(Steinberg::Vst::IAttributeList* attributes,
+                           const typename Steinberg::Vst::SampleEntry<SampleType>::DataPtr& overview,
+                           const Steinberg::Vst::SampleAnalysis& analysis,
+                           size_t bufferLength)
+{
+    using Steinberg::Vst::Sample64;
+    uint32_t bytes = overview ? uint32_t(overview->size() * sizeof(Sample64)) : 0;
+    if constexpr (std::is_same_v<SampleType, Sample64>) {
+        attributes->setBinary("EntryBufferLeft", overview ? overview->left() : nullptr, bytes);
+        attributes->setBinary("EntryBufferRight", overview ? overview->right() : nullptr, bytes);
+    } else {
+        std::vector<Sample64> left;
+        std::vector<Sample64> right;
+        if (overview) {
+            left.assign(overview->left(), overview->left() + overview->size());
+            right.assign(overview->right(), overview->right() + overview->size());
+        }
+        attributes->setBinary("EntryBufferLeft", left.data(), bytes);
+        attributes->setBinary("EntryBufferRight", right.data(), bytes);
+    }
+
+    // the analysed beat grid as fractions of the sample, the display copy may be shorter
+    double length = double(bufferLength);
+    attributes->setInt("EntryGridBeats", int64_t(analysis.beats));
+    attributes->setFloat("EntryFirstBeat", length > 0 ? analysis.firstBeat / length : 0.);
+    attributes->setFloat("EntryBeatLength", length > 0 ? analysis.beatLength / length : 0.);
+    attributes->setFloat("EntryTempo", analysis.tempo);
+    attributes->setFloat("EntryLoudness", analysis.loudness);
+}
+
 }
 
 namespace Steinberg {
 namespace Vst {
 
 AVinyl::AVinyl() :
-    gain_(0.8),
-    realVolume_(0.8),
+    effectorSet_(0),
+    scheduledSet_(0),
     vuLeft_(0.),
     vuRight_(0.),
     position_(0.),
+    gain_(0.8),
     volume_(1.0),
     pitch_(.5),
-    realPitch_(1.0),
     currentEntry_(0),
     currentScene_(0),
     switch_(0),
     curve_(0),
-    currentProcessMode_(-1), // -1 means not initialized
     bypass_(false),
+    slotIds_(0),
+    generations_(0),
+    timer_(nullptr),
+    budget_(EMemoryBudget),
+    memoryDirty_(false),
+    currentProcessMode_(-1), // -1 means not initialized
+    currentProcessStatus_(false),
+    dirtyParams_(false),
+    interpolation_(InterpolationQuality::Hermite),
+    oversampling_(1),
+    latency_(ESpeedFrame),
+    reportedLatency_(ESpeedFrame),
     sampleRate_(EDefaultSampleRate),
     tempo_(EDefaultTempo),
     noteLength_(0),
-    effectorSet_(0),
-    currentProcessStatus_(false),
-    dirtyParams_(false)
+    realPitch_(1.0),
+    realVolume_(0.8)
 {
     // register its editor class (the same than used in againentry.cpp)
     setControllerClass(AVinylControllerUID);
 
-    effector_.append(std::unique_ptr<Effect>(new Lock(sampleRate_, [this](){ return samplesArray_.at(currentEntry_).get(); })));
-    effector_.append(std::unique_ptr<Effect>(new Hold(sampleRate_, noteLength_, [this](){ return samplesArray_.at(currentEntry_).get(); })));
-    effector_.append(std::unique_ptr<Effect>(new Freeze(sampleRate_, noteLength_, [this](){ return samplesArray_.at(currentEntry_).get(); })));
-    effector_.append(std::unique_ptr<Effect>(new PreRoll([this](){ return samplesArray_.at(currentEntry_).get(); })));
-    effector_.append(std::unique_ptr<Effect>(new PostRoll([this](){ return samplesArray_.at(currentEntry_).get(); })));
-    effector_.append(std::unique_ptr<Effect>(new Distortion()));
-    effector_.append(std::unique_ptr<Effect>(new Vintage(sampleRate_)));
-    effector_.append(std::unique_ptr<Effect>(new PunchIn([this]() { return gain_ * speedProcessor_.volume(); })));
-    effector_.append(std::unique_ptr<Effect>(new PunchOut()));
+    // the audio thread appends within the reserve, it never allocates
+    samplesArray_.reserve(EMaximumSamples);
+    SincInterpolation::prepare();
+
+    effector_ = makeEffector<InternalSample>(
+        new Lock(sampleRate_, [this](){ return samplesArray_.at(currentEntry_).get(); }, ELockPhaseVocoder ? StretchMode::PhaseVocoder : StretchMode::Wsola),
+        new Hold(sampleRate_, noteLength_, [this](){ return samplesArray_.at(currentEntry_).get(); }),
+        new Freeze(sampleRate_, noteLength_, [this](){ return samplesArray_.at(currentEntry_).get(); }),
+        new PreRoll([this](){ return samplesArray_.at(currentEntry_).get(); }),
+        new PostRoll([this](){ return samplesArray_.at(currentEntry_).get(); }),
+        new Distortion<InternalSample>(oversampling_),
+        new Vintage<InternalSample>(sampleRate_, EVintageSampled ? VintageSource::Sampled : VintageSource::Generated),
+        new PunchIn([this]() { return InternalSample(gain_ * speedProcessor_.volume()); }),
+        new PunchOut<InternalSample>());
 
 
     params_.addReader(kBypassId, [this] () { return bypass_ ? 1. : 0.; },
                      [this](Sample64 value) {
                          bypass_ = value > 0.5;
                      });
-    params_.addReader(kGainId,   [this] () { return gain_; },
-                     [this](Sample64 value) {
-                         gain_ = value;
-                         realVolume_ = calcRealVolume(gain_, volume_, curve_); },
-                     [this] (int32 sampleOffset, int32 currentOffset, Sample64 currentValue) {
-                         gain_ = aproxParamValue<Sample32>(sampleOffset, gain_, currentOffset, currentValue);
-                         realVolume_ = calcRealVolume(gain_, volume_, curve_);
-                     });
-    params_.addReader(kVolumeId, [this] () { return volume_; },
-                     [this](Sample64 value) {
-                         volume_ = value;
-                         realVolume_ = calcRealVolume(gain_, volume_, curve_); },
-                     [this] (int32 sampleOffset, int32 currentOffset, Sample64 currentValue) {
-                         volume_ = aproxParamValue<Sample32>(sampleOffset, volume_, currentOffset, currentValue);
-                         realVolume_ = calcRealVolume(gain_, volume_, curve_);
-                     });
-    params_.addReader(kVolCurveId, [this] () { return curve_; },
-                     [this](Sample64 value) {
-                         curve_ = value;
-                         realVolume_ = calcRealVolume(gain_, volume_, curve_); },
-                     [this] (int32 sampleOffset, int32 currentOffset, Sample64 currentValue) {
-                         curve_ = aproxParamValue<Sample32>(sampleOffset, curve_, currentOffset, currentValue);
-                         realVolume_ = calcRealVolume(gain_, volume_, curve_);
-                     });
-    params_.addReader(kPitchId, [this] () { return pitch_; },
-                     [this](Sample64 value) { pitch_ = value; realPitch_ = calcRealPitch (pitch_, switch_); },
-                     [this] (int32 sampleOffset, int32 currentOffset, Sample64 currentValue) {
-                         pitch_ = aproxParamValue<Sample32>(sampleOffset, pitch_, currentOffset, currentValue);
-                         realPitch_ = calcRealPitch (pitch_, switch_);
-                     });
-    params_.addReader(kPitchSwitchId, [this] () { return switch_; },
-                     [this](Sample64 value) {
-                         switch_ = value;
-                         realPitch_ = calcRealPitch (pitch_, switch_); },
-                     [this] (int32 sampleOffset, int32 currentOffset, Sample64 currentValue) {
-                         switch_ = aproxParamValue<Sample32>(sampleOffset, switch_, currentOffset, currentValue);
-                         realPitch_ = calcRealPitch (pitch_, switch_);
-                     });
+    params_.addRampReader(kGainId,   [this] () { return gain_; },
+                         [this](Sample64 value) {
+                             gain_ = value;
+                             realVolume_ = calcRealVolume(gain_, volume_, curve_); });
+    params_.addRampReader(kVolumeId, [this] () { return volume_; },
+                         [this](Sample64 value) {
+                             volume_ = value;
+                             realVolume_ = calcRealVolume(gain_, volume_, curve_); });
+    params_.addRampReader(kVolCurveId, [this] () { return curve_; },
+                         [this](Sample64 value) {
+                             curve_ = value;
+                             realVolume_ = calcRealVolume(gain_, volume_, curve_); });
+    params_.addRampReader(kPitchId, [this] () { return pitch_; },
+                         [this](Sample64 value) { pitch_ = value; realPitch_ = calcRealPitch (pitch_, switch_); });
+    params_.addRampReader(kPitchSwitchId, [this] () { return switch_; },
+                         [this](Sample64 value) {
+                             switch_ = value;
+                             realPitch_ = calcRealPitch (pitch_, switch_); });
 
     params_.addReader(kCurrentEntryId, [this] () { return double(currentEntry_) / (EMaximumSamples - 1.); },
                      [this](Sample64 value) {
@@ -160,12 +201,14 @@ AVinyl::AVinyl() :
                      [this](Sample64 value) {
                          currentScene_ = floor(value * double(EMaximumScenes - 1.) + 0.5);
                          dirtyParams_ = true;
+                         memoryDirty_ = true;
                      });
 
     params_.addReader(kLoopId, [this] () { return (samplesArray_.size() > currentEntry_) ? (samplesArray_.at(currentEntry_)->Loop ? 1. : 0.) : 0.; },
                      [this](Sample64 value) {
                          if (samplesArray_.size() > currentEntry_) {
                              samplesArray_.at(currentEntry_)->Loop = value > 0.5;
+                             changedEntries_.set(currentEntry_);
                          }
                      });
 
@@ -173,6 +216,7 @@ AVinyl::AVinyl() :
                      [this](Sample64 value) {
                          if (samplesArray_.size() > currentEntry_) {
                              samplesArray_.at(currentEntry_)->Sync = value > 0.5;
+                             changedEntries_.set(currentEntry_);
                          }
                      });
 
@@ -180,6 +224,7 @@ AVinyl::AVinyl() :
                      [this](Sample64 value) {
                          if (samplesArray_.size() > currentEntry_) {
                              samplesArray_.at(currentEntry_)->Reverse = value > 0.5;
+                             changedEntries_.set(currentEntry_);
                          }
                      });
 
@@ -187,6 +232,7 @@ AVinyl::AVinyl() :
                      [this](Sample64 value) {
                          if (samplesArray_.size() > currentEntry_) {
                              samplesArray_.at(currentEntry_)->Level = value * 2.0;
+                             changedEntries_.set(currentEntry_);
                          }
                      });
 
@@ -194,9 +240,24 @@ AVinyl::AVinyl() :
                      [this](Sample64 value) {
                          if (samplesArray_.size() > currentEntry_) {
                              samplesArray_.at(currentEntry_)->Tune = value > 0.5 ? value * 2.0 : value + 0.5;
+                             changedEntries_.set(currentEntry_);
+                         }
+                     });
+
+    params_.addReader(kInterpolationId, [this] () { return double(interpolation_) / (InterpolationQualityCount - 1.); },
+                     [this](Sample64 value) {
+                         interpolation_ = InterpolationQuality(floor(value * (InterpolationQualityCount - 1.) + 0.5));
+                         for (auto& entry : samplesArray_) {
+                             entry->interpolation(interpolation_);
                          }
                      });
 
+    params_.addReader(kOversamplingId, [this] () { return oversampling_ >= 4 ? 1. : oversampling_ >= 2 ? .5 : 0.; },
+                     [this](Sample64 value) {
+                         oversampling_ = size_t(1) << size_t(floor(value * 2. + 0.5));
+                         latency_ = currentLatency();
+                     });
+
     params_.addReader(kTimecodeLearnId, [this] () { return speedProcessor_.isLearning() ? 1. : 0.; },
                      [this](Sample64 value) {
                          if (value>0.5) {
@@ -238,13 +299,34 @@ tresult PLUGIN_API AVinyl::initialize(FUnknown* context) {
 
     reset(true);
     dirtyParams_ = false;
+    loader_.streamingFrames(EStreamingFrames);
+    loader_.compressFrames(ECompressFrames);
+    loader_.start(ELoaderThreads);
+    sampleCacheLimit(ECacheLimit);
+    timer_ = Timer::create(this, EMessagePeriod);
     return kResultOk;
 }
 
 tresult PLUGIN_API AVinyl::terminate()
 {
-    // nothing to do here yet...except calling our parent terminate
+    if (timer_) {
+        timer_->stop();
+        timer_->release();
+        timer_ = nullptr;
+    }
+    loader_.stop();
     samplesArray_.clear();
+    catalog_.clear();
+    pendingChanges_.clear();
+    SlotChange change;
+    while (changes_.pop(change)) {
+    }
+    SlotView view;
+    while (announced_.pop(view)) {
+    }
+    Restore restore;
+    while (restores_.pop(restore)) {
+    }
     return AudioEffect::terminate();
 }
 
@@ -255,10 +337,157 @@ tresult PLUGIN_API AVinyl::setActive(TBool state)
     return AudioEffect::setActive(state);
 }
 
+template<typename SampleType>
+void AVinyl::render(ProcessData& data, EventReader& events, Sample64& vuLeft, Sample64& vuRight)
+{
+    int32 sampleFrames = data.numSamples;
+    int32 sampleOffset = 0;
+
+    SampleType** in = channelBuffers<SampleType>(data.inputs[0]);
+    SampleType** out = channelBuffers<SampleType>(data.outputs[0]);
+
+    // the audio runs at InternalSample, the cursors' speed and tempo in double
+    InternalSample inL[EProcessFrames];
+    InternalSample inR[EProcessFrames];
+    InternalSample deckSpeed[EProcessFrames];
+    InternalSample deckVolume[EProcessFrames];
+    InternalSample outL[EProcessFrames];
+    InternalSample outR[EProcessFrames];
+    Sample64 pitch[EProcessFrames];
+    Sample64 level[EProcessFrames];
+    Sample64 speed[EProcessFrames];
+    Sample64 tempo[EProcessFrames];
+    InternalSample volume[EProcessFrames];
+
+    while (sampleOffset < sampleFrames) {
+
+        // the changes due on this frame go in first, the frames up to the next one
+        // are rendered as one block
+        params_.checkOffset(sampleOffset);
+
+        events.checkOffset(sampleOffset, [this](const Event& event) { processEvent(event); });
+
+        int32 blockEnd = std::min(sampleFrames, sampleOffset + EProcessFrames);
+        blockEnd = std::min(blockEnd, params_.nextOffset());
+        blockEnd = std::min(blockEnd, events.nextOffset());
+        blockEnd = std::max(blockEnd, sampleOffset + 1);
+        size_t count = size_t(blockEnd - sampleOffset);
+
+        // ramps toward a later point move pitch and volume every frame
+        if (params_.ramping()) {
+            Sample64 first[EProcessFrames];
+            Sample64 second[EProcessFrames];
+            Sample64 third[EProcessFrames];
+
+            params_.ramp(kGainId, sampleOffset, count, first);
+            params_.ramp(kVolumeId, sampleOffset, count, second);
+            params_.ramp(kVolCurveId, sampleOffset, count, third);
+            for (size_t i = 0; i < count; i++) {
+                level[i] = calcRealVolume(Sample32(first[i]), Sample32(second[i]), Sample32(third[i]));
+            }
+
+            params_.ramp(kPitchId, sampleOffset, count, first);
+            params_.ramp(kPitchSwitchId, sampleOffset, count, second);
+            for (size_t i = 0; i < count; i++) {
+                pitch[i] = calcRealPitch(Sample32(first[i]), Sample32(second[i]));
+            }
+
+            params_.settle(blockEnd - 1);
+        } else {
+            std::fill(pitch, pitch + count, realPitch_);
+            std::fill(level, level + count, realVolume_);
+        }
+
+        // a host at the internal precision is read and written in place. The detector takes
+        // the input before the output is cleared, so the two may be the same buffer
+        const InternalSample* left = inL;
+        const InternalSample* right = inR;
+        InternalSample* outLeft = outL;
+        InternalSample* outRight = outR;
+        if constexpr (std::is_same_v<SampleType, InternalSample>) {
+            left = in[0] + sampleOffset;
+            right = in[1] + sampleOffset;
+            outLeft = out[0] + sampleOffset;
+            outRight = out[1] + sampleOffset;
+        } else if (!bypass_) {
+            std::copy_n(in[0] + sampleOffset, count, inL);
+            std::copy_n(in[1] + sampleOffset, count, inR);
+        }
+
+        if (!bypass_) {
+            speedProcessor_.process(left, right, deckSpeed, deckVolume, count
+#ifdef DEVELOPMENT
+                                    ,[this](auto fftBuffer, size_t len) { debugInputMessage(fftBuffer, len); }
+                                    ,[this](auto fftBuffer, size_t len) { debugFftMessage(fftBuffer, len); }
+#endif // DEBUG
+                                    );
+        }
+
+        std::fill(outLeft, outLeft + count, InternalSample(0));
+        std::fill(outRight, outRight + count, InternalSample(0));
+
+        if (!bypass_) {
+
+            // the deck plays wherever the timecode moves, each such run goes through the effects at once
+            size_t runStart = 0;
+            while ((runStart < count) && (samplesArray_.size() > currentEntry_)) {
+                if (deckVolume[runStart] < 0.00001) {
+                    runStart++;
+                    continue;
+                }
+                size_t runEnd = runStart + 1;
+                while ((runEnd < count) && (deckVolume[runEnd] >= 0.00001)) {
+                    runEnd++;
+                }
+
+                for (size_t i = runStart; i < runEnd; i++) {
+                    speed[i] = deckSpeed[i] * pitch[i];
+                    tempo[i] = tempo_;
+                    volume[i] = InternalSample(level[i] * deckVolume[i]);
+                }
+
+                if (effectorSet_ != scheduledSet_) {
+                    // pads switch effects on the frame their event came on
+                    effector_->schedule(Effect::Type(effectorSet_));
+                    scheduledSet_ = effectorSet_;
+                }
+                EffectFrames<InternalSample> frames{outLeft + runStart, outRight + runStart, speed + runStart, tempo + runStart,
+                                                    volume + runStart, runEnd - runStart};
+                effector_->process(frames);
+
+                for (size_t i = runStart; i < runEnd; i++) {
+                    outLeft[i] = outLeft[i] * volume[i];
+                    outRight[i] = outRight[i] * volume[i];
+                    vuLeft = std::max(vuLeft, Sample64(outLeft[i]));
+                    vuRight = std::max(vuRight, Sample64(outRight[i]));
+                }
+
+                position_ = samplesArray_.at(currentEntry_)->cue().integerPart() / double(samplesArray_.at(currentEntry_)->bufferLength());
+                runStart = runEnd;
+            }
+        }
+
+        if constexpr (!std::is_same_v<SampleType, InternalSample>) {
+            std::copy_n(outL, count, out[0] + sampleOffset);
+            std::copy_n(outR, count, out[1] + sampleOffset);
+        }
+        sampleOffset = blockEnd;
+    }
+}
+
 tresult PLUGIN_API AVinyl::process(ProcessData& data)
 {
+    // the smoothers decay toward zero whenever the deck is quiet, denormals would crawl there
+    DenormalGuard denormalGuard;
+
     try {
 
+        applyChanges();
+        adoptLoadedEntries();
+        if (memoryDirty_) {
+            balanceMemory();
+        }
+
         bool samplesParamsUpdate = false;
         if (data.processContext) {
             sampleRate_ = data.processContext->sampleRate;
@@ -281,6 +510,8 @@ tresult PLUGIN_API AVinyl::process(ProcessData& data)
         ParameterWriter levelWriter(kAmpId, outParamChanges);
         ParameterWriter reverseWriter(kReverseId, outParamChanges);
         ParameterWriter tuneWriter(kTuneId, outParamChanges);
+        ParameterWriter interpolationWriter(kInterpolationId, outParamChanges);
+        ParameterWriter oversamplingWriter(kOversamplingId, outParamChanges);
 
         ParameterWriter entryWriter(kCurrentEntryId, outParamChanges);
         ParameterWriter sceneWriter(kCurrentSceneId, outParamChanges);
@@ -297,22 +528,12 @@ tresult PLUGIN_API AVinyl::process(ProcessData& data)
 
         ParameterWriter tcLearnWriter(kTimecodeLearnId, outParamChanges);
 
-        Event event;
-        Event* eventP = nullptr;
-        int32 eventIndex = 0;
+        EventReader events(eventList);
 
         Finalizer readTheRest([&]() {
 
             params_.flush();
-
-            while (eventList) {
-                if (eventList->getEvent(eventIndex++, event) != kResultOk) {
-                    eventList = nullptr;
-                }
-                else {
-                    processEvent(event);
-                }
-            }
+            events.flush([this](const Event& event) { processEvent(event); });
             });
 
 
@@ -327,10 +548,6 @@ tresult PLUGIN_API AVinyl::process(ProcessData& data)
         // (simplification) we suppose in this example that we have the same input channel count than the output
         int32 numChannels = data.inputs[0].numChannels;
 
-        // ---get audio buffers----------------
-        uint8_t** in = reinterpret_cast<uint8_t**>(data.inputs[0].channelBuffers64);
-        uint8_t** out = reinterpret_cast<uint8_t**>(data.outputs[0].channelBuffers64);
-
         Sample64 fVuLeft = 0.;
         Sample64 fVuRight = 0.;
         Sample64 fOldPosition = position_;
@@ -338,97 +555,11 @@ tresult PLUGIN_API AVinyl::process(ProcessData& data)
         Sample64 fOldSpeed = speedProcessor_.realSpeed();
 
         if (numChannels >= 2) {
-
-
-            int32 sampleFrames = data.numSamples;
-            int32 sampleOffset = 0;
-
-            uint8_t* ptrInLeft = in[0];
-            uint8_t* ptrOutLeft = out[0];
-            uint8_t* ptrInRight = in[1];
-            uint8_t* ptrOutRight = out[1];
-
-            while (--sampleFrames >= 0) {
-
-                params_.checkOffset(sampleOffset);
-
-                if (eventList) {
-                    if (eventP == nullptr) {
-                        if (eventList->getEvent(eventIndex++, event) != kResultOk) {
-                            eventList = nullptr;
-                            eventP = nullptr;
-                        }
-                        else {
-                            eventP = &event;
-                        }
-                    }
-                    if ((eventP != nullptr) && (event.sampleOffset == sampleOffset)) {
-                        processEvent(event);
-                        eventP = nullptr;
-                    }
-                }
-
-                Sample64 inL{0.};
-                Sample64 inR{0.};
-                Sample64 outL{0.};
-                Sample64 outR{0.};
-
-                if (!bypass_) {
-
-                    if (data.symbolicSampleSize == kSample64) {
-                        inL = *reinterpret_cast<Sample64*>(ptrInLeft);
-                        inR = *reinterpret_cast<Sample64*>(ptrInRight);
-                        ptrInLeft += sizeof(Sample64);
-                        ptrInRight += sizeof(Sample64);
-                    } else {
-                        inL = *reinterpret_cast<Sample32*>(ptrInLeft);
-                        inR = *reinterpret_cast<Sample32*>(ptrInRight);
-                        ptrInLeft += sizeof(Sample32);
-                        ptrInRight += sizeof(Sample32);
-                    }
-
-                    speedProcessor_.process(inL, inR
-#ifdef DEVELOPMENT
-                                            ,[this](auto fftBuffer, size_t len) { debugInputMessage(fftBuffer, len); }
-                                            ,[this](auto fftBuffer, size_t len) { debugFftMessage(fftBuffer, len); }
-#endif // DEBUG
-                                            );
-
-                    if ((speedProcessor_.volume() >= 0.00001) && (samplesArray_.size() > currentEntry_)) {
-
-
-                        Sample64 speed = speedProcessor_.realSpeed() * realPitch_;
-                        Sample64 tempo = tempo_;
-                        Sample64 volume = realVolume_ * speedProcessor_.volume();
-
-                        effector_.activeSet(Effect::Type(effectorSet_));
-                        effector_.process(outL, outR, speed, tempo, volume);
-
-                        outL = outL * volume;
-                        outR = outR * volume;
-
-                        position_ = samplesArray_.at(currentEntry_)->cue().integerPart() / double(samplesArray_.at(currentEntry_)->bufferLength());
-                        if (outL > fVuLeft) {
-                            fVuLeft = outL;
-                        }
-                        if (outR > fVuRight) {
-                            fVuRight = outR;
-                        }
-                    }
-                }
-
-                if (data.symbolicSampleSize == kSample64) {
-                    *reinterpret_cast<Sample64*>(ptrOutLeft) = outL;
-                    *reinterpret_cast<Sample64*>(ptrOutRight) = outR;
-                    ptrOutLeft += sizeof(Sample64);
-                    ptrOutRight += sizeof(Sample64);
-                } else {
-                    *reinterpret_cast<Sample32*>(ptrOutLeft) = outL;
-                    *reinterpret_cast<Sample32*>(ptrOutRight) = outR;
-                    ptrOutLeft += sizeof(Sample32);
-                    ptrOutRight += sizeof(Sample32);
-                }
-                sampleOffset++;
+            // the host's precision is settled once for the whole block
+            if (data.symbolicSampleSize == kSample64) {
+                render<Sample64>(data, events, fVuLeft, fVuRight);
+            } else {
+                render<Sample32>(data, events, fVuLeft, fVuRight);
             }
         }
 
@@ -455,6 +586,8 @@ tresult PLUGIN_API AVinyl::process(ProcessData& data)
 
             if (dirtyParams_) {
                 sceneWriter.store(data.numSamples - 1, currentScene_ / double(EMaximumScenes - 1.)); //????
+                interpolationWriter.store(data.numSamples - 1, double(interpolation_) / (InterpolationQualityCount - 1.));
+                oversamplingWriter.store(data.numSamples - 1, oversampling_ >= 4 ? 1. : oversampling_ >= 2 ? .5 : 0.);
                 if (samplesArray_.size() > currentEntry_) {
                     entryWriter.store(data.numSamples - 1, currentEntry_ / double(EMaximumSamples - 1.));
                     updatePadsMessage();
@@ -483,6 +616,8 @@ tresult PLUGIN_API AVinyl::process(ProcessData& data)
                 updateSpeedMessage(speedProcessor_.realSpeed());
             }
         }
+
+        announceEntries();
         vuLeft_ = fVuLeft;
         vuRight_ = fVuRight;
 
@@ -508,7 +643,7 @@ tresult PLUGIN_API AVinyl::canProcessSampleSize(int32 symbolicSampleSize)
 
 uint32 PLUGIN_API AVinyl::getLatencySamples()
 {
-    return ESpeedFrame;
+    return latency_;
 }
 
 uint32 PLUGIN_API AVinyl::getTailSamples()
@@ -516,6 +651,24 @@ uint32 PLUGIN_API AVinyl::getTailSamples()
     return ETimecodeLearnCount;
 }
 
+void AVinyl::onTimer(Timer* timer)
+{
+    flushChanges();
+    collectAnnounced();
+    requestRestores();
+    if (latency_ != reportedLatency_) {
+        reportedLatency_ = latency_;
+        latencyChangedMessage();
+    }
+}
+
+// the speed detector's frame, plus the oversampler: its filters run whenever the factor is
+// past 1x, with the distortion on or off
+uint32 AVinyl::currentLatency() const
+{
+    return ESpeedFrame + uint32(Oversampler<InternalSample>::latency(oversampling_));
+}
+
 tresult AVinyl::receiveText(const char* text)
 {
     // received from Controller
@@ -583,6 +736,8 @@ tresult PLUGIN_API AVinyl::setState(IBStream* state)
             }
         }
 
+        loader_.beginBatch(std::min<size_t>(savedEntryCount, EMaximumSamples - catalog_.size()));
+
         for (int i = 0; i < (int)savedEntryCount; i++) {
             uint32_t savedLoop;
             uint32_t savedReverse;
@@ -606,17 +761,23 @@ tresult PLUGIN_API AVinyl::setState(IBStream* state)
             reader.readInt16uArray((uint16_t *)bufname.data(), int32_t(bufname.size()));
             reader.readInt16uArray((uint16_t *)buffile.data(), int32_t(buffile.size()));
 
+            if (catalog_.size() >= EMaximumSamples) {
+                continue;
+            }
+
             String sName (bufname.data());
             String sFile (buffile.data());
 
-            samplesArray_.push_back(std::make_unique<SampleEntry<Sample64>>(sName, sFile));
-            samplesArray_.back()->index(samplesArray_.size());
-            samplesArray_.back()->Loop = savedLoop > 0;
-            samplesArray_.back()->Reverse = savedReverse > 0;
-            samplesArray_.back()->Sync = savedSync > 0;
-            samplesArray_.back()->Tune = savedTune;
-            samplesArray_.back()->Level = savedLevel;
+            // the playing entry first, then everything the current scene can trigger
+            size_t index = catalog_.size();
+            auto priority = Loader::Background;
+            if (index == currentEntry_) {
+                priority = Loader::Current;
+            } else if (pinnedEntry(index)) {
+                priority = Loader::Scene;
+            }
 
+            appendSlot(sName, sFile, priority, Loader::Settings{savedLoop > 0, savedSync > 0, savedReverse > 0, savedTune, savedLevel}, true);
         }
 
         for (unsigned j = 0; j < savedSceneCount; j++) {
@@ -627,17 +788,25 @@ tresult PLUGIN_API AVinyl::setState(IBStream* state)
             }
         }
 
-        float reserved1;
-        float reserved2;
-        reader.readFloat(reserved1);
-        reader.readFloat(reserved2);
+        float savedInterpolation = 0.f;
+        float savedOversampling = 0.f;
+        reader.readFloat(savedInterpolation);
+        reader.readFloat(savedOversampling);
 
-        // lockSpeed_ = reserved1;
-        // lockVolume_ = reserved2;
+        // 0 in states saved before the option existed
+        if ((savedInterpolation >= 1.f) && (savedInterpolation <= float(InterpolationQualityCount))) {
+            interpolation_ = InterpolationQuality(int(savedInterpolation) - 1);
+        } else {
+            interpolation_ = InterpolationQuality::Hermite;
+        }
 
-        effector_.activeSet(Effect::Type(effectorSet_));
+        // 0 in older states as well, those ran the distortion at the host rate
+        oversampling_ = (savedOversampling >= 4.f) ? 4 : (savedOversampling >= 2.f) ? 2 : 1;
+        latency_ = currentLatency();
 
+        // the audio thread picks the restored set up with its next frame
         dirtyParams_ = true;
+        memoryDirty_ = true;
         return kResultOk;
     }
     return kResultFalse;
@@ -646,6 +815,9 @@ tresult PLUGIN_API AVinyl::setState(IBStream* state)
 tresult PLUGIN_API AVinyl::getState(IBStream* state)
 {
     // here we need to save the model
+    // the settings the audio thread changed since the last timer tick
+    collectAnnounced();
+
     int8 byteOrder = BYTEORDER;
     if (state->write (&byteOrder, sizeof (int8)) == kResultTrue) {
 
@@ -661,9 +833,9 @@ tresult PLUGIN_API AVinyl::getState(IBStream* state)
         uint32_t toSaveEffector = effectorSet_;
         uint32_t toSavePadCount = ENumberOfPads;
         uint32_t toSaveSceneCount = EMaximumScenes;
-        uint32_t toSaveEntryCount = uint32_t(samplesArray_.size());
-        float reserved1 = 0;//lockSpeed_;
-        float reserved2 = 0;//lockVolume_;
+        uint32_t toSaveEntryCount = uint32_t(catalog_.size());
+        float toSaveInterpolation = float(interpolation_) + 1.f;
+        float toSaveOversampling = float(oversampling_);
 
         state->write(&toSaveGain, sizeof(float));
         state->write(&toSaveVolume, sizeof(float));
@@ -690,14 +862,14 @@ tresult PLUGIN_API AVinyl::getState(IBStream* state)
             }
         }
 
-        for (size_t i = 0; i < samplesArray_.size(); i++) {
-            uint32_t toSavedLoop = samplesArray_.at(i)->Loop ? 1 : 0;
-            uint32_t toSavedReverse = samplesArray_.at(i)->Reverse ? 1 : 0;
-            uint32_t toSavedSync = samplesArray_.at(i)->Sync ? 1 : 0;
-            float toSavedTune = samplesArray_.at(i)->Tune;
-            float toSavedLevel = samplesArray_.at(i)->Level;
-            String tmpName (samplesArray_.at(i)->name());
-            String tmpFile (samplesArray_.at(i)->fileName());
+        for (const auto& slot : catalog_) {
+            uint32_t toSavedLoop = slot.view.settings.Loop ? 1 : 0;
+            uint32_t toSavedReverse = slot.view.settings.Reverse ? 1 : 0;
+            uint32_t toSavedSync = slot.view.settings.Sync ? 1 : 0;
+            float toSavedTune = slot.view.settings.Tune;
+            float toSavedLevel = slot.view.settings.Level;
+            String tmpName (slot.name.c_str());
+            String tmpFile (slot.fileName.c_str());
             uint32_t toSaveNameLen = tmpName.length();
             uint32_t toSaveFileNameLen = tmpFile.length();
 
@@ -712,8 +884,8 @@ tresult PLUGIN_API AVinyl::getState(IBStream* state)
             state->write((void *)tmpFile.text16(), (toSaveFileNameLen + 1) * sizeof(TChar));
         }
 
-        state->write(&reserved1, sizeof(float));
-        state->write(&reserved2, sizeof(float));
+        state->write(&toSaveInterpolation, sizeof(float));
+        state->write(&toSaveOversampling, sizeof(float));
 
         return kResultOk;
     }
@@ -726,6 +898,10 @@ tresult PLUGIN_API AVinyl::setupProcessing(ProcessSetup& newSetup) {
     // here we keep a trace of the processing mode (offline,...) for example.
     currentProcessMode_ = newSetup.processMode;
 
+#if EResampleOnLoad
+    convertEntries(size_t(newSetup.sampleRate));
+#endif
+
     return AudioEffect::setupProcessing(newSetup);
 }
 
@@ -772,6 +948,7 @@ tresult PLUGIN_API AVinyl::notify(IMessage* message)
                 }
             }
             dirtyParams_ = true;
+            memoryDirty_ = true;
         }
         return kResultTrue;
     }
@@ -795,12 +972,11 @@ tresult PLUGIN_API AVinyl::notify(IMessage* message)
             memset(stringBuff, 0, 256 * sizeof(tchar));
             if (message->getAttributes()->getString("Sample", stringBuff, sizeof(stringBuff) / sizeof(TChar)) == kResultOk) {
                 String newName(stringBuff);
-                samplesArray_.push_back(std::make_unique<SampleEntry<Sample64>>(newName, newFile));
-                samplesArray_.back()->index(samplesArray_.size());
-                if (currentEntry_ == (samplesArray_.back()->index() - 1)) {
-                    padSet(currentEntry_);
+                if (catalog_.size() >= EMaximumSamples) {
+                    return kResultFalse;
                 }
-                addSampleMessage(samplesArray_.back().get());
+                appendSlot(newName, newFile, Loader::Current, std::nullopt);
+                addSampleMessage(catalog_.size() - 1);
                 dirtyParams_ = true;
             }
         }
@@ -814,8 +990,18 @@ tresult PLUGIN_API AVinyl::notify(IMessage* message)
             String newFile(stringBuff);
             if (message->getAttributes()->getString("Sample", stringBuff, sizeof (stringBuff) / sizeof (TChar)) == kResultOk) {
                 String newName(stringBuff);
-                samplesArray_[currentEntry_] = std::make_unique<SampleEntry<Sample64>>(newName, newFile);
-                samplesArray_[currentEntry_]->index(currentEntry_ + 1);
+                size_t index = currentEntry_;
+                if (index < catalog_.size()) {
+                    // the old entry keeps playing until the new one is decoded,
+                    // the editor shows the slot loading meanwhile
+                    auto& slot = catalog_.at(index);
+                    slot.name = newName.text8();
+                    slot.fileName = newFile.text8();
+                    slot.view = SlotView();
+                    slot.view.slot = slot.id;
+                    loadSlot(index, Loader::Current, std::nullopt);
+                    addSampleMessage(index);
+                }
             }
         }
         return kResultTrue;
@@ -825,9 +1011,10 @@ tresult PLUGIN_API AVinyl::notify(IMessage* message)
         TChar stringBuff[256] = {0};
         if (message->getAttributes()->getString("SampleName", stringBuff, sizeof(stringBuff) / sizeof(TChar)) == kResultOk) {
             int64 sampleIndex;
-            if (message->getAttributes()->getInt("SampleNumber", sampleIndex) == kResultOk) {
+            if ((message->getAttributes()->getInt("SampleNumber", sampleIndex) == kResultOk)
+                && (sampleIndex >= 0) && (size_t(sampleIndex) < catalog_.size())) {
                 String newName(stringBuff);
-                samplesArray_.at(currentEntry_)->name(newName);
+                catalog_.at(size_t(sampleIndex)).name = newName.text8();
             }
         }
         return kResultTrue;
@@ -835,16 +1022,11 @@ tresult PLUGIN_API AVinyl::notify(IMessage* message)
 
     if (strcmp(message->getMessageID(), "deleteEntry") == 0) {
         int64 sampleIndex {0};
-        if (message->getAttributes()->getInt ("SampleNumber", sampleIndex) == kResultOk) {
-            delSampleMessage(samplesArray_.at(sampleIndex).get());
-            samplesArray_.erase(samplesArray_.begin() + sampleIndex);
-            for (size_t i = sampleIndex; i < samplesArray_.size(); i++) {
-                samplesArray_.at(i)->index(i + 1);
-            }
-            padRemove(sampleIndex);
-            dirtyParams_ = true;
+        if ((message->getAttributes()->getInt ("SampleNumber", sampleIndex) == kResultOk)
+            && (sampleIndex >= 0) && (size_t(sampleIndex) < catalog_.size())) {
+            delSampleMessage(size_t(sampleIndex));
+            removeSlot(size_t(sampleIndex));
         }
-        currentEntry(currentEntry_);
         return kResultTrue;
     } 
 
@@ -856,62 +1038,371 @@ tresult PLUGIN_API AVinyl::notify(IMessage* message)
     return AudioEffect::notify (message);
 }
 
-void AVinyl::addSampleMessage(SampleEntry<Sample64>* newSample)
+void AVinyl::appendSlot(const char* name, const char* fileName, Loader::Priority priority, std::optional<Loader::Settings> settings, bool batch)
+{
+    Slot slot {name ? name : "", fileName ? fileName : "", ++slotIds_, 0, SlotView()};
+    slot.view.slot = slot.id;
+    if (settings) {
+        slot.view.settings = *settings;
+    }
+
+    // placeholder stays silent until the loader hands over the decoded entry
+    auto entry = std::make_unique<Entry>(name);
+    entry->fileName(fileName);
+    entry->index(catalog_.size() + 1);
+    entry->Loop = slot.view.settings.Loop;
+    entry->Sync = slot.view.settings.Sync;
+    entry->Reverse = slot.view.settings.Reverse;
+    entry->Tune = slot.view.settings.Tune;
+    entry->Level = slot.view.settings.Level;
+    entry->loading(true);
+
+    pendingChanges_.push_back(PendingChange{SlotChange{SlotChange::Append, catalog_.size(), slot.id, std::move(entry)}, priority, settings, batch});
+    catalog_.push_back(std::move(slot));
+    flushChanges();
+}
+
+void AVinyl::removeSlot(size_t index)
+{
+    if (index < catalog_.size()) {
+        pendingChanges_.push_back(PendingChange{SlotChange{SlotChange::Remove, index, catalog_.at(index).id, nullptr}, Loader::Background, std::nullopt, false});
+        catalog_.erase(catalog_.begin() + index);
+        flushChanges();
+    }
+}
+
+void AVinyl::loadSlot(size_t index, Loader::Priority priority, std::optional<Loader::Settings> settings, bool batch)
+{
+    auto& slot = catalog_.at(index);
+    slot.generation = ++generations_;
+    loader_.load(Loader::Ticket{index, slot.id, slot.generation}, slot.name.c_str(), slot.fileName.c_str(), priority, settings, batch);
+}
+
+void AVinyl::flushChanges()
 {
-    if (newSample) {
+    while (!pendingChanges_.empty()) {
+        auto& pending = pendingChanges_.front();
+        bool append = pending.change.type == SlotChange::Append;
+        uint64_t id = pending.change.slot;
+        if (!changes_.push(std::move(pending.change))) {
+            // the audio thread is not processing, the timer tries again
+            break;
+        }
+        // a load can only find a slot the audio thread already has
+        if (append) {
+            auto slot = std::find_if(catalog_.begin(), catalog_.end(), [id](const Slot& known) { return known.id == id; });
+            if (slot != catalog_.end()) {
+                loadSlot(size_t(slot - catalog_.begin()), pending.priority, pending.settings, pending.batch);
+            }
+        }
+        pendingChanges_.pop_front();
+    }
+}
+
+void AVinyl::collectAnnounced()
+{
+    SlotView view;
+    while (announced_.pop(view)) {
+        uint64_t id = view.slot;
+        auto slot = std::find_if(catalog_.begin(), catalog_.end(), [id](const Slot& known) { return known.id == id; });
+        // removed meanwhile, or the slot is about to get the load asked for last
+        if ((slot == catalog_.end()) || (view.generation < slot->generation)) {
+            continue;
+        }
+        bool loaded = view.kind == SlotView::Loaded;
+        slot->view = std::move(view);
+        if (loaded) {
+            addSampleMessage(size_t(slot - catalog_.begin()));
+        }
+    }
+}
+
+void AVinyl::requestRestores()
+{
+    Restore restore;
+    while (restores_.pop(restore)) {
+        uint64_t id = restore.slot;
+        auto slot = std::find_if(catalog_.begin(), catalog_.end(), [id](const Slot& known) { return known.id == id; });
+        if (slot != catalog_.end()) {
+            loadSlot(size_t(slot - catalog_.begin()), restore.priority, restore.settings);
+        }
+    }
+}
+
+void AVinyl::addSampleMessage(size_t index)
+{
+    if (index < catalog_.size()) {
+        const auto& slot = catalog_.at(index);
         IMessage* msg = allocateMessage ();
         if (msg) {
             msg->setMessageID("addEntry");
-            msg->getAttributes()->setBinary("EntryBufferLeft", newSample->bufferLeft(), uint32_t(newSample->bufferLength() * sizeof(Sample64)));
-            msg->getAttributes()->setBinary("EntryBufferRight", newSample->bufferRight(), uint32_t(newSample->bufferLength() * sizeof(Sample64)));
-            msg->getAttributes()->setInt("EntryLoop", newSample->Loop ? 1 : 0);
-            msg->getAttributes()->setInt("EntrySync", newSample->Sync ? 1 : 0);
-            msg->getAttributes()->setInt("EntryReverse", newSample->Reverse ? 1 : 0);
-            msg->getAttributes()->setInt("EntryIndex", int64_t(newSample->index()));
-            msg->getAttributes()->setInt("EntryBeats", int64_t(newSample->acidBeats()));
-            msg->getAttributes()->setFloat("EntryTune", newSample->Tune);
-            msg->getAttributes()->setFloat("EntryLevel", newSample->Level);
-            msg->getAttributes()->setString("EntryName", String(newSample->name()));
-            msg->getAttributes()->setString("EntryFile", String(newSample->fileName()));
+            setWaveformAttributes<InternalSample>(msg->getAttributes(), slot.view.overview, slot.view.analysis, slot.view.length);
+            msg->getAttributes()->setInt("EntryLoop", slot.view.settings.Loop ? 1 : 0);
+            msg->getAttributes()->setInt("EntrySync", slot.view.settings.Sync ? 1 : 0);
+            msg->getAttributes()->setInt("EntryReverse", slot.view.settings.Reverse ? 1 : 0);
+            msg->getAttributes()->setInt("EntryIndex", int64_t(index + 1));
+            msg->getAttributes()->setInt("EntryBeats", int64_t(slot.view.acidBeats));
+            msg->getAttributes()->setInt("EntryLoading", slot.view.loading ? 1 : 0);
+            msg->getAttributes()->setFloat("EntryTune", slot.view.settings.Tune);
+            msg->getAttributes()->setFloat("EntryLevel", slot.view.settings.Level);
+            msg->getAttributes()->setString("EntryName", String(slot.name.c_str()));
+            msg->getAttributes()->setString("EntryFile", String(slot.fileName.c_str()));
             sendMessage(msg);
             msg->release();
         }
     }
 }
 
-void AVinyl::delSampleMessage(SampleEntry<Sample64> *delSample)
+void AVinyl::applyChanges()
 {
-    if (delSample) {
-        IMessage* msg = allocateMessage ();
-        if (msg) {
-            msg->setMessageID("delEntry");
-            msg->getAttributes()->setInt("EntryIndex", delSample->index() - 1);
-            sendMessage(msg);
-            msg->release ();
+    SlotChange change;
+    // each change may hand one entry over, the rest wait while the loader has no room
+    while (loader_.canRetire() && changes_.pop(change)) {
+        if (change.type == SlotChange::Append) {
+            size_t index = samplesArray_.size();
+            if (index < EMaximumSamples) {
+                tickets_[index] = Loader::Ticket{index, change.slot, 0};
+                loadedEntries_.reset(index);
+                changedEntries_.reset(index);
+                change.entry->interpolation(interpolation_);
+                samplesArray_.push_back(std::move(change.entry));
+                if (currentEntry_ == index) {
+                    padSet(currentEntry_);
+                }
+                dirtyParams_ = true;
+            }
+        } else {
+            size_t index = slotIndex(Loader::Ticket{change.index, change.slot, 0});
+            if (index < samplesArray_.size()) {
+                loader_.retire(std::move(samplesArray_.at(index)));
+                samplesArray_.erase(samplesArray_.begin() + index);
+                for (size_t i = index; i < samplesArray_.size(); i++) {
+                    samplesArray_.at(i)->index(i + 1);
+                    tickets_[i] = tickets_[i + 1];
+                    tickets_[i].index = i;
+                    loadedEntries_[i] = loadedEntries_[i + 1];
+                    changedEntries_[i] = changedEntries_[i + 1];
+                }
+                loadedEntries_.reset(samplesArray_.size());
+                changedEntries_.reset(samplesArray_.size());
+                padRemove(int(index));
+                budget_.erase(index);
+                dirtyParams_ = true;
+                memoryDirty_ = true;
+            }
+            currentEntry(currentEntry_);
         }
+        // an append past the last slot
+        loader_.retire(std::move(change.entry));
     }
 }
 
-void AVinyl::debugFftMessage(Sample64* fft, size_t len)
+size_t AVinyl::slotIndex(const Loader::Ticket& ticket) const
+{
+    if ((ticket.index < samplesArray_.size()) && (tickets_[ticket.index].slot == ticket.slot)) {
+        return ticket.index;
+    }
+    // slots were removed meanwhile, the rest moved down
+    for (size_t index = 0; index < samplesArray_.size(); index++) {
+        if (tickets_[index].slot == ticket.slot) {
+            return index;
+        }
+    }
+    return samplesArray_.size();
+}
+
+void AVinyl::adoptLoadedEntries()
+{
+    Loader::Loaded loaded;
+    while (loader_.fetch(loaded)) {
+        size_t index = slotIndex(loaded.ticket);
+        // removed slots take nothing, a slot asked for twice keeps the later load whatever finished first
+        if ((index < samplesArray_.size()) && (loaded.ticket.generation > tickets_[index].generation)) {
+            auto& previous = samplesArray_.at(index);
+            if (!previous->loading() && (previous->sampleRate() > 0) && (loaded.entry->sampleRate() != previous->sampleRate())) {
+                // converted to a new rate, keep the playing position
+                double ratio = double(loaded.entry->sampleRate()) / double(previous->sampleRate());
+                Entry::CuePoint cue;
+                cue = (double(previous->cue().integerPart()) + previous->cue().floatPart()) * ratio;
+                loaded.entry->cue(cue);
+            }
+            loaded.entry->index(index + 1);
+            loaded.entry->interpolation(interpolation_);
+            std::swap(samplesArray_.at(index), loaded.entry);
+            tickets_[index].generation = loaded.ticket.generation;
+            loadedEntries_.set(index);
+            budget_.restored(index);
+            dirtyParams_ = true;
+            memoryDirty_ = true;
+        }
+        loader_.retire(std::move(loaded.entry));
+    }
+
+    Loader::Analyzed analyzed;
+    while (loader_.fetch(analyzed)) {
+        size_t index = slotIndex(analyzed.ticket);
+        if ((index < samplesArray_.size())
+            && (tickets_[index].generation == analyzed.ticket.generation)
+            && (samplesArray_.at(index)->source() == analyzed.source)) {
+            samplesArray_.at(index)->analysis(analyzed.analysis);
+            // the editor redraws the beat markers
+            loadedEntries_.set(index);
+        }
+    }
+}
+
+void AVinyl::announceEntries()
+{
+    // only references change hands here, the message thread builds the editor's messages
+    for (size_t index = 0; index < samplesArray_.size(); index++) {
+        if (!loadedEntries_.test(index) && !changedEntries_.test(index)) {
+            continue;
+        }
+        const auto& entry = *samplesArray_.at(index);
+        SlotView view;
+        view.kind = loadedEntries_.test(index) ? SlotView::Loaded : SlotView::Changed;
+        view.slot = tickets_[index].slot;
+        view.generation = tickets_[index].generation;
+        view.overview = entry.overview();
+        view.analysis = entry.analysis();
+        view.length = entry.bufferLength();
+        view.acidBeats = entry.acidBeats();
+        view.sampleRate = entry.sampleRate();
+        view.loading = entry.loading();
+        view.evicted = entry.evicted();
+        view.settings = Loader::Settings{entry.Loop, entry.Sync, entry.Reverse, entry.Tune, entry.Level};
+        if (!announced_.push(std::move(view))) {
+            // the rest follow with the next block
+            break;
+        }
+        loadedEntries_.reset(index);
+        changedEntries_.reset(index);
+    }
+}
+
+void AVinyl::convertEntries(size_t sampleRate)
+{
+    if (sampleRate == loader_.targetRate()) {
+        return;
+    }
+    loader_.targetRate(sampleRate);
+
+    // pending loads pick the new rate up themselves
+    collectAnnounced();
+    for (size_t index = 0; index < catalog_.size(); index++) {
+        const auto& slot = catalog_.at(index);
+        if (slot.view.loading || slot.view.evicted || (slot.view.generation < slot.generation)
+            || slot.fileName.empty() || (slot.view.sampleRate == sampleRate)) {
+            continue;
+        }
+        loadSlot(index,
+                 index == currentEntry_ ? Loader::Current : Loader::Background,
+                 slot.view.settings);
+    }
+}
+
+void AVinyl::balanceMemory()
+{
+    memoryDirty_ = false;
+
+    // the current entry and the current scene's pads come back ahead of use,
+    // the message thread asks the loader for them
+    for (size_t index = 0; index < samplesArray_.size(); index++) {
+        auto& entry = samplesArray_.at(index);
+        if (entry->evicted() && !entry->loading() && pinnedEntry(index)) {
+            Restore restore;
+            restore.slot = tickets_[index].slot;
+            restore.priority = index == currentEntry_ ? Loader::Current : Loader::Scene;
+            restore.settings = Loader::Settings{entry->Loop, entry->Sync, entry->Reverse, entry->Tune, entry->Level};
+            if (!restores_.push(std::move(restore))) {
+                memoryDirty_ = true;
+                break;
+            }
+            entry->loading(true);
+            budget_.restoring(index);
+        }
+    }
+
+    // an eviction hands the audio and the overview over, without room both stay for now
+    bool held = false;
+    auto usage = budget_.balance(samplesArray_.size(),
+                                 [this](size_t index) { return samplesArray_.at(index)->memorySize(); },
+                                 [this, &held](size_t index) {
+                                     // streams hold a fixed page ring, evicted slots have nothing left to give
+                                     auto& entry = samplesArray_.at(index);
+                                     if (pinnedEntry(index) || entry->streaming() || entry->evicted()) {
+                                         return true;
+                                     }
+                                     held = held || !loader_.canRetireData(2);
+                                     return held;
+                                 },
+                                 [this](size_t index) {
+                                     samplesArray_.at(index)->evict([this](auto&& data) { loader_.retire(std::move(data)); });
+                                     changedEntries_.set(index);
+                                 });
+    if (held) {
+        memoryDirty_ = true;
+    }
+    if (usage != memoryUsage_) {
+        memoryUsage_ = usage;
+        updateMemoryMessage();
+    }
+}
+
+bool AVinyl::pinnedEntry(size_t index) const
+{
+    if (index == currentEntry_) {
+        return true;
+    }
+    if (currentScene_ < EMaximumScenes) {
+        for (int pad = 0; pad < ENumberOfPads; pad++) {
+            if ((padStates_[currentScene_][pad].padType == PadEntry::SamplePad)
+                && (padStates_[currentScene_][pad].padTag == int(index))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void AVinyl::delSampleMessage(size_t index)
+{
+    IMessage* msg = allocateMessage ();
+    if (msg) {
+        msg->setMessageID("delEntry");
+        msg->getAttributes()->setInt("EntryIndex", int64(index));
+        sendMessage(msg);
+        msg->release ();
+    }
+}
+
+void AVinyl::debugFftMessage(const InternalSample* fft, size_t len)
 {
     if (fft) {
         IMessage* msg = allocateMessage();
         if (msg) {
+            // the view takes doubles whatever the deck runs at
+            Sample64 entry[EFFTFrame];
+            len = std::min(len, size_t(EFFTFrame));
+            std::copy_n(fft, len, entry);
             msg->setMessageID("debugFft");
-            msg->getAttributes()->setBinary("Entry", fft, uint32_t(len * sizeof(Sample64)));
+            msg->getAttributes()->setBinary("Entry", entry, uint32_t(len * sizeof(Sample64)));
             sendMessage(msg);
             msg->release();
         }
     }
 }
 
-void AVinyl::debugInputMessage(Sample64* input, size_t len)
+void AVinyl::debugInputMessage(const InternalSample* input, size_t len)
 {
     if (input) {
         IMessage* msg = allocateMessage();
         if (msg) {
+            Sample64 entry[EFFTFrame];
+            len = std::min(len, size_t(EFFTFrame));
+            std::copy_n(input, len, entry);
             msg->setMessageID("debugInput");
-            msg->getAttributes()->setBinary("Entry", input, uint32_t(len * sizeof(Sample64)));
+            msg->getAttributes()->setBinary("Entry", entry, uint32_t(len * sizeof(Sample64)));
             sendMessage(msg);
             msg->release();
         }
@@ -920,24 +1411,9 @@ void AVinyl::debugInputMessage(Sample64* input, size_t len)
 
 void AVinyl::initSamplesMessage(void)
 {
-    for (size_t i = 0; i < samplesArray_.size(); i++) {
-        IMessage* msg = allocateMessage();
-        if (msg) {
-            msg->setMessageID("addEntry");
-            msg->getAttributes()->setBinary("EntryBufferLeft", samplesArray_.at(i)->bufferLeft(), uint32_t(samplesArray_.at(i)->bufferLength() * sizeof(Sample64)));
-            msg->getAttributes()->setBinary("EntryBufferRight", samplesArray_.at(i)->bufferRight(), uint32_t(samplesArray_.at(i)->bufferLength() * sizeof(Sample64)));
-            msg->getAttributes()->setInt("EntryLoop", samplesArray_.at(i)->Loop ? 1 : 0);
-            msg->getAttributes()->setInt("EntrySync", samplesArray_.at(i)->Sync ? 1 : 0);
-            msg->getAttributes()->setInt("EntryReverse", samplesArray_.at(i)->Reverse ? 1 : 0);
-            msg->getAttributes()->setInt("EntryIndex", int64_t(samplesArray_.at(i)->index()));
-            msg->getAttributes()->setInt("EntryBeats", int64_t(samplesArray_.at(i)->acidBeats()));
-            msg->getAttributes()->setFloat("EntryTune", samplesArray_.at(i)->Tune);
-            msg->getAttributes()->setFloat("EntryLevel", samplesArray_.at(i)->Level);
-            msg->getAttributes()->setString("EntryName", String(samplesArray_.at(i)->name()));
-            msg->getAttributes()->setString("EntryFile", String(samplesArray_.at(i)->fileName()));
-            sendMessage(msg);
-            msg->release ();
-        }
+    collectAnnounced();
+    for (size_t i = 0; i < catalog_.size(); i++) {
+        addSampleMessage(i);
     }
 }
 
@@ -978,6 +1454,29 @@ void AVinyl::updatePadsMessage(void)
     }
 }
 
+void AVinyl::updateMemoryMessage(void)
+{
+    IMessage* msg = allocateMessage ();
+    if (msg) {
+        msg->setMessageID("updateMemory");
+        msg->getAttributes()->setInt("ResidentBytes", int64(memoryUsage_.resident));
+        msg->getAttributes()->setInt("EvictedBytes", int64(memoryUsage_.evicted));
+        msg->getAttributes()->setInt("PendingBytes", int64(memoryUsage_.pending));
+        sendMessage(msg);
+        msg->release();
+    }
+}
+
+void AVinyl::latencyChangedMessage(void)
+{
+    IMessage* msg = allocateMessage ();
+    if (msg) {
+        msg->setMessageID("latencyChanged");
+        sendMessage(msg);
+        msg->release();
+    }
+}
+
 void AVinyl::processEvent(const Event &event)
 {
     switch (event.type) {
@@ -1007,7 +1506,7 @@ void AVinyl::processEvent(const Event &event)
 void AVinyl::reset(bool state)
 {
     if (state) {
-        speedProcessor_ = SpeedProcessor<Sample64, ESpeedFrame, EFFTFrame, EFilterFrame>();
+        speedProcessor_ = SpeedProcessor<InternalSample, ESpeedFrame, EFFTFrame, EFilterFrame>();
     } else {
         // reset the VuMeter value
         vuLeft_ = 0.;
@@ -1028,6 +1527,8 @@ void AVinyl::currentEntry(int64_t newentry)
     if (newentry < int64_t(samplesArray_.size())) {
         samplesArray_.at(newentry)->resetCursor();
     }
+    budget_.touch(currentEntry_);
+    memoryDirty_ = true;
     position_ = 0;
 }
 
@@ -2,22 +2,39 @@
 
 #include "public.sdk/source/vst/vstaudioeffect.h"
 #include "pluginterfaces/vst/ivstevents.h"
+#include "base/source/timer.h"
 
 #include "helpers/sampleentry.h"
+#include "helpers/sampleloader.h"
+#include "helpers/samplebudget.h"
 #include "helpers/parameterreader.h"
+#include "helpers/eventreader.h"
 #include "helpers/padentry.h"
+#include "helpers/lockfreequeue.h"
 #include "helpers/speedprocessor.h"
 #include "effects/effector.h"
 
 #include "vinylconfigconst.h"
+#include "vinylparamids.h"
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <type_traits>
 
 namespace Steinberg {
 namespace Vst {
 
+// what the detector, the deck and the effects run at, the host's blocks are converted to it
+using InternalSample = std::conditional_t<EInternalDouble, Sample64, Sample32>;
+
 //------------------------------------------------------------------------
 // AVinyl: directly derived from the helper class AudioEffect
 //------------------------------------------------------------------------
-class AVinyl: public AudioEffect
+class AVinyl: public AudioEffect, public ITimerCallback
 {
 public:
 	AVinyl ();
@@ -66,30 +83,123 @@ public:
     uint32 PLUGIN_API getLatencySamples() override;
     uint32 PLUGIN_API getTailSamples() override;
 
+    /** Message thread: forwards what the audio thread announced and hands it the pending slot changes */
+    void onTimer(Timer* timer) override;
+
+    using MemoryUsage = SampleBudget<EMaximumSamples>::Usage;
+
+    // bytes of audio the slots hold, have given up and are reloading
+    const MemoryUsage& memoryUsage() const {
+        return memoryUsage_;
+    }
+
 private:
 
+    using Loader = SampleLoader<InternalSample>;
+    using Entry = SampleEntry<InternalSample>;
+
+    // what the message thread keeps of a slot, copied on the audio thread without allocating
+    struct SlotView {
+        enum Kind {
+            Loaded,      // new audio or analysis, the editor is sent the slot again
+            Changed      // slot settings only
+        };
+
+        Kind kind {Loaded};
+        uint64_t slot {0};
+        uint64_t generation {0};
+        Entry::DataPtr overview;
+        SampleAnalysis analysis;
+        size_t length {0};
+        size_t acidBeats {0};
+        size_t sampleRate {0};
+        bool loading {true};
+        bool evicted {false};
+        Loader::Settings settings {false, false, false, 1., 1.};
+    };
+
+    // structural changes of the slots, the audio thread applies them in order
+    struct SlotChange {
+        enum Type {
+            Append,
+            Remove
+        };
+
+        Type type {Append};
+        size_t index {0};
+        uint64_t slot {0};
+        std::unique_ptr<Entry> entry;   // the silent placeholder an append starts with
+    };
+
+    // a change the audio thread has not taken yet, an append loads its file once it has
+    struct PendingChange {
+        SlotChange change;
+        Loader::Priority priority;
+        std::optional<Loader::Settings> settings;
+        bool batch;
+    };
+
+    // an evicted slot the audio thread needs back, the message thread asks the loader
+    struct Restore {
+        uint64_t slot {0};
+        Loader::Priority priority {Loader::Background};
+        Loader::Settings settings {false, false, false, 1., 1.};
+    };
+
+    // message thread only
+    struct Slot {
+        std::string name;
+        std::string fileName;
+        uint64_t id;
+        uint64_t generation;     // of the latest load asked for
+        SlotView view;
+    };
+
     void currentEntry(int64_t newentry);
 
     bool padWork(int padId, double paramValue);
     bool padSet(int currentSample);
     void padRemove(int currentSample);
 
-    // SampleBase manipulation
-    void addSampleMessage(SampleEntry<Sample64>* newSample);
-    void delSampleMessage(SampleEntry<Sample64>* delSample);
+    // SampleBase manipulation, message thread
+    void appendSlot(const char* name, const char* fileName, Loader::Priority priority, std::optional<Loader::Settings> settings, bool batch = false);
+    void removeSlot(size_t index);
+    void loadSlot(size_t index, Loader::Priority priority, std::optional<Loader::Settings> settings, bool batch = false);
+    void flushChanges();
+    void collectAnnounced();
+    void requestRestores();
+    void convertEntries(size_t sampleRate);
+    void addSampleMessage(size_t index);
+    void delSampleMessage(size_t index);
+
+    // SampleBase manipulation, audio thread
+    void applyChanges();
+    void adoptLoadedEntries();
+    void announceEntries();
+    void balanceMemory();
+    bool pinnedEntry(size_t index) const;
+    size_t slotIndex(const Loader::Ticket& ticket) const;
     void initSamplesMessage(void);
     void updateSpeedMessage(Sample64 speed);
     void updatePositionMessage(Sample64 speed);
     void updatePadsMessage(void);
+    void updateMemoryMessage(void);
+    void latencyChangedMessage(void);
+    uint32 currentLatency() const;
 
-    void debugFftMessage(Sample64 *fft, size_t len);
-    void debugInputMessage(Sample64 *input, size_t len);
+    void debugFftMessage(const InternalSample *fft, size_t len);
+    void debugInputMessage(const InternalSample *input, size_t len);
+
+    // the frames of a block, rendered in sub-blocks between parameter and event changes
+    template<typename SampleType>
+    void render(ProcessData& data, EventReader& events, Sample64& vuLeft, Sample64& vuRight);
 
     void processEvent(const Event &event);
     void reset(bool state);
 
-    SpeedProcessor<Sample64, ESpeedFrame, EFFTFrame, EFilterFrame> speedProcessor_;
+    SpeedProcessor<InternalSample, ESpeedFrame, EFFTFrame, EFilterFrame> speedProcessor_;
     int32_t effectorSet_;
+    int32_t scheduledSet_;
 
 	// our model values
     Sample32 vuLeft_;
@@ -104,7 +214,26 @@ private:
     Sample32 curve_;         //0..+1
     bool bypass_;
 
-    std::vector<std::unique_ptr<SampleEntry<Sample64>>> samplesArray_;
+    // the slots as the audio thread plays them, only ever changed by the audio thread
+    std::vector<std::unique_ptr<Entry>> samplesArray_;
+    std::array<Loader::Ticket, EMaximumSamples> tickets_;   // the load each slot holds
+    Loader loader_;
+    std::bitset<EMaximumSamples> loadedEntries_;     // to announce with the editor's copy
+    std::bitset<EMaximumSamples> changedEntries_;    // to announce, settings only
+
+    // the slots as the message thread sees them, ahead of the audio thread by the pending changes
+    std::vector<Slot> catalog_;
+    std::deque<PendingChange> pendingChanges_;
+    uint64_t slotIds_;
+    std::atomic<uint64_t> generations_;
+    LockFreeQueue<SlotChange, EMaximumSamples> changes_;
+    LockFreeQueue<SlotView, EMaximumSamples> announced_;
+    LockFreeQueue<Restore, EMaximumSamples> restores_;
+    Timer* timer_;
+
+    SampleBudget<EMaximumSamples> budget_;
+    MemoryUsage memoryUsage_;
+    bool memoryDirty_;
 
     PadEntry padStates_[EMaximumScenes][ENumberOfPads];
 
@@ -113,6 +242,11 @@ private:
 
     bool dirtyParams_;
 
+    InterpolationQuality interpolation_;
+    size_t oversampling_;
+    std::atomic<uint32> latency_;    // follows oversampling_, read by the host
+    uint32 reportedLatency_;         // message thread, what the controller last heard
+
     double sampleRate_;
     double tempo_;
     size_t noteLength_;
@@ -120,8 +254,8 @@ private:
     Sample64 realPitch_;
     Sample64 realVolume_;
 
-    ReaderManager params_;
-    Effector effector_;
+    ReaderManager<kParamCount> params_;
+    std::unique_ptr<Effector<InternalSample>> effector_;
 };
 
 
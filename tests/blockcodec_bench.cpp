@@ -0,0 +1,90 @@
+// Size and decode cost of the compressed sample store on a 16 and a 24 bit track.
+// Bytes per stereo frame are set against 4 for plain int16 (6 for packed int24), the
+// decode time is per block of BlockFrames frames as a playing slot pulls them in.
+// usage: blockcodec_bench [seconds] [rounds]
+
+#include "helpers/blockcodec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Store = CompressedSamples<double>;
+
+constexpr double Pi = 3.14159265358979323846;
+constexpr double sampleRate = 44100.;
+
+// a bass line, a lead and a hi-hat like noise burst every beat, right a little apart from left
+void track(int bits, size_t frames, std::vector<double>& left, std::vector<double>& right) {
+    const double scale = double((int64_t(1) << (bits - 1)) - 1);
+    std::mt19937 generator(36);
+    std::uniform_real_distribution<double> noise(-1., 1.);
+    left.resize(frames);
+    right.resize(frames);
+    for (size_t i = 0; i < frames; i++) {
+        double t = double(i) / sampleRate;
+        double beat = fmod(t * 2., 1.);
+        double hat = 0.15 * exp(-beat * 40.) * noise(generator);
+        double bass = 0.4 * sin(2. * Pi * 55. * t) * (1. - 0.5 * beat);
+        double lead = 0.2 * sin(2. * Pi * 440. * t + 2. * sin(2. * Pi * 5. * t));
+        double l = bass + lead + hat + 0.002 * noise(generator);
+        double r = bass + 0.8 * lead + hat + 0.002 * noise(generator);
+        left[i] = double(std::llrint(l * scale)) / scale;
+        right[i] = double(std::llrint(r * scale)) / scale;
+    }
+}
+
+void row(int bits, double seconds, int rounds) {
+    const size_t frames = size_t(sampleRate * seconds);
+    std::vector<double> left;
+    std::vector<double> right;
+    track(bits, frames, left, right);
+
+    Store store;
+    auto start = Clock::now();
+    store.encode(left.data(), right.data(), frames);
+    double encode = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::vector<double> outLeft(Store::BlockFrames);
+    std::vector<double> outRight(Store::BlockFrames);
+    double best = 1e300;
+    double sink = 0;
+    for (int round = 0; round < rounds; round++) {
+        start = Clock::now();
+        for (size_t block = 0; block < store.blocks(); block++) {
+            store.decode(block, outLeft.data(), outRight.data());
+            sink += outLeft[block % Store::BlockFrames];
+        }
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    double perBlock = best / double(store.blocks());
+
+    double bytes = double(store.memorySize()) / double(frames);
+    printf("%4d bit %9.3f %9.3f %8.1f%% %10.0f %9.2f %9.1f\n", bits, bytes, 2. * bits / 8., 100. * bytes / 4.,
+           perBlock, perBlock / double(Store::BlockFrames), encode);
+    if (sink == 12345.) {
+        printf(" ");
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 60.;
+    int rounds = argc > 2 ? atoi(argv[2]) : 10;
+
+    printf("%8s %9s %9s %9s %10s %9s %9s\n", "track", "bytes/fr", "pcm", "of int16", "ns/block", "ns/frame", "encode ms");
+    row(16, seconds, rounds);
+    row(24, seconds, rounds);
+    return 0;
+}
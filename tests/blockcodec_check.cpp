@@ -0,0 +1,137 @@
+// Round trip of the compressed sample store. Quantised tracks of each bit depth are
+// encoded and every block decoded back, the frames must come out exactly; audio that
+// is no exact quantisation has to be refused.
+
+#include "helpers/blockcodec.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+constexpr double Pi = 3.14159265358979323846;
+
+enum class Signal {
+    Music,      // tones under noise, near mono
+    Noise,      // full scale white noise, wide residuals and escapes
+    Silence,
+    Extremes    // alternating full scale values
+};
+
+template<typename SampleType>
+struct Track {
+    std::vector<SampleType> left;
+    std::vector<SampleType> right;
+};
+
+template<typename SampleType>
+Track<SampleType> track(Signal signal, int bits, size_t frames, uint32_t seed) {
+    const double scale = double((int64_t(1) << (bits - 1)) - 1);
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    Track<SampleType> result {std::vector<SampleType>(frames), std::vector<SampleType>(frames)};
+    for (size_t i = 0; i < frames; i++) {
+        double left = 0;
+        double right = 0;
+        switch (signal) {
+        case Signal::Music: {
+            double t = double(i) / 44100.;
+            left = 0.5 * sin(2. * Pi * 110. * t) + 0.2 * sin(2. * Pi * 1760. * t) + 0.05 * uniform(generator);
+            right = 0.9 * left + 0.02 * uniform(generator);
+            break;
+        }
+        case Signal::Noise:
+            left = uniform(generator);
+            right = uniform(generator);
+            break;
+        case Signal::Silence:
+            break;
+        case Signal::Extremes:
+            left = (i & 1) ? 1. : -1.;
+            right = -left;
+            break;
+        }
+        // the same conversion SampleData makes from integer PCM
+        result.left[i] = SampleType(double(std::llrint(left * scale)) / scale);
+        result.right[i] = SampleType(double(std::llrint(right * scale)) / scale);
+    }
+    return result;
+}
+
+template<typename SampleType>
+size_t mismatches(const CompressedSamples<SampleType>& store, const Track<SampleType>& source) {
+    using Store = CompressedSamples<SampleType>;
+    std::vector<SampleType> left(Store::BlockFrames);
+    std::vector<SampleType> right(Store::BlockFrames);
+    size_t wrong = 0;
+    for (size_t block = 0; block < store.blocks(); block++) {
+        store.decode(block, left.data(), right.data());
+        for (size_t i = 0; i < Store::BlockFrames; i++) {
+            size_t frame = block * Store::BlockFrames + i;
+            bool inside = frame < source.left.size();
+            wrong += left[i] != (inside ? source.left[frame] : SampleType(0));
+            wrong += right[i] != (inside ? source.right[frame] : SampleType(0));
+        }
+    }
+    return wrong;
+}
+
+template<typename SampleType>
+bool check(const char* name, Signal signal, int bits, size_t frames) {
+    using Store = CompressedSamples<SampleType>;
+    auto source = track<SampleType>(signal, bits, frames, uint32_t(bits * 1000 + frames));
+    Store store;
+    bool encoded = store.encode(source.left.data(), source.right.data(), frames);
+    size_t wrong = encoded ? mismatches(store, source) : 0;
+
+    // the stream as a cache file hands it back
+    std::vector<uint64_t> offsets(store.offsets().begin(), store.offsets().end());
+    Store restored;
+    bool assigned = encoded && restored.assign(frames, store.scale(), store.bytes().data(), store.bytes().size(), offsets.data(), offsets.size());
+    size_t wrongRestored = assigned ? mismatches(restored, source) : 0;
+
+    bool passed = encoded && assigned && (wrong == 0) && (wrongRestored == 0) && (restored == store)
+                  && (store.blocks() == (frames + Store::BlockFrames - 1) / Store::BlockFrames);
+    printf("%-8s %-6s %2d bit %8zu frames  %6.3f bytes/frame  %s\n", name, sizeof(SampleType) == 4 ? "float" : "double", bits, frames,
+           encoded ? double(store.bytes().size()) / double(frames) : 0., passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// not a quantisation at any of the depths, encode must refuse it and stay empty
+bool checkRefused() {
+    std::vector<double> left(10000);
+    std::vector<double> right(10000);
+    for (size_t i = 0; i < left.size(); i++) {
+        left[i] = 0.5 * sin(double(i) * 0.01);
+        right[i] = left[i];
+    }
+    CompressedSamples<double> store;
+    bool passed = !store.encode(left.data(), right.data(), left.size()) && store.empty() && (store.blocks() == 0);
+    printf("%-8s %-6s %-50s %s\n", "sine", "double", "not quantised, refused", passed ? "ok" : "FAILED");
+    return passed;
+}
+
+}
+
+int main() {
+    constexpr size_t block = CompressedSamples<double>::BlockFrames;
+    bool passed = true;
+    for (int bits : {8, 16, 24}) {
+        passed = check<double>("music", Signal::Music, bits, 10 * block + 1234) && passed;
+        passed = check<double>("noise", Signal::Noise, bits, 3 * block) && passed;
+        passed = check<double>("silence", Signal::Silence, bits, block + 2) && passed;
+        passed = check<double>("extremes", Signal::Extremes, bits, block - 1) && passed;
+    }
+    passed = check<double>("music", Signal::Music, 16, 3) && passed;
+    passed = check<float>("music", Signal::Music, 16, 4 * block + 7) && passed;
+    passed = check<float>("music", Signal::Music, 24, 4 * block + 7) && passed;
+    passed = check<float>("noise", Signal::Noise, 24, 2 * block) && passed;
+    passed = checkRefused() && passed;
+    printf("%s\n", passed ? "ok" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// Cost of fastmath::sin and cos against libm, per value. The scalar rows add up one call
+// at a time as a per-frame caller does, the block rows fill a buffer in one call.
+// usage: fastmath_bench [values] [rounds]
+
+#include "helpers/fastmath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double sink = 0;
+
+// ns per value of the best of rounds, run hands back something to keep
+template<typename Run>
+double time(size_t values, int rounds, Run&& run) {
+    double best = 1e300;
+    for (int round = 0; round < rounds; round++) {
+        auto start = Clock::now();
+        sink += run();
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    return best / double(values);
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t values = argc > 1 ? size_t(atol(argv[1])) : 1 << 16;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+
+    std::mt19937_64 generator(47);
+    std::uniform_real_distribution<double> uniform(-100., 100.);
+    std::vector<double> in(values);
+    std::vector<double> out(values);
+    for (auto& value : in) {
+        value = uniform(generator);
+    }
+
+    double libmSin = time(values, rounds, [&]() {
+        double sum = 0;
+        for (double x : in) {
+            sum += std::sin(x);
+        }
+        return sum;
+    });
+    double libmCos = time(values, rounds, [&]() {
+        double sum = 0;
+        for (double x : in) {
+            sum += std::cos(x);
+        }
+        return sum;
+    });
+    double fastSin = time(values, rounds, [&]() {
+        double sum = 0;
+        for (double x : in) {
+            sum += fastmath::sin(x);
+        }
+        return sum;
+    });
+    double fastCos = time(values, rounds, [&]() {
+        double sum = 0;
+        for (double x : in) {
+            sum += fastmath::cos(x);
+        }
+        return sum;
+    });
+    double libmSinBlock = time(values, rounds, [&]() {
+        for (size_t i = 0; i < values; i++) {
+            out[i] = std::sin(in[i]);
+        }
+        return out[values / 2];
+    });
+    double libmCosBlock = time(values, rounds, [&]() {
+        for (size_t i = 0; i < values; i++) {
+            out[i] = std::cos(in[i]);
+        }
+        return out[values / 2];
+    });
+    double fastSinBlock = time(values, rounds, [&]() {
+        fastmath::sin(in.data(), out.data(), values);
+        return out[values / 2];
+    });
+    double fastCosBlock = time(values, rounds, [&]() {
+        fastmath::cos(in.data(), out.data(), values);
+        return out[values / 2];
+    });
+
+    printf("ns per value, |x| < 100\n");
+    printf("%-8s %9s %9s %9s %9s\n", "call", "std::sin", "fast sin", "std::cos", "fast cos");
+    printf("%-8s %9.2f %9.2f %9.2f %9.2f\n", "scalar", libmSin, fastSin, libmCos, fastCos);
+    printf("%-8s %9.2f %9.2f %9.2f %9.2f\n", "block", libmSinBlock, fastSinBlock, libmCosBlock, fastCosBlock);
+    if (sink == 12345.) {
+        printf(" ");
+    }
+    return 0;
+}
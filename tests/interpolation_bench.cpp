@@ -0,0 +1,123 @@
+// Cost and error of the playback interpolation kernels. Each kernel reads a stereo sine
+// at a varispeed step, one call per output frame as the sample entry does. The error
+// is everything but the ideal tone at the output position: distortion plus the images
+// and aliases the kernel lets through, in dB below the tone.
+// usage: interpolation_bench [seconds]
+
+#include "helpers/interpolation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double Pi = 3.14159265358979323846;
+constexpr double sampleRate = 44100.;
+constexpr int margin = 16;  // frames before and after the table, more than any kernel reads
+
+std::vector<double> tone(double frequency, size_t frames, double phase) {
+    std::vector<double> values(frames + 2 * margin);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = sin(2. * Pi * frequency * (double(i) - margin) / sampleRate + phase);
+    }
+    return values;
+}
+
+template<typename Kernel>
+void render(const std::vector<double>& left, const std::vector<double>& right, double step,
+            std::vector<double>& outLeft, std::vector<double>& outRight) {
+    const double* bufferLeft = left.data() + margin;
+    const double* bufferRight = right.data() + margin;
+    double position = 0;
+    for (size_t i = 0; i < outLeft.size(); i++) {
+        size_t index = size_t(position);
+        double fraction = position - double(index);
+        outLeft[i] = Kernel::interpolate(bufferLeft + index, fraction);
+        outRight[i] = Kernel::interpolate(bufferRight + index, fraction);
+        position += step;
+    }
+}
+
+// ns per stereo output frame
+template<typename Kernel>
+double cost(double step, double seconds) {
+    const size_t frames = size_t(sampleRate * seconds);
+    auto left = tone(1000., size_t(double(frames) * step) + 1, 0.);
+    auto right = tone(1500., size_t(double(frames) * step) + 1, 0.);
+    std::vector<double> outLeft(frames);
+    std::vector<double> outRight(frames);
+    auto start = Clock::now();
+    render<Kernel>(left, right, step, outLeft, outRight);
+    double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    if (outLeft[frames / 2] + outRight[frames / 2] == 12345.) {
+        printf(" ");
+    }
+    return elapsed / double(frames);
+}
+
+// error of the left channel against the ideal tone, in dB
+template<typename Kernel>
+double error(double frequency, double step) {
+    const size_t frames = 1 << 15;
+    auto left = tone(frequency, size_t(double(frames) * step) + 1, 0.);
+    auto right = tone(frequency, size_t(double(frames) * step) + 1, Pi / 2.);
+    std::vector<double> outLeft(frames);
+    std::vector<double> outRight(frames);
+    render<Kernel>(left, right, step, outLeft, outRight);
+    double residual = 0;
+    double signal = 0;
+    for (size_t i = 0; i < frames; i++) {
+        double ideal = sin(2. * Pi * frequency * double(i) * step / sampleRate);
+        residual += (outLeft[i] - ideal) * (outLeft[i] - ideal);
+        signal += ideal * ideal;
+    }
+    return 10. * log10(residual / signal + 1e-300);
+}
+
+constexpr double steps[] = {0.73, 1.19};
+constexpr double frequencies[] = {1000., 5000., 12000., 16000.};
+
+template<typename Kernel>
+void row(const char* name, double seconds) {
+    printf("%-9s", name);
+    for (double step : steps) {
+        printf(" %9.1f", cost<Kernel>(step, seconds));
+    }
+    for (double step : steps) {
+        for (double frequency : frequencies) {
+            printf(" %11.1f", error<Kernel>(frequency, step));
+        }
+    }
+    printf("\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 10.;
+    SincInterpolation::prepare();
+
+    printf("%-9s", "kernel");
+    for (double step : steps) {
+        printf("  ns x%4.2f", step);
+    }
+    for (double step : steps) {
+        for (double frequency : frequencies) {
+            printf(" %3.0fk x%4.2f", frequency / 1000., step);
+        }
+    }
+    printf("\n");
+    row<LinearInterpolation>("linear", seconds);
+    row<HermiteInterpolation>("hermite", seconds);
+    row<LagrangeInterpolation>("lagrange", seconds);
+    row<SincInterpolation>("sinc", seconds);
+    return 0;
+}
@@ -0,0 +1,56 @@
+// The delay the oversampler reports against the one it has. An impulse goes through at
+// 2x and 4x with nothing shaping it; the output must peak on latency(factor), its group
+// delay must round to it and the pair must keep unity gain.
+
+#include "helpers/halfband.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+constexpr size_t frames = 128;
+
+bool check(size_t factor) {
+    Oversampler<double> oversampler;
+    oversampler.factor(factor);
+
+    std::vector<double> left(frames);
+    std::vector<double> right(frames);
+    for (size_t i = 0; i < frames; i++) {
+        left[i] = (i == 0) ? 1. : 0.;
+        right[i] = (i == 0) ? -0.5 : 0.;
+        oversampler.process(left[i], right[i], [](double&, double&) {});
+    }
+
+    size_t peak = 0;
+    double sum = 0;
+    double moment = 0;
+    bool matched = true;
+    for (size_t i = 0; i < frames; i++) {
+        if (std::fabs(left[i]) > std::fabs(left[peak])) {
+            peak = i;
+        }
+        sum += left[i];
+        moment += double(i) * left[i];
+        matched = matched && (right[i] == -0.5 * left[i]);
+    }
+    const size_t latency = Oversampler<double>::latency(factor);
+    const double delay = moment / sum;
+    bool passed = (peak == latency) && (std::fabs(delay - double(latency)) <= 0.5) && (std::fabs(sum - 1.) < 1e-9) && matched;
+    printf("%zux  latency %2zu  peak %2zu  group delay %6.3f  gain %.9f  %s\n", factor, latency, peak, delay, sum, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+}
+
+int main() {
+    bool passed = true;
+    passed = check(2) && passed;
+    passed = check(4) && passed;
+    printf("%s\n", passed ? "ok" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+// A host may queue several points of one parameter on the same frame. The reader has to
+// take all of them on that frame, the last one being the value there, and report the
+// next point after them as the next change.
+
+#include "helpers/parameterreader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+namespace {
+
+// the points as the host hands them over, duplicates kept
+class Queue: public IParamValueQueue {
+public:
+    explicit Queue(std::vector<std::pair<int32, ParamValue>> points):
+        points_(std::move(points))
+    {}
+
+    tresult PLUGIN_API queryInterface(const TUID, void** object) override {
+        *object = nullptr;
+        return kNoInterface;
+    }
+
+    uint32 PLUGIN_API addRef() override {
+        return 1;
+    }
+
+    uint32 PLUGIN_API release() override {
+        return 1;
+    }
+
+    ParamID PLUGIN_API getParameterId() override {
+        return 0;
+    }
+
+    int32 PLUGIN_API getPointCount() override {
+        return int32(points_.size());
+    }
+
+    tresult PLUGIN_API getPoint(int32 index, int32& sampleOffset, ParamValue& value) override {
+        if ((index < 0) || (index >= int32(points_.size()))) {
+            return kResultFalse;
+        }
+        sampleOffset = points_[size_t(index)].first;
+        value = points_[size_t(index)].second;
+        return kResultTrue;
+    }
+
+    tresult PLUGIN_API addPoint(int32, ParamValue, int32&) override {
+        return kResultFalse;
+    }
+
+private:
+    std::vector<std::pair<int32, ParamValue>> points_;
+};
+
+bool expect(bool condition, const char* what) {
+    if (!condition) {
+        printf("  FAILED: %s\n", what);
+    }
+    return condition;
+}
+
+// a stepped parameter: two points on frame 10 and one on 30
+bool checkSteps() {
+    printf("steps\n");
+    Queue queue({{10, 0.2}, {10, 0.7}, {30, 0.4}});
+    ParamValue value = 0.;
+    int calls = 0;
+    ParameterReader reader([&value]() { return value; },
+                           [&value, &calls](ParamValue set) { value = set; calls++; },
+                           false);
+    reader.setQueue(&queue);
+
+    bool passed = true;
+    reader.checkOffset(0);
+    passed = expect((calls == 0) && (reader.pending() == 10), "nothing before frame 10") && passed;
+    reader.checkOffset(10);
+    passed = expect(value == 0.7, "the last point of frame 10 is the value there") && passed;
+    passed = expect(reader.pending() == 30, "the next change after frame 10 is on frame 30") && passed;
+    reader.checkOffset(30);
+    passed = expect((value == 0.4) && (calls == 3), "frame 30 applies its point") && passed;
+    passed = expect(!reader.checkOffset(31), "the queue is used up") && passed;
+    printf("  value %.2f after %d calls\n", value, calls);
+    return passed;
+}
+
+// a ramped parameter: the ramp toward frame 100 starts from the last point of frame 0
+bool checkRamp() {
+    printf("ramp\n");
+    Queue queue({{0, 0.5}, {0, 0.9}, {100, 0.1}});
+    ParamValue value = 0.;
+    ParameterReader reader([&value]() { return value; },
+                           [&value](ParamValue set) { value = set; },
+                           true);
+    reader.setQueue(&queue);
+
+    bool passed = true;
+    reader.checkOffset(0);
+    passed = expect(reader.pending() == 100, "the next change after frame 0 is on frame 100") && passed;
+    ParamValue ramp[100];
+    reader.ramp(0, 100, ramp);
+    passed = expect(std::fabs(ramp[0] - 0.9) < 1e-12, "the ramp starts at the last point of frame 0") && passed;
+    passed = expect(std::fabs(ramp[50] - 0.5) < 1e-12, "the ramp is half way on frame 50") && passed;
+    reader.checkOffset(100);
+    passed = expect(value == 0.1, "frame 100 applies its point") && passed;
+    printf("  frame 0 %.3f, 50 %.3f, 99 %.3f\n", ramp[0], ramp[50], ramp[99]);
+    return passed;
+}
+
+}
+
+int main() {
+    bool passed = true;
+    passed = checkSteps() && passed;
+    passed = checkRamp() && passed;
+    printf("%s\n", passed ? "ok" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+// The 32.32 play cursor against integer-exact arithmetic. A billion frames at speeds that
+// are no power of two must land exactly where start + n * increment says, within the
+// increment's own rounding of the real position, and come back unchanged through a cue
+// point. wrap() must bring the cursor into the loop at every step, reverse play included.
+
+#include "helpers/phasecursor.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+using namespace Steinberg::Vst;
+using Cursor = Helper::PhaseCursor;
+using Cue = Helper::CuePoint<int64_t, double>;
+
+namespace {
+
+constexpr int64_t frames = 1000000000;
+
+bool expect(bool condition, const char* what) {
+    if (!condition) {
+        printf("  FAILED: %s\n", what);
+    }
+    return condition;
+}
+
+// the same value through the cue point the sample entry hands out
+bool roundTrip(const Cursor& cursor) {
+    Cursor back(cursor.cuePoint<Cue>());
+    return back == cursor;
+}
+
+// a billion frames of free play, one add each
+bool checkDrift(double speed) {
+    const int64_t increment = Cursor::increment(speed);
+    const Cursor start(1234, 0.375);
+    Cursor cursor = start;
+    double sum = start.asDouble();
+    for (int64_t i = 0; i < frames; i++) {
+        cursor.step(increment);
+        sum += speed;
+    }
+
+    // exact: where the integer arithmetic puts it, off the real position only by the rounded increment
+    const int64_t exact = start.raw() + frames * increment;
+    const double ideal = start.asDouble() + double(frames) * speed;
+    const double bound = double(frames) * 0.5 / double(Cursor::One);
+    const double error = std::fabs((double(cursor.integerPart()) - ideal) + cursor.floatPart());
+    bool passed = expect(cursor.raw() == exact, "the cursor is start + frames * increment");
+    passed = expect(error <= bound, "within the increment's rounding of the real position") && passed;
+    passed = expect(roundTrip(cursor), "the cue point gives the cursor back") && passed;
+    printf("%-8s %9.6f  at %13lld + %.6f  off %.2e frames (bound %.2e), a double sum off %.2e\n", "drift", speed,
+           (long long)cursor.integerPart(), cursor.floatPart(), error, bound, std::fabs(sum - ideal));
+    return passed;
+}
+
+// the wrapped cursor after every step against the exact remainder
+bool checkLoop(double speed, size_t length, int64_t steps) {
+    const int64_t increment = Cursor::increment(speed);
+    const int64_t period = Cursor::span(length);
+    Cursor cursor(int64_t(length) / 3, 0.25);
+    int64_t exact = cursor.raw();
+    bool inside = true;
+    bool matches = true;
+    for (int64_t i = 0; i < steps; i++) {
+        cursor.step(increment);
+        cursor.wrap(period);
+        exact = ((exact + increment) % period + period) % period;
+        inside = inside && (cursor.raw() >= 0) && (cursor.raw() < period);
+        matches = matches && (cursor.raw() == exact);
+    }
+    bool passed = expect(inside, "the cursor stays in [0, loop)");
+    passed = expect(matches, "every step matches the exact remainder") && passed;
+    passed = expect(roundTrip(cursor), "the cue point gives the cursor back") && passed;
+    printf("%-8s %9.6f  loop %8zu frames  %lld steps  %s\n", "loop", speed, length, (long long)steps, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// single wraps right at and around the loop ends, and values several loops away
+bool checkEdges() {
+    const size_t length = 1000;
+    const int64_t period = Cursor::span(length);
+    const int64_t values[] = {0, 1, period - 1, period, period + 1, -1, -period, -period + 1, -period - 1,
+                              3 * period + period / 2, -2 * period - period / 4, 17 * period, -17 * period};
+    bool passed = true;
+    for (int64_t value : values) {
+        Cursor cursor;
+        cursor.step(value);
+        cursor.wrap(period);
+        int64_t exact = (value % period + period) % period;
+        if (cursor.raw() != exact) {
+            printf("  FAILED: %lld wraps to %lld, not %lld\n", (long long)value, (long long)cursor.raw(), (long long)exact);
+            passed = false;
+        }
+    }
+    printf("%-8s %-9s  loop %8zu frames  %s\n", "edges", "", length, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// any cursor comes back through a cue point, and through the double position while that holds 53 bits
+bool checkRoundTrip() {
+    std::mt19937_64 generator(33);
+    std::uniform_int_distribution<int64_t> anywhere(-(int64_t(1) << 62), int64_t(1) << 62);
+    std::uniform_int_distribution<int64_t> near(-(int64_t(1) << 52), int64_t(1) << 52);
+    bool cue = true;
+    bool position = true;
+    for (int i = 0; i < 1000000; i++) {
+        Cursor cursor;
+        cursor.step(anywhere(generator));
+        cue = cue && roundTrip(cursor);
+
+        Cursor close;
+        close.step(near(generator));
+        double value = close.asDouble();
+        double whole = std::floor(value);
+        position = position && (Cursor(int64_t(whole), value - whole) == close);
+    }
+    bool passed = expect(cue, "a cue point gives any cursor back");
+    passed = expect(position, "the double position gives a cursor within 2^20 frames back") && passed;
+    printf("%-8s %-9s  %s\n", "round", "trip", passed ? "ok" : "FAILED");
+    return passed;
+}
+
+}
+
+int main() {
+    bool passed = true;
+    passed = checkDrift(1.013) && passed;
+    passed = checkDrift(-0.7) && passed;
+    passed = checkDrift(2. / 3.) && passed;
+    passed = checkLoop(1.013, 44100, 100000000) && passed;
+    passed = checkLoop(-1.37, 441, 10000000) && passed;
+    passed = checkLoop(-0.5, 3, 1000000) && passed;
+    passed = checkLoop(-5.3, 2, 1000000) && passed;
+    passed = checkLoop(7.1, 3, 1000000) && passed;
+    passed = checkEdges() && passed;
+    passed = checkRoundTrip() && passed;
+    printf("%s\n", passed ? "ok" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+// Punch in and out turn on the first frame after they are scheduled. The block is cut
+// at frames 37 and 200 as the processor cuts it at pad events; the volume must hold until
+// the first and turn at each edge, and cutting it elsewhere too must give the same frames.
+// render_check drives the processor itself.
+
+#include "effects/effector.h"
+#include "effects/punch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+constexpr size_t blockFrames = 256;
+constexpr int32_t punchFrame = 37;
+constexpr int32_t releaseFrame = 200;
+constexpr double punchLevel = 0.5;
+
+struct Deck {
+    std::unique_ptr<Effector<double>> effector = makeEffector<double>(new PunchIn([]() { return punchLevel; }), new PunchOut<double>());
+    std::vector<double> left = std::vector<double>(blockFrames, 0.);
+    std::vector<double> right = std::vector<double>(blockFrames, 0.);
+    std::vector<double> speed = std::vector<double>(blockFrames, 1.);
+    std::vector<double> tempo = std::vector<double>(blockFrames, 1.);
+    std::vector<double> volume = std::vector<double>(blockFrames, 1.);
+
+    // frames from first on, after the chain ran over them
+    void run(size_t first, size_t count) {
+        std::fill(volume.begin() + first, volume.begin() + first + count, 1.);
+        EffectFrames<double> frames {left.data() + first, right.data() + first, speed.data() + first,
+                             tempo.data() + first, volume.data() + first, count};
+        effector->process(frames);
+    }
+
+    // the block in pieces of at most part frames, the set changes where the edges fall
+    void play(Effect::Type effect, size_t part) {
+        size_t first = 0;
+        while (first < blockFrames) {
+            if (first == size_t(punchFrame)) {
+                effector->schedule(effect);
+            } else if (first == size_t(releaseFrame)) {
+                effector->schedule(Effect::NoEffects);
+            }
+            size_t end = std::min(blockFrames, first + part);
+            for (int32_t frame : {punchFrame, releaseFrame}) {
+                if (size_t(frame) > first) {
+                    end = std::min(end, size_t(frame));
+                }
+            }
+            run(first, end - first);
+            first = end;
+        }
+    }
+
+    // the smoothers start closed, a few blocks bring them to rest
+    Deck() {
+        for (int i = 0; i < 8; i++) {
+            run(0, blockFrames);
+        }
+    }
+};
+
+bool expect(bool condition, const char* what) {
+    if (!condition) {
+        printf("  FAILED: %s\n", what);
+    }
+    return condition;
+}
+
+// level - where the volume goes while punched, the deck plays at 1
+bool checkEdges(const char* name, Effect::Type effect, double level) {
+    printf("%s\n", name);
+    Deck deck;
+    deck.play(effect, blockFrames);
+    const auto& v = deck.volume;
+
+    bool passed = true;
+    bool steady = true;
+    for (int32_t i = 0; i < punchFrame; i++) {
+        steady = steady && (std::fabs(v[i] - 1.) < 1e-5);
+    }
+    passed = expect(steady, "volume holds before the punch frame") && passed;
+    passed = expect(v[punchFrame] < v[punchFrame - 1] - 1e-3, "volume turns on the punch frame") && passed;
+    bool monotonic = true;
+    for (int32_t i = punchFrame + 1; i < releaseFrame; i++) {
+        monotonic = monotonic && (v[i] <= v[i - 1]);
+    }
+    passed = expect(monotonic, "volume keeps going down while punched") && passed;
+    passed = expect(std::fabs(v[releaseFrame - 1] - level) < 0.01, "volume reaches the punch level") && passed;
+    passed = expect(v[releaseFrame] > v[releaseFrame - 1] + 1e-3, "volume turns back on the release frame") && passed;
+    printf("  frame %d %.4f, %d %.4f, %d %.4f, %d %.4f\n", punchFrame - 1, v[punchFrame - 1], punchFrame, v[punchFrame],
+           releaseFrame - 1, v[releaseFrame - 1], releaseFrame, v[releaseFrame]);
+    return passed;
+}
+
+// the same changes with the block also cut every 64 frames, the frames must not change
+bool checkSplit() {
+    printf("split blocks\n");
+    Deck whole;
+    whole.play(Effect::PunchOut, blockFrames);
+
+    Deck split;
+    split.play(Effect::PunchOut, blockFrames / 4);
+    return expect(whole.volume == split.volume, "a split block gives the same frames");
+}
+
+}
+
+int main() {
+    bool passed = true;
+    passed = checkEdges("punch out", Effect::PunchOut, 0.) && passed;
+    passed = checkEdges("punch in", Effect::PunchIn, punchLevel) && passed;
+    passed = checkSplit() && passed;
+    printf("%s\n", passed ? "ok" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+// Pad events switch the effects on the frame they come on. A punch out pad is pressed at
+// frame 37 of a host block and let go at frame 200; the output must match a deck that got
+// the same events at the start of blocks cut there, and a deck that got none up to frame 37.
+
+#include "vinylprocessor.h"
+#include "helpers/padentry.h"
+#include "pluginterfaces/base/smartpointer.h"
+#include "public.sdk/source/vst/hosting/eventlist.h"
+#include "public.sdk/source/vst/hosting/hostclasses.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+namespace {
+
+constexpr double Pi = 3.14159265358979323846;
+constexpr double sampleRate = 44100.;
+constexpr int32 blockFrames = 256;
+constexpr int32 pressFrame = 37;
+constexpr int32 releaseFrame = 200;
+constexpr int16 padNote = 0x3d;         // the first pad's note
+constexpr double timecodeFrequency = 986.;
+
+// two seconds of a stereo tone as 16 bit PCM
+bool writeTone(const std::string& fileName) {
+    const uint32_t frames = uint32_t(2 * sampleRate);
+    const uint32_t bytes = frames * 4;
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    auto word = [file](uint32_t value, int size) { fwrite(&value, size, 1, file); };
+    fwrite("RIFF", 4, 1, file);
+    word(36 + bytes, 4);
+    fwrite("WAVEfmt ", 8, 1, file);
+    word(16, 4);
+    word(1, 2);
+    word(2, 2);
+    word(uint32_t(sampleRate), 4);
+    word(uint32_t(sampleRate) * 4, 4);
+    word(4, 2);
+    word(16, 2);
+    fwrite("data", 4, 1, file);
+    word(bytes, 4);
+    for (uint32_t i = 0; i < frames; i++) {
+        double t = double(i) / sampleRate;
+        word(uint16_t(int16_t(12000. * sin(2. * Pi * 440. * t))), 2);
+        word(uint16_t(int16_t(12000. * sin(2. * Pi * 660. * t))), 2);
+    }
+    return fclose(file) == 0;
+}
+
+std::u16string wide(const std::string& text) {
+    return std::u16string(text.begin(), text.end());
+}
+
+class Deck {
+public:
+    explicit Deck(const std::string& fileName)
+        : processor_(owned(new AVinyl()))
+    {
+        processor_->initialize(nullptr);
+        ProcessSetup setup {kRealtime, kSample64, blockFrames, sampleRate};
+        processor_->setupProcessing(setup);
+        processor_->setActive(true);
+
+        // the first pad punches out while held
+        IPtr<HostMessage> pad = owned(new HostMessage());
+        pad->setMessageID("setPad");
+        pad->getAttributes()->setInt("PadNumber", 1);
+        pad->getAttributes()->setInt("PadType", PadEntry::KickPad);
+        pad->getAttributes()->setInt("PadTag", Effect::PunchOut);
+        processor_->notify(pad);
+
+        IPtr<HostMessage> load = owned(new HostMessage());
+        load->setMessageID("loadNewEntry");
+        load->getAttributes()->setString("File", wide(fileName).c_str());
+        load->getAttributes()->setString("Sample", u"tone");
+        processor_->notify(load);
+    }
+
+    ~Deck() {
+        processor_->setActive(false);
+        processor_->terminate();
+    }
+
+    // silence until the sample is in, the deck does not move meanwhile
+    bool load() {
+        for (int i = 0; i < 5000; i++) {
+            silent_ = true;
+            play(blockFrames);
+            processor_->onTimer(nullptr);
+            if (processor_->memoryUsage().resident > 0) {
+                silent_ = false;
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    void press(int32 offset, bool down) {
+        Event event {};
+        event.sampleOffset = offset;
+        event.type = down ? Event::kNoteOnEvent : Event::kNoteOffEvent;
+        if (down) {
+            event.noteOn.pitch = padNote;
+            event.noteOn.velocity = 1.f;
+        } else {
+            event.noteOff.pitch = padNote;
+        }
+        events_.addEvent(event);
+    }
+
+    // a host block of frames of timecode, the output is kept
+    void play(int32 frames) {
+        std::vector<double> inLeft(frames);
+        std::vector<double> inRight(frames);
+        for (int32 i = 0; i < frames; i++) {
+            inLeft[i] = silent_ ? 0. : 0.5 * sin(phase_);
+            inRight[i] = silent_ ? 0. : 0.5 * cos(phase_);
+            phase_ += silent_ ? 0. : 2. * Pi * timecodeFrequency / sampleRate;
+        }
+        std::vector<double> outLeft(frames);
+        std::vector<double> outRight(frames);
+        double* in[2] = {inLeft.data(), inRight.data()};
+        double* out[2] = {outLeft.data(), outRight.data()};
+
+        AudioBusBuffers input {};
+        input.numChannels = 2;
+        input.channelBuffers64 = in;
+        AudioBusBuffers output {};
+        output.numChannels = 2;
+        output.channelBuffers64 = out;
+
+        ProcessData data {};
+        data.processMode = kRealtime;
+        data.symbolicSampleSize = kSample64;
+        data.numSamples = frames;
+        data.numInputs = 1;
+        data.numOutputs = 1;
+        data.inputs = &input;
+        data.outputs = &output;
+        data.inputEvents = &events_;
+        processor_->process(data);
+        events_.clear();
+
+        if (!silent_) {
+            left.insert(left.end(), outLeft.begin(), outLeft.end());
+        }
+    }
+
+    std::vector<double> left;
+
+private:
+    IPtr<AVinyl> processor_;
+    EventList events_;
+    double phase_ {0};
+    bool silent_ {true};
+};
+
+bool expect(bool condition, const char* what) {
+    if (!condition) {
+        printf("  FAILED: %s\n", what);
+    }
+    return condition;
+}
+
+// the first frame from first on where the two differ, the end when they don't
+size_t firstDifference(const std::vector<double>& a, const std::vector<double>& b, size_t first) {
+    size_t end = std::min(a.size(), b.size());
+    for (size_t i = first; i < end; i++) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return end;
+}
+
+}
+
+int main() {
+    std::string fileName = (std::filesystem::temp_directory_path() / "vinyl_render_check.wav").string();
+    if (!writeTone(fileName)) {
+        printf("cannot write %s\nFAILED\n", fileName.c_str());
+        return 1;
+    }
+
+    bool passed = true;
+    {
+        Deck events(fileName);
+        Deck cut(fileName);
+        Deck plain(fileName);
+        passed = expect(events.load() && cut.load() && plain.load(), "the sample loads") && passed;
+
+        // the timecode settles and the deck plays for a while first
+        constexpr int warmBlocks = 100;
+        for (int i = 0; i < warmBlocks; i++) {
+            events.play(blockFrames);
+            cut.play(blockFrames);
+            plain.play(blockFrames);
+        }
+
+        events.press(pressFrame, true);
+        events.press(releaseFrame, false);
+        events.play(blockFrames);
+
+        cut.play(pressFrame);
+        cut.press(0, true);
+        cut.play(releaseFrame - pressFrame);
+        cut.press(0, false);
+        cut.play(blockFrames - releaseFrame);
+
+        plain.play(blockFrames);
+
+        // a few blocks more, the release ramps back up after the block
+        for (int i = 0; i < 4; i++) {
+            events.play(blockFrames);
+            cut.play(blockFrames);
+            plain.play(blockFrames);
+        }
+
+        const size_t block = size_t(warmBlocks * blockFrames);
+        double level = 0;
+        for (size_t i = block - blockFrames; i < block; i++) {
+            level = std::max(level, std::fabs(plain.left[i]));
+        }
+        passed = expect(level > 0.01, "the deck plays") && passed;
+        size_t punched = firstDifference(events.left, plain.left, 0);
+        passed = expect(punched == block + pressFrame, "the punch starts on the frame of its event") && passed;
+        passed = expect(firstDifference(events.left, cut.left, 0) == events.left.size(), "the same as events at block starts") && passed;
+        printf("  level %.4f, punch from frame %zd of the block\n", level, ptrdiff_t(punched) - ptrdiff_t(block));
+    }
+    std::filesystem::remove(fileName);
+
+    printf("%s\n", passed ? "ok" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+// Passband flatness and stopband rejection of the load time rate converter.
+// Sine sweeps through Resampler, the level of the tone (passband) or of its alias
+// or image (stopband) is read back from the output.
+
+#include "helpers/resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+constexpr double Pi = 3.14159265358979323846;
+constexpr double passbandEdge = 20000.;
+constexpr double maximumRipple = 0.05;      // dB
+constexpr double minimumRejection = 80.;    // dB
+
+// Hann weighted correlation over the middle half, away from the edge transients
+double level(const std::vector<double>& signal, double frequency, double rate) {
+    size_t first = signal.size() / 4;
+    size_t count = signal.size() / 2;
+    double re = 0;
+    double im = 0;
+    double weight = 0;
+    for (size_t i = 0; i < count; i++) {
+        double window = 0.5 - 0.5 * cos(2. * Pi * double(i) / double(count));
+        double phase = 2. * Pi * frequency * double(first + i) / rate;
+        re += window * signal[first + i] * cos(phase);
+        im += window * signal[first + i] * sin(phase);
+        weight += window;
+    }
+    return 20. * log10(2. * sqrt(re * re + im * im) / weight + 1e-300);
+}
+
+bool check(size_t from, size_t to) {
+    Resampler<double> resampler(from, to);
+    double ripple = 0;
+    double rejection = 1e9;
+    double nyquist = 0.5 * double(std::min(from, to));
+    std::vector<double> input(from / 2);
+    std::vector<double> output;
+    // the sweep is dense around the band edges
+    for (double frequency = 50.; frequency < 0.5 * double(from); frequency += (frequency < passbandEdge) || (frequency > 26000.) ? 500. : 50.) {
+        for (size_t i = 0; i < input.size(); i++) {
+            input[i] = sin(2. * Pi * frequency * double(i) / double(from));
+        }
+        resampler.process(input.data(), input.size(), output);
+        if (frequency <= passbandEdge) {
+            ripple = std::max(ripple, fabs(level(output, frequency, double(to))));
+        }
+        // decimating, what is above the output Nyquist folds down into the output;
+        // interpolating, the input's image above its Nyquist must not come through
+        double folded = from > to ? fabs(frequency - double(to) * floor(frequency / double(to) + 0.5))
+                                  : double(from) - frequency;
+        bool stopband = from > to ? frequency >= nyquist : folded < 0.5 * double(to);
+        if (stopband) {
+            rejection = std::min(rejection, -level(output, folded, double(to)));
+        }
+    }
+    bool passed = (ripple <= maximumRipple) && (rejection >= minimumRejection);
+    printf("%6zu -> %6zu  ripple %.4f dB  rejection %.1f dB  %s\n", from, to, ripple, rejection, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+}
+
+int main() {
+    bool passed = true;
+    passed = check(48000, 44100) && passed;
+    passed = check(44100, 48000) && passed;
+    passed = check(96000, 44100) && passed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Time to restore a saved state of many slots against the number of loader threads.
+// Each count runs cold (empty disk cache, every file decoded) and warm (the cache
+// written by the cold run). usage: restore_bench [files] [seconds per file]
+
+#include "helpers/sampleloader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+constexpr uint32_t fileRate = 44100;
+
+void put16(FILE* file, uint16_t value) {
+    fwrite(&value, 2, 1, file);
+}
+
+void put32(FILE* file, uint32_t value) {
+    fwrite(&value, 4, 1, file);
+}
+
+// 16 bit stereo noise with a different seed each, so the pool shares nothing
+bool writeWav(const std::filesystem::path& path, size_t frames, unsigned seed) {
+    FILE* file = fopen(path.string().c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    uint32_t dataBytes = uint32_t(frames * 4);
+    fwrite("RIFF", 1, 4, file);
+    put32(file, 36 + dataBytes);
+    fwrite("WAVEfmt ", 1, 8, file);
+    put32(file, 16);
+    put16(file, 1);
+    put16(file, 2);
+    put32(file, fileRate);
+    put32(file, fileRate * 4);
+    put16(file, 4);
+    put16(file, 16);
+    fwrite("data", 1, 4, file);
+    put32(file, dataBytes);
+
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> sample(-8000, 8000);
+    std::vector<int16_t> frame(2 * 4096);
+    for (size_t done = 0; done < frames; done += 4096) {
+        size_t count = std::min<size_t>(4096, frames - done);
+        for (size_t i = 0; i < 2 * count; i++) {
+            frame[i] = int16_t(sample(random));
+        }
+        fwrite(frame.data(), 2, 2 * count, file);
+    }
+    return fclose(file) == 0;
+}
+
+double restore(const std::vector<std::string>& files, size_t threads) {
+    SampleLoader<double> loader;
+    loader.start(threads);
+    loader.beginBatch(files.size());
+    for (size_t index = 0; index < files.size(); index++) {
+        SampleLoader<double>::Ticket ticket{index, index + 1, index + 1};
+        loader.load(ticket, files[index].c_str(), files[index].c_str(), SampleLoader<double>::Background, std::nullopt, true);
+    }
+
+    // the audio thread's side: take what is ready, hand it back to be freed
+    size_t fetched = 0;
+    while ((fetched < files.size()) || (loader.batchTime().count() == 0)) {
+        SampleLoader<double>::Loaded loaded;
+        while (loader.fetch(loaded)) {
+            fetched++;
+            loader.retire(std::move(loaded.entry));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(loader.batchTime()).count();
+    loader.stop();
+    return elapsed;
+}
+
+void useCache(const std::filesystem::path& directory) {
+#ifdef _WIN32
+    _putenv_s("LOCALAPPDATA", directory.string().c_str());
+#else
+    setenv("XDG_CACHE_HOME", directory.string().c_str(), 1);
+    setenv("HOME", directory.string().c_str(), 1);
+#endif
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? size_t(atoi(argv[1])) : 32;
+    double seconds = argc > 2 ? atof(argv[2]) : 20.;
+
+    auto root = std::filesystem::temp_directory_path() / "vinyl_restore_bench";
+    auto cache = root / "cache";
+    std::filesystem::create_directories(root);
+    useCache(cache);
+
+    std::vector<std::string> files;
+    for (size_t i = 0; i < count; i++) {
+        auto path = root / ("slot" + std::to_string(i) + ".wav");
+        if (!writeWav(path, size_t(seconds * fileRate), unsigned(i + 1))) {
+            fprintf(stderr, "can not write %s\n", path.string().c_str());
+            return 1;
+        }
+        files.push_back(path.string());
+    }
+
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for (size_t threads = 1; threads < cores; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(cores);
+
+    printf("%zu files of %.0f s, %zu cores\n", count, seconds, cores);
+    printf("threads   cold ms  speedup   warm ms  speedup\n");
+    double coldBase = 0.;
+    double warmBase = 0.;
+    for (size_t threads : counts) {
+        std::error_code error;
+        std::filesystem::remove_all(cache, error);
+        double cold = restore(files, threads);
+        double warm = restore(files, threads);
+        if (threads == 1) {
+            coldBase = cold;
+            warmBase = warm;
+        }
+        printf("%7zu %9.1f %8.2f %9.1f %8.2f\n", threads, cold, coldBase / cold, warm, warmBase / warm);
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    return 0;
+}
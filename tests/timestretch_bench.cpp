@@ -0,0 +1,130 @@
+// Cost of the key lock engine per output second and of the sample calls that synthesize
+// a hop, on average. Right after a reset the engine also has to get its overlap going,
+// the reset column is the average first call after one.
+// usage: timestretch_bench [seconds]
+
+#include "helpers/timestretch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Steinberg::Vst;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// a looped second of noise over two tones, read with linear interpolation
+class Source {
+public:
+    explicit Source(double sampleRate)
+        : left_(size_t(sampleRate))
+        , right_(size_t(sampleRate))
+    {
+        std::mt19937 generator(38);
+        std::uniform_real_distribution<double> noise(-0.1, 0.1);
+        for (size_t i = 0; i < left_.size(); i++) {
+            double t = double(i) / sampleRate;
+            left_[i] = 0.4 * sin(2. * 3.14159265358979 * 220. * t) + noise(generator);
+            right_[i] = 0.4 * sin(2. * 3.14159265358979 * 330. * t) + noise(generator);
+        }
+    }
+
+    // nothing is kept between reads
+    struct Voice {
+    };
+
+    void render(Voice&, double position, double step, size_t count, double* left, double* right) const {
+        for (size_t i = 0; i < count; i++) {
+            double at = normalizePosition(position + double(i) * step);
+            size_t index = size_t(at);
+            double fraction = at - double(index);
+            size_t next = (index + 1) % left_.size();
+            left[i] = left_[index] + (left_[next] - left_[index]) * fraction;
+            right[i] = right_[index] + (right_[next] - right_[index]) * fraction;
+        }
+    }
+
+    double normalizePosition(double position) const {
+        double size = double(left_.size());
+        position = std::fmod(position, size);
+        return position < 0 ? position + size : position;
+    }
+
+private:
+    std::vector<double> left_;
+    std::vector<double> right_;
+};
+
+struct Result {
+    double perSecond;   // ms of work per second of output
+    double hop;         // us, a call that synthesizes a hop in steady play
+    double reset;       // us, the first call after a reset
+};
+
+Result measure(StretchMode mode, double sampleRate, double seconds) {
+    Source source(sampleRate);
+    Source::Voice voice;
+    TimeStretch<double> stretch(sampleRate, mode);
+    const size_t frames = size_t(sampleRate * seconds);
+    const double step = 0.8;
+    const double pitch = 1.0;
+    double left = 0;
+    double right = 0;
+    double sink = 0;
+
+    Result result {0, 0, 0};
+    stretch.reset(0);
+    size_t hops = 0;
+    auto begin = Clock::now();
+    for (size_t i = 0; i < frames; i++) {
+        auto start = Clock::now();
+        stretch.process(source, voice, step, pitch, left, right);
+        // every hop-th call synthesizes, the first one after the reset is left out
+        if ((i > 0) && (i % stretch.hop() == 0)) {
+            result.hop += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            hops++;
+        }
+        sink += left + right;
+    }
+    result.perSecond = std::chrono::duration<double, std::milli>(Clock::now() - begin).count() / seconds;
+    result.hop /= double(std::max(hops, size_t(1)));
+
+    // the first call after a reset is what a seek or engaging the lock costs
+    constexpr int resets = 32;
+    for (int i = 0; i < resets; i++) {
+        stretch.reset(double(i) * 1000.);
+        auto start = Clock::now();
+        stretch.process(source, voice, step, pitch, left, right);
+        result.reset += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        for (size_t j = 1; j < 4 * stretch.hop(); j++) {
+            stretch.process(source, voice, step, pitch, left, right);
+        }
+        sink += left + right;
+    }
+    result.reset /= resets;
+    if (sink == 12345.) {
+        printf(" ");
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5.;
+    printf("%-13s %7s %14s %11s %13s\n", "mode", "rate", "ms per second", "hop call us", "reset call us");
+    for (auto mode : {StretchMode::Wsola, StretchMode::PhaseVocoder}) {
+        for (double rate : {44100., 96000.}) {
+            Result result = measure(mode, rate, seconds);
+            printf("%-13s %7.0f %14.2f %11.1f %13.1f\n", mode == StretchMode::Wsola ? "wsola" : "phase vocoder",
+                   rate, result.perSecond, result.hop, result.reset);
+        }
+    }
+    return 0;
+}